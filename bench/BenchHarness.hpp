@@ -0,0 +1,148 @@
+#pragma once
+
+// Shared timing, result and JSON helpers for rtm3d_bench.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <ostream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rtm3d::bench {
+
+struct BenchOptions {
+  std::vector<std::size_t> sizes = {32, 64, 96};
+  std::vector<std::size_t> threads = {1};
+  double min_time = 0.2;     // seconds spent per measurement
+  std::size_t min_reps = 3;
+  std::size_t e2e_nt = 100;
+  float tolerance = 0.05f;   // propagator trace error
+};
+
+struct BenchResult {
+  std::string suite;        // kernels | e2e | propagators
+  std::string name;
+  std::string params;       // e.g. "n=64 threads=2"
+  std::string found{};      // parameters the run settled on, e.g. "h=10"; reported, not part of key()
+  double seconds{};         // median seconds per call
+  double points{};          // grid points (or values) processed per call
+  double bytes{};           // compulsory memory / file traffic per call
+  double error = -1.0;      // relative error against the reference, -1 when not checked
+  bool passed = true;
+
+  std::string key() const { return suite + "/" + name + "/" + params; }
+};
+
+// Median wall time of fn() over at least min_reps calls and min_time seconds.
+template <typename Fn>
+double median_seconds(const BenchOptions& opts, Fn&& fn) {
+  std::vector<double> samples;
+  double total = 0.0;
+  while (samples.size() < opts.min_reps || total < opts.min_time) {
+    const auto t0 = std::chrono::steady_clock::now();
+    fn();
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    samples.push_back(s);
+    total += s;
+  }
+  std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(samples.size() / 2), samples.end());
+  return samples[samples.size() / 2];
+}
+
+inline double per_second(double amount, double seconds) { return seconds > 0.0 ? amount / seconds : 0.0; }
+
+// Largest |a - ref| relative to the largest |ref|.
+template <typename A, typename B>
+double max_relative_error(const A& a, const B& ref) {
+  double diff = 0.0, scale = 1e-30;
+  for (std::size_t i = 0; i < ref.size(); ++i) {
+    diff = std::max(diff, std::abs(static_cast<double>(a[i]) - static_cast<double>(ref[i])));
+    scale = std::max(scale, std::abs(static_cast<double>(ref[i])));
+  }
+  return diff / scale;
+}
+
+struct Regression {
+  std::string key;
+  double baseline_seconds{};
+  double seconds{};
+};
+
+// Reads the "key"/"seconds" pairs of a previous rtm3d_bench report.
+inline std::map<std::string, double> load_baseline(const std::string& path) {
+  std::ifstream f(path);
+  if (!f) throw std::runtime_error("cannot open baseline: " + path);
+  const std::string s((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  const std::regex rx("\\{\"key\": \"([^\"]+)\"[^}]*?\"seconds\": ([-+0-9.eE]+)");
+  std::map<std::string, double> out;
+  for (auto it = std::sregex_iterator(s.begin(), s.end(), rx); it != std::sregex_iterator(); ++it) {
+    out[(*it)[1].str()] = std::stod((*it)[2].str());
+  }
+  return out;
+}
+
+inline std::vector<Regression> compare_to_baseline(const std::vector<BenchResult>& results,
+                                                   const std::map<std::string, double>& baseline,
+                                                   double tolerance) {
+  std::vector<Regression> out;
+  for (const auto& r : results) {
+    const auto it = baseline.find(r.key());
+    if (it != baseline.end() && r.seconds > it->second * (1.0 + tolerance)) {
+      out.push_back({r.key(), it->second, r.seconds});
+    }
+  }
+  return out;
+}
+
+inline void write_report_json(std::ostream& os, const std::vector<BenchResult>& results,
+                              const std::string& baseline_path, double tolerance,
+                              const std::vector<Regression>& regressions) {
+  os << "{\n  \"results\": [\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    os << "    {\"key\": \"" << r.key() << "\", \"suite\": \"" << r.suite << "\", \"name\": \"" << r.name
+       << "\", \"params\": \"" << r.params << (r.found.empty() ? "" : " ") << r.found
+       << "\", \"seconds\": " << r.seconds
+       << ", \"mpoints_per_second\": " << per_second(r.points, r.seconds) * 1e-6
+       << ", \"gb_per_second\": " << per_second(r.bytes, r.seconds) * 1e-9 << ", \"error\": " << r.error
+       << ", \"passed\": " << (r.passed ? "true" : "false") << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  os << "  ]";
+  if (!baseline_path.empty()) {
+    os << ",\n  \"baseline\": {\"path\": \"" << baseline_path << "\", \"tolerance\": " << tolerance
+       << ", \"regressions\": [";
+    for (std::size_t i = 0; i < regressions.size(); ++i) {
+      const auto& g = regressions[i];
+      os << (i ? ", " : "") << "{\"key\": \"" << g.key << "\", \"baseline_seconds\": " << g.baseline_seconds
+         << ", \"seconds\": " << g.seconds << "}";
+    }
+    os << "]}";
+  }
+  os << "\n}\n";
+}
+
+inline std::string params(std::initializer_list<std::pair<const char*, double>> kv) {
+  std::ostringstream s;
+  bool first = true;
+  for (const auto& [k, v] : kv) {
+    s << (first ? "" : " ") << k << "=" << v;
+    first = false;
+  }
+  return s.str();
+}
+
+void run_kernel_benchmarks(const BenchOptions& opts, std::vector<BenchResult>& out);
+void run_end_to_end_benchmarks(const BenchOptions& opts, std::vector<BenchResult>& out);
+void run_propagator_benchmarks(const BenchOptions& opts, std::vector<BenchResult>& out);
+
+}  // namespace rtm3d::bench
@@ -0,0 +1,55 @@
+// End-to-end single-shot RTM over a sweep of grid sizes and kernel thread counts. Each threaded
+// image is checked against the single-threaded image of the same grid.
+
+#include "BenchHarness.hpp"
+#include "rtm3d/rtm/RunPlanner.hpp"
+
+namespace rtm3d::bench {
+namespace {
+
+constexpr double kThreadedTolerance = 1e-6;  // thread splits must not change the image
+
+GridModel2D layered_model(std::size_t n) {
+  GridModel2D m{.nx = n, .nz = n, .dx = 10.0f, .dz = 10.0f, .values = std::vector<float>(n * n)};
+  for (std::size_t iz = 0; iz < n; ++iz) {
+    for (std::size_t ix = 0; ix < n; ++ix) m.values[iz * n + ix] = iz < n / 2 ? 1800.0f : 2600.0f;
+  }
+  return m;
+}
+
+}  // namespace
+
+void run_end_to_end_benchmarks(const BenchOptions& opts, std::vector<BenchResult>& out) {
+  for (const std::size_t n : opts.sizes) {
+    const auto model = layered_model(n);
+    RtmConfig cfg;
+    cfg.ny = std::max<std::size_t>(4, n / 2);
+    cfg.dy = 10.0f;
+    cfg.nt = opts.e2e_nt;
+    cfg.dt = 0.5f * max_stable_dt(cfg.propagator, 2600.0f, 10.0f, 10.0f, 10.0f);
+    cfg.pml = std::max<std::size_t>(2, n / 8);
+    cfg.snapshot_strategy = SnapshotStrategy::kFull;
+    const double updates = 2.0 * static_cast<double>(n * cfg.ny * n) * static_cast<double>(cfg.nt);
+
+    std::vector<float> reference;
+    for (const std::size_t threads : opts.threads) {
+      cfg.threads = threads;
+      MigrationResult result;
+      BenchResult r{.suite = "e2e", .name = "single_shot",
+                    .params = params({{"n", double(n)}, {"ny", double(cfg.ny)}, {"nt", double(cfg.nt)},
+                                      {"threads", double(threads)}})};
+      r.seconds = median_seconds({.min_time = 0.0, .min_reps = 1}, [&] { result = run_single_shot_rtm(model, cfg); });
+      r.points = updates;
+      r.bytes = updates * 5.0 * sizeof(float);
+      if (reference.empty()) {
+        reference = result.inline_xz;
+      } else {
+        r.error = max_relative_error(result.inline_xz, reference);
+        r.passed = r.error <= kThreadedTolerance;
+      }
+      out.push_back(r);
+    }
+  }
+}
+
+}  // namespace rtm3d::bench
@@ -0,0 +1,228 @@
+// Microbenchmarks of the per-step kernels, the JSON loaders and the image writers. The stencil is
+// checked against a double-precision scalar reference so a faster kernel cannot silently drift.
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <tuple>
+
+#include "BenchHarness.hpp"
+#include "rtm/Boundary.hpp"
+#include "rtm/Geometry.hpp"
+#include "rtm/Imaging.hpp"
+#include "rtm/Parallel.hpp"
+#include "rtm/Propagation.hpp"
+#include "rtm/Wavefields.hpp"
+#include "rtm3d/io/ArrayModelLoader.hpp"
+#include "rtm3d/io/ImageIO.hpp"
+
+namespace rtm3d::bench {
+namespace {
+
+constexpr double kStencilTolerance = 1e-5;  // float vs double rounding on O(1) fields
+constexpr double kStepBytesPerPoint = 5.0 * sizeof(float);
+// 16-bit storage: error is the output rounding, relative to the field peak (2^-11 / 2^-8 mantissas).
+constexpr double kFp16StencilTolerance = 2e-3;
+constexpr double kBf16StencilTolerance = 1.6e-2;
+constexpr double kStep16BytesPerPoint = 5.0 * sizeof(std::uint16_t);
+constexpr std::size_t kReceiverSteps = 1000;
+constexpr std::size_t kBenchTileY = 8;  // representative y-tile; --autotune searches the rest
+
+std::vector<float> random_field(std::size_t n, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+  std::vector<float> v(n);
+  for (auto& x : v) x = u(rng);
+  return v;
+}
+
+// Direct transcription of nxt = (2 cur - prev + v^2 dt^2 lap(cur)) * damp in double precision.
+std::vector<double> reference_step(const Volume3D& vel, const std::vector<float>& damp, double dt, double h,
+                                   const std::vector<float>& prev, const std::vector<float>& cur) {
+  std::vector<double> nxt(vel.size(), 0.0);
+  for (std::size_t iz = 1; iz + 1 < vel.nz(); ++iz) {
+    for (std::size_t iy = 1; iy + 1 < vel.ny(); ++iy) {
+      for (std::size_t ix = 1; ix + 1 < vel.nx(); ++ix) {
+        const auto i = vel.index(ix, iy, iz);
+        const double c = cur[i];
+        const double lap = (cur[vel.index(ix + 1, iy, iz)] + cur[vel.index(ix - 1, iy, iz)] +
+                            cur[vel.index(ix, iy + 1, iz)] + cur[vel.index(ix, iy - 1, iz)] +
+                            cur[vel.index(ix, iy, iz + 1)] + cur[vel.index(ix, iy, iz - 1)] - 6.0 * c) /
+                           (h * h);
+        const double v = vel.raw()[i];
+        nxt[i] = (2.0 * c - prev[i] + v * v * dt * dt * lap) * damp[i];
+      }
+    }
+  }
+  return nxt;
+}
+
+void bench_stencil(const BenchOptions& opts, std::size_t n, std::vector<BenchResult>& out) {
+  const float h = 10.0f;
+  const float dt = 0.001f;
+  Volume3D vel(n, n, n, 2500.0f);
+  const auto damp = rtm_internal::make_damp(n, n, n, std::max<std::size_t>(2, n / 8));
+  const auto prev = random_field(vel.size(), 1);
+  const auto cur = random_field(vel.size(), 2);
+  std::vector<float> nxt(vel.size(), 0.0f);
+  const auto ref = reference_step(vel, damp, dt, h, prev, cur);
+  const double points = static_cast<double>(vel.size());
+
+  BenchResult r{.suite = "kernels", .name = "step_fd3d", .params = params({{"n", double(n)}})};
+  r.seconds = median_seconds(opts, [&] { rtm_internal::step_fd3d(vel, damp, dt, h, h, h, prev, cur, nxt); });
+  r.points = points;
+  r.bytes = points * kStepBytesPerPoint;
+  r.error = max_relative_error(nxt, ref);
+  r.passed = r.error <= kStencilTolerance;
+  out.push_back(r);
+
+  const FdKernelTuning tiled{FdKernelTuning::LoopOrder::kYzx, kBenchTileY, 0};
+  for (const std::size_t threads : opts.threads) {
+    rtm_internal::WorkerPool pool(threads);
+    for (const auto& [name, tuning] : {std::pair{"fd_propagator", FdKernelTuning{}}, std::pair{"fd_propagator_yzx", tiled}}) {
+      rtm_internal::FdPropagator prop(vel, damp, dt, h, h, h, pool, tuning);
+      BenchResult p{.suite = "kernels", .name = name,
+                    .params = params({{"n", double(n)}, {"threads", double(pool.size())}})};
+      p.seconds = median_seconds(opts, [&] { prop.step(prev, cur, nxt); });
+      p.points = points;
+      p.bytes = points * kStepBytesPerPoint;
+      p.error = max_relative_error(nxt, ref);
+      p.passed = p.error <= kStencilTolerance;
+      out.push_back(p);
+    }
+
+    rtm_internal::FdPropagator prop(vel, damp, dt, h, h, h, pool);
+    for (const auto& [name, precision, tolerance] :
+         {std::tuple{"fd_fp16", WavefieldPrecision::kFloat16, kFp16StencilTolerance},
+          std::tuple{"fd_bf16", WavefieldPrecision::kBFloat16, kBf16StencilTolerance}}) {
+      RtmConfig cfg;
+      cfg.dt = dt;
+      cfg.dy = h;
+      cfg.precision = precision;
+      const auto fields = rtm_internal::make_wavefields(cfg, prop, vel, damp, h, h, pool);
+      fields->assign(prev, cur);
+      fields->step();
+      BenchResult p{.suite = "kernels", .name = name,
+                    .params = params({{"n", double(n)}, {"threads", double(pool.size())}})};
+      p.error = max_relative_error(fields->current(), ref);
+      p.passed = p.error <= tolerance;
+      // Later repetitions keep stepping the evolving fields; the cost per step is the same.
+      p.seconds = median_seconds(opts, [&] { fields->step(); });
+      p.points = points;
+      p.bytes = points * kStep16BytesPerPoint;
+      out.push_back(p);
+    }
+  }
+}
+
+void bench_grid_kernels(const BenchOptions& opts, std::size_t n, std::vector<BenchResult>& out) {
+  const double points = static_cast<double>(n * n * n);
+  const auto p = params({{"n", double(n)}});
+
+  BenchResult damp{.suite = "kernels", .name = "make_damp", .params = p};
+  damp.seconds = median_seconds(opts, [&] { (void)rtm_internal::make_damp(n, n, n, std::max<std::size_t>(2, n / 8)); });
+  damp.points = points;
+  damp.bytes = points * sizeof(float);
+  out.push_back(damp);
+
+  const auto src = random_field(n * n * n, 3);
+  const auto rec = random_field(n * n * n, 4);
+  std::vector<float> image(n * n * n, 0.0f);
+  BenchResult xc{.suite = "kernels", .name = "cross_correlation", .params = p};
+  xc.seconds = median_seconds(opts, [&] { rtm_internal::accumulate_cross_correlation_image(src.data(), rec, image); });
+  xc.points = points;
+  xc.bytes = points * 4.0 * sizeof(float);
+  std::vector<float> once(n * n * n, 0.0f);
+  rtm_internal::accumulate_cross_correlation_image(src.data(), rec, once);
+  std::vector<double> ref(once.size());
+  for (std::size_t i = 0; i < ref.size(); ++i) ref[i] = static_cast<double>(src[i]) * rec[i];
+  xc.error = max_relative_error(once, ref);
+  xc.passed = xc.error <= kStencilTolerance;
+  out.push_back(xc);
+
+  const Volume3D vel(n, n, n, 2000.0f);
+  const auto rx = rtm_internal::make_receiver_positions(vel, 1);
+  std::vector<float> rec_data(kReceiverSteps * rx.size(), 0.0f);
+  std::vector<float> field = random_field(vel.size(), 5);
+  const double samples = static_cast<double>(kReceiverSteps * rx.size());
+
+  BenchResult record{.suite = "kernels", .name = "record_receivers", .params = p};
+  record.seconds = median_seconds(opts, [&] {
+    for (std::size_t it = 0; it < kReceiverSteps; ++it) rtm_internal::record_receivers(vel, n / 2, 2, rx, field, rec_data, it);
+  });
+  record.points = samples;
+  record.bytes = samples * 2.0 * sizeof(float);
+  out.push_back(record);
+
+  BenchResult inject{.suite = "kernels", .name = "inject_receivers", .params = p};
+  inject.seconds = median_seconds(opts, [&] {
+    for (std::size_t it = 0; it < kReceiverSteps; ++it) rtm_internal::inject_receivers(vel, n / 2, 2, rx, rec_data, it, field);
+  });
+  inject.points = samples;
+  inject.bytes = samples * 3.0 * sizeof(float);
+  out.push_back(inject);
+}
+
+// Loaders and writers on a 4n x 4n section, timed through the filesystem.
+void bench_io(const BenchOptions& opts, std::size_t n, std::vector<BenchResult>& out) {
+  const std::size_t nx = 4 * n, nz = 4 * n;
+  const auto dir = std::filesystem::temp_directory_path() / "rtm3d_bench_io";
+  std::filesystem::create_directories(dir);
+  const auto values = random_field(nx * nz, 6);
+  {
+    std::ofstream f(dir / "x.json");
+    f << "[";
+    for (std::size_t i = 0; i < nx; ++i) f << (i ? ", " : "") << 10.0 * i;
+    f << "]";
+    std::ofstream v(dir / "vel.json");
+    v << "[";
+    for (std::size_t iz = 0; iz < nz; ++iz) {
+      v << (iz ? ",\n" : "") << "[";
+      for (std::size_t ix = 0; ix < nx; ++ix) v << (ix ? ", " : "") << 2000.0f + 500.0f * values[iz * nx + ix];
+      v << "]";
+    }
+    v << "]";
+  }
+  const auto p = params({{"nx", double(nx)}, {"nz", double(nz)}});
+  const double cells = static_cast<double>(nx * nz);
+
+  BenchResult l1{.suite = "kernels", .name = "load_array_1d_json", .params = p};
+  l1.seconds = median_seconds(opts, [&] { (void)load_array_1d_json((dir / "x.json").string()); });
+  l1.points = static_cast<double>(nx);
+  l1.bytes = static_cast<double>(std::filesystem::file_size(dir / "x.json"));
+  out.push_back(l1);
+
+  BenchResult l2{.suite = "kernels", .name = "load_array_2d_json", .params = p};
+  l2.seconds = median_seconds(opts, [&] { (void)load_array_2d_json((dir / "vel.json").string()); });
+  l2.points = cells;
+  l2.bytes = static_cast<double>(std::filesystem::file_size(dir / "vel.json"));
+  out.push_back(l2);
+
+  BenchResult pgm{.suite = "kernels", .name = "write_pgm", .params = p};
+  pgm.seconds = median_seconds(opts, [&] { write_pgm((dir / "image.pgm").string(), values, nx, nz); });
+  pgm.points = cells;
+  pgm.bytes = cells;
+  out.push_back(pgm);
+
+  BenchResult raw{.suite = "kernels", .name = "write_float32_raw", .params = p};
+  raw.seconds = median_seconds(opts, [&] { write_float32_raw((dir / "image.bin").string(), values, nx, nz); });
+  raw.points = cells;
+  raw.bytes = cells * sizeof(float);
+  out.push_back(raw);
+
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace
+
+void run_kernel_benchmarks(const BenchOptions& opts, std::vector<BenchResult>& out) {
+  for (const std::size_t n : opts.sizes) {
+    bench_stencil(opts, n, out);
+    bench_grid_kernels(opts, n, out);
+    bench_io(opts, n, out);
+  }
+}
+
+}  // namespace rtm3d::bench
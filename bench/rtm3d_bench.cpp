@@ -0,0 +1,106 @@
+// rtm3d_bench: kernel microbenchmarks, end-to-end shot sweeps and the propagator accuracy sweep.
+// Prints one JSON report; with --baseline, compares per-entry median seconds against a previous
+// report and exits non-zero on regressions or failed accuracy checks.
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchHarness.hpp"
+
+namespace {
+
+std::vector<std::size_t> parse_list(const std::string& s) {
+  std::vector<std::size_t> out;
+  std::size_t pos = 0;
+  while (pos < s.size()) {
+    const auto comma = s.find(',', pos);
+    out.push_back(std::stoul(s.substr(pos, comma - pos)));
+    pos = comma == std::string::npos ? s.size() : comma + 1;
+  }
+  if (out.empty()) throw std::runtime_error("empty list: " + s);
+  return out;
+}
+
+const char* kUsage =
+    "Usage: rtm3d_bench [options]\n"
+    "  --suite <all|kernels|e2e|propagators>[,...]   Suites to run (default kernels,e2e)\n"
+    "  --sizes <n,...>            Grid edge lengths (default 32,64,96)\n"
+    "  --threads <n,...>          Kernel thread counts (default 1,<hardware threads>)\n"
+    "  --nt <n>                   Time steps of the end-to-end shots (default 100)\n"
+    "  --min-time <s>             Minimum seconds per measurement (default 0.2)\n"
+    "  --tolerance <x>            Propagator trace-error target (default 0.05)\n"
+    "  --output <file.json>       Also write the report to a file\n"
+    "  --baseline <file.json>     Compare against a previous report\n"
+    "  --regression-tolerance <x> Allowed slowdown before flagging (default 0.10)\n";
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace rtm3d::bench;
+  BenchOptions opts;
+  const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+  opts.threads = hw > 1 ? std::vector<std::size_t>{1, hw} : std::vector<std::size_t>{1};
+  std::string suites = "kernels,e2e";
+  std::string output, baseline_path;
+  double regression_tolerance = 0.10;
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h") {
+        std::cout << kUsage;
+        return 0;
+      }
+      if (i + 1 >= argc) throw std::runtime_error("missing value for " + arg);
+      const std::string v = argv[++i];
+      if (arg == "--suite") suites = v;
+      else if (arg == "--sizes") opts.sizes = parse_list(v);
+      else if (arg == "--threads") opts.threads = parse_list(v);
+      else if (arg == "--nt") opts.e2e_nt = std::stoul(v);
+      else if (arg == "--min-time") opts.min_time = std::stod(v);
+      else if (arg == "--tolerance") opts.tolerance = std::stof(v);
+      else if (arg == "--output") output = v;
+      else if (arg == "--baseline") baseline_path = v;
+      else if (arg == "--regression-tolerance") regression_tolerance = std::stod(v);
+      else throw std::runtime_error("unknown option: " + arg);
+    }
+
+    auto wants = [&](const std::string& suite) {
+      return suites == "all" || ("," + suites + ",").find("," + suite + ",") != std::string::npos;
+    };
+    std::vector<BenchResult> results;
+    if (wants("kernels")) run_kernel_benchmarks(opts, results);
+    if (wants("e2e")) run_end_to_end_benchmarks(opts, results);
+    if (wants("propagators")) run_propagator_benchmarks(opts, results);
+
+    std::vector<Regression> regressions;
+    if (!baseline_path.empty()) {
+      regressions = compare_to_baseline(results, load_baseline(baseline_path), regression_tolerance);
+    }
+    write_report_json(std::cout, results, baseline_path, regression_tolerance, regressions);
+    if (!output.empty()) {
+      std::ofstream f(output);
+      if (!f) throw std::runtime_error("cannot write " + output);
+      write_report_json(f, results, baseline_path, regression_tolerance, regressions);
+    }
+
+    bool ok = regressions.empty();
+    for (const auto& r : results) {
+      if (!r.passed) {
+        std::cerr << "accuracy check failed: " << r.key() << " error=" << r.error << "\n";
+        ok = false;
+      }
+    }
+    for (const auto& g : regressions) {
+      std::cerr << "regression: " << g.key << " " << g.baseline_seconds << " s -> " << g.seconds << " s\n";
+    }
+    return ok ? 0 : 1;
+  } catch (const std::exception& e) {
+    std::cerr << "error: " << e.what() << "\n\n" << kUsage;
+    return 2;
+  }
+}
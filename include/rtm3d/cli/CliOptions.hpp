@@ -3,20 +3,42 @@
 #include <string>
 
 #include "rtm3d/io/GridModelLoader.hpp"
+#include "rtm3d/rtm/JobQueue.hpp"
 #include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/RunPlanner.hpp"
+#include "rtm3d/rtm/Survey.hpp"
 
 namespace rtm3d {
 
 enum class OutputFormat { kPgm8, kFloat32Raw };
+enum class PlanMode { kOff, kPrint, kApply };
+// kMigrate runs RTM and writes the stacked image; kModel only forward-models the survey's shots
+// and writes their receiver gathers. The job modes share a survey through --job-dir: kWorker
+// migrates shots it leases there, kReduce stacks the partial images, and kCoordinate starts
+// --workers worker processes, re-queues expired leases, restarts crashed workers and reduces.
+enum class RunMode { kMigrate, kModel, kWorker, kReduce, kCoordinate };
 
 struct CliOptions {
+  RunMode mode = RunMode::kMigrate;
   std::string x_file;
   std::string z_file;
   std::string values_file;
+  std::string model_3d;  // GridModel3D file; replaces the x/z/values 2D model
   std::string output_file = "output/migrated_inline.pgm";
   OutputFormat output_format = OutputFormat::kPgm8;
+  std::string gather_dir = "output/gathers";  // --mode model output
   GridLoadOptions load;
   RtmConfig rtm;
+  SurveyOptions survey;
+  PlanMode plan_mode = PlanMode::kOff;
+  PlanOptions plan;
+  std::string report_file;     // run report JSON; empty = <output_file>.report.json
+  bool perf_counters = false;  // add perf_event_open counters to the run report
+  bool autotune = false;       // tune the propagator loop order/tiles/threads (cached per host)
+  std::string tuning_cache;    // empty = default_tuning_cache_path()
+  bool precision_report = false;  // compare --precision against fp32 on one shot
+  JobOptions job;                 // --mode worker/reduce/coordinate
+  std::size_t workers = 2;        // --mode coordinate worker processes
 };
 
 CliOptions parse_cli_or_throw(int argc, char** argv);
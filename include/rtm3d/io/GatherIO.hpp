@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+#include "rtm3d/model/ShotGather.hpp"
+
+namespace rtm3d {
+
+// Raw float32 traces, row-major [n_receivers][nt], plus a <path>.json header in the schema
+// written by scripts/generate_synthetic_model.py (n_receivers, nt, dt, shot_x, shot_z,
+// receiver_x0, receiver_dx, dtype, order, units).
+void write_gather_float32(const std::string& path, const ShotGather& gather);
+
+// SEG-Y-like file with the layout of scripts/generate_synthetic_model.py: 3200-byte text header,
+// 400-byte big-endian binary header, then per trace a 240-byte header and nt big-endian IEEE
+// float32 samples. Not full SEG-Y: only the core header fields are set.
+void write_segy_like(const std::string& path, const ShotGather& gather);
+
+}  // namespace rtm3d
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "rtm3d/core/Volume3D.hpp"
+#include "rtm3d/model/GridModel2D.hpp"
+
+namespace rtm3d {
+
+// A 3D velocity model on disk: raw float32 samples, row-major [nz][ny][nx] like Volume3D, plus a
+// <path>.json header (nx, ny, nz, dx, dy, dz). The file is memory-mapped read-only, so opening it
+// reads nothing; pages come in as slabs or windows are touched and evict() hands them back. A
+// survey that reads one shot window at a time keeps a resident set of about one window, however
+// large the model is.
+class GridModel3D {
+ public:
+  static GridModel3D open(const std::string& path);
+
+  GridModel3D() = default;
+  ~GridModel3D();
+  GridModel3D(GridModel3D&& other) noexcept;
+  GridModel3D& operator=(GridModel3D&& other) noexcept;
+  GridModel3D(const GridModel3D&) = delete;
+  GridModel3D& operator=(const GridModel3D&) = delete;
+
+  std::size_t nx() const { return nx_; }
+  std::size_t ny() const { return ny_; }
+  std::size_t nz() const { return nz_; }
+  float dx() const { return dx_; }
+  float dy() const { return dy_; }
+  float dz() const { return dz_; }
+
+  // Depth planes [iz0, iz1), paged in lazily as they are read.
+  std::span<const float> z_slab(std::size_t iz0, std::size_t iz1) const;
+  // Drops the pages of planes [iz0, iz1) from this process's resident set; later reads fault them
+  // in again from the page cache or the file.
+  void evict(std::size_t iz0, std::size_t iz1) const;
+
+  // Copies columns [x0, x1) x rows [y0, y1) of every plane into a volume, touching only those rows
+  // and evicting each plane's pages once copied.
+  Volume3D read_window(std::size_t x0, std::size_t x1, std::size_t y0, std::size_t y1) const;
+  // The xz plane at row iy, e.g. the inline section under a survey line.
+  GridModel2D inline_section(std::size_t iy) const;
+
+ private:
+  void check_planes(std::size_t iz0, std::size_t iz1) const;
+
+  std::size_t nx_ = 0, ny_ = 0, nz_ = 0;
+  float dx_ = 0.0f, dy_ = 0.0f, dz_ = 0.0f;
+  const float* data_ = nullptr;
+  std::size_t mapped_bytes_ = 0;
+};
+
+// Writes `values` ([nz][ny][nx]) in the GridModel3D format.
+void write_grid_model_3d(const std::string& path, std::size_t nx, std::size_t ny, std::size_t nz, float dx, float dy,
+                         float dz, const std::vector<float>& values);
+
+}  // namespace rtm3d
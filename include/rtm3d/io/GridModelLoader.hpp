@@ -19,4 +19,7 @@ GridModel2D load_grid_model_from_json_arrays(const std::string& x_file,
                                              const std::string& values_file,
                                              const GridLoadOptions& opts);
 
+// Applies decimation and cropping to an already loaded model (e.g. one loaded at native sampling).
+GridModel2D resample_grid_model(const GridModel2D& model, const GridLoadOptions& opts);
+
 }  // namespace rtm3d
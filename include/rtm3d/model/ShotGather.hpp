@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace rtm3d {
+
+// Recorded traces of one shot. Positions are in metres from the first model column and from the
+// surface.
+struct ShotGather {
+  float shot_x{};
+  float shot_z{};
+  std::vector<float> receiver_x;  // one per trace
+  float receiver_z{};
+  std::size_t nt{};
+  float dt{};
+  std::vector<float> traces;      // row-major [n_receivers][nt]
+};
+
+}  // namespace rtm3d
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d {
+
+struct AutotuneOptions {
+  std::string cache_path;  // empty = default_tuning_cache_path()
+  std::size_t steps = 3;   // timed propagator steps per candidate, after one warm-up step
+  float aperture = 0.0f;   // the survey's aperture: shots run on windows that wide; 0 = whole model
+};
+
+struct TuningResult {
+  std::string key;
+  FdKernelTuning tuning;
+  std::size_t threads = 1;
+  double points_per_second{};
+  bool from_cache{};
+  std::size_t candidates{};  // configurations timed; 0 on a cache hit
+};
+
+// $RTM3D_TUNING_CACHE, else $XDG_CACHE_HOME/rtm3d/tuning.json, else ~/.cache/rtm3d/tuning.json.
+std::string default_tuning_cache_path();
+
+// Identifies a tuning: CPU model, hardware threads, propagator, stencil order and grid dims.
+// `model` is the grid a shot propagates on, i.e. its window when the survey has an aperture.
+std::string tuning_cache_key(const GridModel2D& model, const RtmConfig& cfg);
+
+// Returns the cached tuning for this host and per-shot grid (the centre shot's window), or times
+// the candidate loop orders, tiles and thread counts of the propagator on that grid and caches the
+// fastest. Throws for fp16/bf16 wavefields and stretched depth grids, whose kernels ignore tiling.
+TuningResult autotune_kernels(const GridModel2D& model, const RtmConfig& cfg, const AutotuneOptions& opts = {});
+
+void apply_tuning(const TuningResult& tuning, RtmConfig& cfg);
+std::string format_tuning(const TuningResult& tuning);
+
+}  // namespace rtm3d
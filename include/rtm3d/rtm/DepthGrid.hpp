@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d {
+
+// Depths of the propagation grid's z-planes. A uniform grid samples everything at the model dz, which
+// the slowest (usually shallow) velocities dictate. A stretched grid widens the spacing with depth as
+// far as the slowest velocity at and below each depth allows, so no plane has fewer points per
+// wavelength than the surface, and the FD stencil switches to per-plane z weights.
+struct DepthGrid {
+  std::vector<float> z;  // [m] from the top row; z[0] = 0, strictly increasing
+};
+
+constexpr float kDefaultDepthGrowth = 1.1f;  // max ratio of neighbouring spacings
+// Planes spaced dz from the top, so the engine's source and receiver plane (2) keeps its depth.
+constexpr std::size_t kUniformTopPlanes = 3;
+
+// Spacing at depth z is dz * clamp(vmin_below(z) / vmin, 1, max_ratio), where vmin_below is the slowest
+// velocity in the rows at and below z, growing by at most max_growth per plane below the uniform top
+// planes. The last plane lies at or below the model bottom; velocities below it repeat the bottom row.
+DepthGrid make_stretched_depth_grid(const GridModel2D& model, float max_ratio, float max_growth = kDefaultDepthGrowth);
+
+// The stretched grid for cfg.max_dz_ratio > 1, otherwise the model's own rows.
+DepthGrid propagation_depth_grid(const GridModel2D& model, const RtmConfig& cfg);
+
+std::vector<float> uniform_depths(std::size_t nz, float dz);
+
+// Rows [from.size()][nx] sampled at depths `from`, linearly interpolated onto depths `to`. Both are
+// increasing; depths outside `from` take the nearest end row.
+std::vector<float> resample_depth(const std::vector<float>& rows, std::size_t nx, const std::vector<float>& from,
+                                  const std::vector<float>& to);
+
+}  // namespace rtm3d
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+namespace rtm3d {
+
+class RunProfile;
+
+// A survey shared by independent worker processes through a job directory, standing in for a
+// cluster scheduler:
+//
+//   <dir>/job.json                    survey fingerprint, shot count, snapshot strategy and image size
+//   <dir>/leases/shot_<k>.lease       held by the worker migrating shot k, touched as a heartbeat
+//   <dir>/partials/shot_<k>.bin       shot k's window image, written durably once migrated
+//
+// A worker claims a shot by creating its lease exclusively. A lease whose heartbeat is older than
+// lease_seconds is taken to belong to a dead worker and may be taken over; of several workers
+// taking over the same lease at most one wins. Partial images are idempotent, so a live worker
+// mistaken for a dead one only costs duplicated work.
+struct JobOptions {
+  std::string dir;
+  double lease_seconds = 30.0;
+  std::string worker_id;      // written into leases; empty = <hostname>:<pid>
+  std::size_t max_shots = 0;  // a worker returns after migrating this many shots; 0 = no limit
+};
+
+struct JobStatus {
+  std::size_t shots{};
+  std::size_t done{};     // partial image written
+  std::size_t leased{};   // lease held, heartbeat within lease_seconds
+  std::size_t expired{};  // lease held, heartbeat older than lease_seconds
+  std::size_t pending() const { return shots - done - leased - expired; }
+};
+
+// Creates the job directory for this survey, or checks that an existing one holds the same survey
+// (same fingerprint as a run_survey checkpoint). Safe to call from every worker. A new job resolves
+// snapshot_strategy auto against this process's memory budget and records the result.
+void init_job_dir(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey, const JobOptions& job);
+
+// cfg with the job's recorded snapshot strategy in place of auto. Throws if cfg names another
+// strategy. run_job_worker and reduce_job apply it themselves.
+RtmConfig job_config(const RtmConfig& cfg, const JobOptions& job);
+
+// Claims and migrates shots until every shot has a partial image (waiting on shots other workers
+// hold) or job.max_shots are done. Returns the number of shots this worker migrated.
+std::size_t run_job_worker(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey,
+                           const JobOptions& job, RunProfile* profile = nullptr);
+
+JobStatus job_status(const JobOptions& job);
+
+// Removes leases whose heartbeat is older than job.lease_seconds, returning how many, so any worker
+// picks their shots up again without waiting to notice the expiry itself.
+std::size_t requeue_expired_leases(const JobOptions& job);
+
+struct CoordinatorResult {
+  SurveyResult survey;
+  std::size_t restarts{};  // workers started again after failing
+  std::size_t requeued{};  // expired leases removed
+};
+
+// Starts `workers` workers through spawn_worker(), which returns the child's pid, re-queues leases
+// of workers that stopped heartbeating, restarts workers that fail while shots remain (at most
+// `workers` times in total) and stacks the partial images once every shot is done. Reaps any child
+// of the calling process; warnings about failed workers and re-queued leases go to `log`.
+CoordinatorResult run_job_coordinator(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey,
+                                      const JobOptions& job, std::size_t workers,
+                                      const std::function<pid_t()>& spawn_worker, std::ostream& log);
+
+// Stacks the partial images in shot order; the result is bit-identical to run_survey's stack.
+// Throws if a shot is missing or a partial was written for a different survey.
+SurveyResult reduce_job(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey,
+                        const JobOptions& job);
+
+}  // namespace rtm3d
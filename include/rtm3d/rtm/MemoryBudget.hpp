@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d {
+
+struct StrategyEstimate {
+  SnapshotStrategy strategy{};
+  std::size_t ram_bytes{};   // peak resident bytes of one shot (snapshots + live volumes)
+  std::size_t disk_bytes{};  // scratch disk bytes (spill only)
+  double relative_cost{};    // estimated run time relative to full snapshots
+  bool exact{};              // image identical to full snapshots
+};
+
+struct MemoryPlan {
+  std::size_t budget_bytes{};
+  bool budget_detected{};    // true when the budget came from available RAM, not max_memory_bytes
+  std::vector<StrategyEstimate> strategies;
+  SnapshotStrategy chosen = SnapshotStrategy::kFull;
+  bool fits = true;          // false when nothing fits and the smallest strategy was chosen
+};
+
+const char* snapshot_strategy_name(SnapshotStrategy s);
+SnapshotStrategy parse_snapshot_strategy(const std::string& name);  // throws on unknown names
+
+// MemAvailable from /proc/meminfo, falling back to free physical pages; 0 if unknown.
+std::size_t detect_available_memory();
+
+// Checkpointed snapshots replay the source with the fp32 kernel, which retraces only an fp32
+// forward pass; 16-bit wavefields round differently.
+bool checkpointed_supported(const RtmConfig& cfg);
+
+// Random-boundary reconstruction needs the fp32 finite-difference propagator on the uniform depth
+// grid of a single process.
+bool random_boundary_supported(const RtmConfig& cfg);
+
+// Only lists checkpointed and random_boundary where checkpointed_supported(cfg) and
+// random_boundary_supported(cfg).
+std::vector<StrategyEstimate> estimate_snapshot_strategies(const GridModel2D& model, const RtmConfig& cfg);
+
+// Picks the cheapest strategy whose RAM fits cfg.max_memory_bytes (or the detected available RAM).
+// An explicit cfg.snapshot_strategy is kept and only checked. Slab-decomposed runs (ranks > 1)
+// support full snapshots only, split across ranks.
+MemoryPlan select_snapshot_strategy(const GridModel2D& model, const RtmConfig& cfg);
+
+// Peak resident bytes of one shot with ImagingCondition::kFrequencyDomain (no snapshots).
+std::size_t estimate_frequency_imaging_bytes(const GridModel2D& model, const RtmConfig& cfg);
+
+void write_memory_plan_json(const std::string& path, const MemoryPlan& plan);
+
+}  // namespace rtm3d
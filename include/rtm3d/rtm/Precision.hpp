@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d {
+
+const char* wavefield_precision_name(WavefieldPrecision p);              // fp32, fp16, bf16
+WavefieldPrecision parse_wavefield_precision(const std::string& name);  // throws on unknown names
+
+// Errors of a cfg.precision run against the same shot with fp32 wavefields. Relative errors are
+// normalised by the reference: L2 by its norm, max by its peak.
+struct PrecisionReport {
+  WavefieldPrecision precision{};
+  double image_relative_l2{};
+  double image_relative_max{};
+  double image_correlation{};   // normalised zero-lag correlation with the fp32 image
+  double gather_relative_l2{};  // recorded receiver data of the forward pass
+  double seconds{};             // migration at cfg.precision
+  double reference_seconds{};   // migration at fp32
+};
+
+// Migrates and forward-models the shot at cfg.precision and at fp32 and compares the results.
+PrecisionReport compare_precision_to_fp32(const GridModel2D& model, const RtmConfig& cfg);
+
+void write_precision_report_json(const std::string& path, const PrecisionReport& report);
+std::string format_precision_report(const PrecisionReport& report);
+
+}  // namespace rtm3d
@@ -1,12 +1,40 @@
 #pragma once
 
 #include <cstddef>
+#include <string>
 #include <vector>
 
+#include "rtm3d/core/Volume3D.hpp"
 #include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/model/ShotGather.hpp"
 
 namespace rtm3d {
 
+enum class PropagatorKind { kFiniteDifference, kPseudoSpectral };
+
+// How the forward source wavefield is kept for the imaging pass (see MemoryBudget.hpp).
+enum class SnapshotStrategy { kAuto, kFull, kSubsampled, kCompressed, kCheckpointed, kSpill, kRandomBoundary };
+
+// kCrossCorrelation correlates the receiver field with stored source snapshots at every step.
+// kFrequencyDomain keeps running DFTs of both fields at a few frequencies instead, so memory is
+// O(nfreq * n) rather than O(nt * n), and sums the per-frequency products.
+enum class ImagingCondition { kCrossCorrelation, kFrequencyDomain };
+
+// Storage of the live wavefields and of the v^2 dt^2 and damping volumes. The 16-bit formats halve
+// the bytes a propagation step moves; arithmetic stays fp32. fp16 keeps 11 mantissa bits over a
+// narrow range (fields are power-of-two scaled per step to stay in it); bf16 keeps fp32's range
+// with 8 mantissa bits. See Precision.hpp for the accuracy report.
+enum class WavefieldPrecision { kFloat32, kFloat16, kBFloat16 };
+
+// Loop structure of the finite-difference kernel. Every setting produces bit-identical fields;
+// the best one depends on cache sizes and grid shape (see Autotuner.hpp).
+struct FdKernelTuning {
+  enum class LoopOrder { kZyx, kYzx };  // plane by plane, or y-tiles streamed through z
+  LoopOrder order = LoopOrder::kZyx;
+  std::size_t tile_y = 0;  // kYzx: interior rows per tile; 0 = all rows
+  std::size_t tile_x = 0;  // kYzx: interior points per row segment; 0 = whole rows
+};
+
 struct RtmConfig {
   std::size_t ny = 32;
   float dy = 20.0f;
@@ -15,6 +43,34 @@ struct RtmConfig {
   float f0 = 12.0f;
   std::size_t pml = 10;
   std::size_t receiver_stride = 8;
+  std::size_t source_ix = 0;  // source column; 0 = nx / 2
+  // >1 splits the grid into z-slabs migrated by that many local worker processes, exchanging
+  // halos through shared memory. Produces the same image as a single process.
+  std::size_t ranks = 1;
+  PropagatorKind propagator = PropagatorKind::kFiniteDifference;
+  std::size_t threads = 1;  // kernel threads per process; 0 means all hardware threads
+  FdKernelTuning fd_tuning;
+  WavefieldPrecision precision = WavefieldPrecision::kFloat32;  // 16-bit: fd propagator, one process
+  // >1 propagates on a stretched depth grid with spacing up to max_dz_ratio * dz where the velocity
+  // allows (see DepthGrid.hpp); images are mapped back to the model rows. fd, fp32, one process.
+  float max_dz_ratio = 1.0f;
+
+  SnapshotStrategy snapshot_strategy = SnapshotStrategy::kAuto;
+  std::size_t snapshot_stride = 0;       // subsampled: keep every n-th step; 0 = Nyquist of 2 fmax
+  std::size_t checkpoint_interval = 0;   // checkpointed: steps per segment; 0 = ceil(sqrt(nt))
+  std::size_t max_memory_bytes = 0;      // kAuto budget; 0 = detected available RAM
+  std::string spill_dir;                 // spill: directory for the snapshot file; empty = temp dir
+
+  ImagingCondition imaging = ImagingCondition::kCrossCorrelation;
+  std::size_t nfreq = 0;   // frequency domain: 0 = DFT bin spacing 1/(nt dt) over the band
+  float freq_min = 0.0f;   // [Hz]
+  float freq_max = 0.0f;   // [Hz]; 0 = ricker_max_frequency(f0), capped at Nyquist
+
+  // Intra-shot restart (frequency imaging only): every state_checkpoint_steps time steps the
+  // wavefields, recorded data and DFT sums are written atomically to state_checkpoint_file. A run
+  // that finds a checkpoint of the same shot there continues from it; it is removed when the shot ends.
+  std::string state_checkpoint_file;
+  std::size_t state_checkpoint_steps = 0;
 };
 
 struct MigrationResult {
@@ -24,6 +80,22 @@ struct MigrationResult {
 };
 
 std::vector<float> ricker_wavelet(std::size_t nt, float dt, float f0);
-MigrationResult run_single_shot_rtm(const GridModel2D& model, const RtmConfig& cfg);
+// Highest significant frequency of a Ricker wavelet (amplitude spectrum ~3% of its peak).
+float ricker_max_frequency(float f0);
+// Frequencies imaged by ImagingCondition::kFrequencyDomain: nfreq evenly spaced in [freq_min, freq_max].
+std::vector<float> imaging_frequencies(const RtmConfig& cfg);
+class RunProfile;
+
+// `profile`, when given, receives per-phase timings (see RunProfile.hpp).
+MigrationResult run_single_shot_rtm(const GridModel2D& model, const RtmConfig& cfg, RunProfile* profile = nullptr);
+// The same shot on a velocity volume cut from a 3D model (GridModel3D::read_window) instead of a
+// 2D model extruded in y. vel.ny() must equal cfg.ny and cfg.dy is the model's y spacing; the
+// image is the volume's middle xz plane. One process, uniform depth grid, no state checkpoints.
+MigrationResult run_single_shot_rtm(Volume3D vel, float dx, float dz, const RtmConfig& cfg,
+                                    RunProfile* profile = nullptr);
+
+// Forward propagation of the same shot only (no snapshots, no backward pass), returning what the
+// receivers record.
+ShotGather run_forward_modeling(const GridModel2D& model, const RtmConfig& cfg, RunProfile* profile = nullptr);
 
 }  // namespace rtm3d
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "rtm3d/io/GridModelLoader.hpp"
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d {
+
+struct PlanOptions {
+  float record_length = 0.0f;          // seconds; 0 keeps the configured nt * dt
+  float points_per_wavelength = 0.0f;  // 0 picks the propagator default (FD 10, pseudo-spectral 3)
+  float cfl_safety = 0.9f;             // fraction of the stability limit used for dt
+  bool calibrate = true;               // time a few steps on a small block of the planned spacing
+};
+
+struct RunPlan {
+  float vmin{};
+  float vmax{};
+  float fmax{};                  // highest significant source frequency (2.5 f0 for a Ricker)
+  float points_per_wavelength{};
+  float max_spacing{};           // vmin / (fmax * ppw)
+  std::size_t decim_x = 1;
+  std::size_t decim_z = 1;
+  std::size_t nx{}, ny{}, nz{};
+  float dx{}, dy{}, dz{};
+  bool meets_ppw = true;         // false when the native sampling is already coarser than max_spacing
+  float dt_limit{};
+  float dt{};
+  std::size_t nt{};
+  double point_updates{};        // forward + backward grid-point updates
+  double points_per_second{};    // calibrated single-process throughput, 0 if not measured
+  std::size_t memory_bytes{};
+};
+
+// Largest dt for which the leapfrog scheme of `kind` is stable at velocity vmax.
+float max_stable_dt(PropagatorKind kind, float vmax, float dx, float dy, float dz);
+
+// Plans decimation, dy/ny, dt and nt for `raw_model` (the model at its native sampling, already
+// cropped to the region of interest). cfg supplies f0, the y extent ((ny-1)*dy), the propagator and
+// the fallback record length.
+RunPlan plan_run(const GridModel2D& raw_model, const RtmConfig& cfg, const PlanOptions& opts);
+
+// Copies the planned sampling into load options and RTM config.
+void apply_plan(const RunPlan& plan, GridLoadOptions& load, RtmConfig& cfg);
+
+std::string format_plan(const RunPlan& plan);
+
+}  // namespace rtm3d
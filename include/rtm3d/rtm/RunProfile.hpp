@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d {
+
+struct HwCounts {
+  std::uint64_t cycles{};
+  std::uint64_t instructions{};
+  std::uint64_t llc_misses{};
+};
+
+struct PhaseStats {
+  std::string name;
+  std::size_t calls{};
+  double seconds{};
+  double grid_points{};  // grid-point updates done in the phase, 0 if not a grid sweep
+  double bytes{};        // compulsory memory traffic estimate
+  HwCounts hw;
+};
+
+// Time split of one thread of a staged pipeline (see run_survey). Stages run concurrently, so
+// their seconds overlap each other and the phases; they are not part of total_seconds().
+struct StageStats {
+  std::string name;
+  std::size_t items{};
+  double busy_seconds{};
+  double input_wait_seconds{};   // blocked on an empty input queue
+  double output_wait_seconds{};  // blocked on a full output queue
+  double wall_seconds{};         // lifetime of the pipeline
+
+  double utilization() const { return wall_seconds > 0.0 ? busy_seconds / wall_seconds : 0.0; }
+};
+
+// Accumulates wall time (and optionally perf_event_open counters) per named phase. Phases keep
+// their first-use order and may be timed from several threads. Counters count the thread that
+// built the profile only, so they describe a phase only when its work runs on that thread
+// (threads = 1, ranks = 1); phases timed on other threads get no counts.
+class RunProfile {
+ public:
+  explicit RunProfile(bool hw_counters = false);
+  ~RunProfile();
+  RunProfile(const RunProfile&) = delete;
+  RunProfile& operator=(const RunProfile&) = delete;
+
+  class Scope {
+   public:
+    Scope(RunProfile& profile, std::size_t phase, double grid_points, double bytes);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    RunProfile& profile_;
+    std::size_t phase_;
+    double grid_points_, bytes_;
+    std::chrono::steady_clock::time_point start_;
+    HwCounts hw_start_;
+  };
+
+  Scope phase(const std::string& name, double grid_points = 0.0, double bytes = 0.0);
+
+  bool hw_counters_available() const { return fds_[0] >= 0; }
+  const std::vector<PhaseStats>& phases() const { return phases_; }
+  double total_seconds() const;
+
+  void add_stage(const StageStats& stage) { stages_.push_back(stage); }
+  const std::vector<StageStats>& stages() const { return stages_; }
+
+ private:
+  HwCounts read_counters() const;
+
+  int fds_[3] = {-1, -1, -1};
+  std::thread::id owner_ = std::this_thread::get_id();  // the thread the counters follow
+  std::mutex mu_;                                       // guards phases_
+  std::vector<PhaseStats> phases_;
+  std::vector<StageStats> stages_;
+};
+
+// Writes the machine-readable run report: grid, configuration, host, per-phase seconds, grid
+// points/s, effective GB/s and hardware counters, and pipeline stage utilization.
+void write_run_report_json(const std::string& path, const RunProfile& profile, const GridModel2D& model,
+                           const RtmConfig& cfg);
+
+// One line per phase and per pipeline stage for the console.
+std::string format_run_profile(const RunProfile& profile);
+
+}  // namespace rtm3d
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d {
+
+class GridModel3D;
+class RunProfile;
+
+struct SurveyOptions {
+  std::size_t shots = 1;        // sources evenly spaced along x at the engine's source depth
+  float first_shot_x = 0.0f;    // [m] from the first model column; first == last == 0 spreads the
+  float last_shot_x = 0.0f;     //     shots over the centres of equal-width model segments
+  float aperture = 0.0f;        // [m] half-width of the model window migrated per shot; 0 = whole model
+  std::size_t queue_depth = 2;  // shots buffered between run_survey's pipeline stages
+
+  // Restart support. Every checkpoint_every shots the stacked image and the completion ledger are
+  // written atomically to checkpoint_dir. With resume, shots already in the ledger are skipped and
+  // the stack continues from the checkpointed image. Without it, an existing ledger is an error.
+  std::string checkpoint_dir;   // empty = no checkpoints
+  std::size_t checkpoint_every = 1;
+  bool resume = false;
+
+  // Per-shot image cache. Each migrated shot's image is kept in cache_dir under a hash of its model
+  // window and configuration, and later surveys stack a shot whose hash is there instead of
+  // migrating it. Entries least recently used are removed once the directory exceeds
+  // cache_max_bytes. The cache may be shared by surveys of different models and configurations.
+  std::string cache_dir;          // empty = no cache
+  std::size_t cache_max_bytes = 0;  // 0 = no cap
+};
+
+struct ShotCacheStats {
+  std::size_t hits{};     // shots stacked from the cache
+  std::size_t misses{};   // shots migrated and added to it
+  std::size_t failed{};   // of those, shots whose image could not be written (the survey goes on)
+  std::size_t evicted{};  // entries removed to stay within cache_max_bytes
+  std::size_t entries{};  // left in the cache directory
+  std::size_t bytes{};    // disk footprint of those entries
+  std::string error{};    // first failed write, empty if none
+};
+
+struct SurveyResult {
+  MigrationResult stack;      // sum of the per-shot inline images on the full model grid
+  std::size_t shots{};
+  std::size_t resumed{};      // shots taken from the checkpoint instead of migrated in this run
+  ShotCacheStats cache;       // all zero without a cache directory
+};
+
+// Source columns of the survey's shots, in migration order.
+std::vector<std::size_t> survey_shot_columns(const GridModel2D& model, const SurveyOptions& opts);
+
+// Migrates every shot and stacks the images. Preparing each shot's sub-model, migrating it and
+// stacking/checkpointing its image run as three threads joined by queues of opts.queue_depth
+// shots, so window cuts and checkpoint writes hide behind propagation; the stage utilizations go
+// to `profile` (RunProfile::stages()). With a checkpoint directory and
+// cfg.state_checkpoint_steps > 0, each shot also keeps its wavefield state there
+// (shot_<index>.state), so a resumed run continues an interrupted shot mid-way. Shots found in
+// opts.cache_dir are read from their mapped entries by the prepare stage and stacked in order, so
+// the stack is bit-identical to migrating them.
+SurveyResult run_survey(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& opts,
+                        RunProfile* profile = nullptr);
+
+void write_shot_cache_stats_json(const std::string& path, const ShotCacheStats& stats);
+
+// The same survey over a memory-mapped 3D model: shots lie on the model's middle y row, and the
+// prepare stage reads each shot's aperture window x min(cfg.ny, model.ny()) rows from the file, so
+// only the windows in flight are resident. cfg.dy is replaced by the model's. The stack is the
+// inline section under the shots. Checkpoint and cache options are not supported.
+SurveyResult run_survey(const GridModel3D& model, const RtmConfig& cfg, const SurveyOptions& opts,
+                        RunProfile* profile = nullptr);
+
+// Forward-models every shot of the survey (same positions and aperture windows as run_survey) and
+// passes each gather to `sink` as soon as it is recorded. Shots run concurrently, up to
+// cfg.threads at a time (0 = all hardware threads), with the remaining threads given to each
+// shot's kernels. `sink` is called from those threads, once per shot index. Checkpoint options
+// are ignored.
+using GatherSink = std::function<void(std::size_t shot, const ShotGather& gather)>;
+void model_survey(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& opts, const GatherSink& sink,
+                  RunProfile* profile = nullptr);
+
+}  // namespace rtm3d
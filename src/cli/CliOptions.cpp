@@ -1,5 +1,8 @@
 #include "rtm3d/cli/CliOptions.hpp"
 
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/Precision.hpp"
+
 #include <fstream>
 #include <regex>
 #include <stdexcept>
@@ -35,6 +38,13 @@ std::string json_find_number_token(const std::string& s, const std::string& key)
   return "";
 }
 
+bool json_find_bool(const std::string& s, const std::string& key, bool fallback) {
+  const std::regex rx("\\\"" + key + "\\\"\\s*:\\s*(true|false)");
+  std::smatch m;
+  if (std::regex_search(s, m, rx)) return m[1].str() == "true";
+  return fallback;
+}
+
 void apply_data_dir(CliOptions& o, const std::string& dir) {
   o.x_file = dir + "/x.json";
   o.z_file = dir + "/z.json";
@@ -47,6 +57,34 @@ OutputFormat parse_output_format_or_throw(const std::string& token, const std::s
   throw std::runtime_error("invalid output format in " + source + ": " + token);
 }
 
+PropagatorKind parse_propagator_or_throw(const std::string& token, const std::string& source) {
+  if (token == "fd") return PropagatorKind::kFiniteDifference;
+  if (token == "pseudo_spectral") return PropagatorKind::kPseudoSpectral;
+  throw std::runtime_error("invalid propagator in " + source + ": " + token);
+}
+
+ImagingCondition parse_imaging_or_throw(const std::string& token, const std::string& source) {
+  if (token == "cross_correlation") return ImagingCondition::kCrossCorrelation;
+  if (token == "frequency") return ImagingCondition::kFrequencyDomain;
+  throw std::runtime_error("invalid imaging condition in " + source + ": " + token);
+}
+
+RunMode parse_run_mode_or_throw(const std::string& token, const std::string& source) {
+  if (token == "migrate") return RunMode::kMigrate;
+  if (token == "model") return RunMode::kModel;
+  if (token == "worker") return RunMode::kWorker;
+  if (token == "reduce") return RunMode::kReduce;
+  if (token == "coordinate") return RunMode::kCoordinate;
+  throw std::runtime_error("invalid mode in " + source + ": " + token);
+}
+
+PlanMode parse_plan_mode_or_throw(const std::string& token, const std::string& source) {
+  if (token == "off") return PlanMode::kOff;
+  if (token == "print") return PlanMode::kPrint;
+  if (token == "apply") return PlanMode::kApply;
+  throw std::runtime_error("invalid plan mode in " + source + ": " + token);
+}
+
 template <typename T>
 T parse_num(const std::string& s, const std::string& name);
 
@@ -67,21 +105,56 @@ float parse_num<float>(const std::string& s, const std::string& name) {
   return v;
 }
 
+// Byte count with an optional binary K/M/G suffix, e.g. "512M".
+std::size_t parse_bytes(const std::string& s, const std::string& name) {
+  if (s.empty()) throw std::runtime_error("invalid value for " + name + ": " + s);
+  std::size_t shift = 0;
+  switch (s.back()) {
+    case 'K': case 'k': shift = 10; break;
+    case 'M': case 'm': shift = 20; break;
+    case 'G': case 'g': shift = 30; break;
+    default: break;
+  }
+  const auto digits = shift == 0 ? s : s.substr(0, s.size() - 1);
+  return parse_num<std::size_t>(digits, name) << shift;
+}
+
+SnapshotStrategy parse_snapshot_strategy_or_throw(const std::string& token, const std::string& source) {
+  try {
+    return parse_snapshot_strategy(token);
+  } catch (const std::runtime_error&) {
+    throw std::runtime_error("invalid snapshot strategy in " + source + ": " + token);
+  }
+}
+
 void apply_json_config(CliOptions& o, const std::string& path) {
   const auto s = slurp_file(path);
 
   if (const auto dir = json_find_string(s, "data_dir"); !dir.empty()) {
     apply_data_dir(o, dir);
   }
+  if (const auto v = json_find_string(s, "model_3d"); !v.empty()) o.model_3d = v;
   if (const auto v = json_find_string(s, "x_file"); !v.empty()) o.x_file = v;
   if (const auto v = json_find_string(s, "z_file"); !v.empty()) o.z_file = v;
   if (const auto v = json_find_string(s, "values_file"); !v.empty()) o.values_file = v;
   if (const auto v = json_find_string(s, "output_file"); !v.empty()) o.output_file = v;
+  if (const auto v = json_find_string(s, "mode"); !v.empty()) o.mode = parse_run_mode_or_throw(v, "config");
+  if (const auto v = json_find_string(s, "gather_dir"); !v.empty()) o.gather_dir = v;
+  if (const auto v = json_find_string(s, "job_dir"); !v.empty()) o.job.dir = v;
+  if (const auto v = json_find_number_token(s, "workers"); !v.empty()) o.workers = parse_num<std::size_t>(v, "workers");
+  if (const auto v = json_find_number_token(s, "lease_seconds"); !v.empty())
+    o.job.lease_seconds = parse_num<float>(v, "lease_seconds");
 
   if (const auto v = json_find_string(s, "output_format"); !v.empty()) {
     o.output_format = parse_output_format_or_throw(v, "config");
   }
 
+  if (const auto v = json_find_string(s, "propagator"); !v.empty()) {
+    o.rtm.propagator = parse_propagator_or_throw(v, "config");
+  }
+
+  if (const auto v = json_find_string(s, "plan"); !v.empty()) o.plan_mode = parse_plan_mode_or_throw(v, "config");
+
   if (const auto v = json_find_number_token(s, "decim_x"); !v.empty()) o.load.decim_x = parse_num<std::size_t>(v, "decim_x");
   if (const auto v = json_find_number_token(s, "decim_z"); !v.empty()) o.load.decim_z = parse_num<std::size_t>(v, "decim_z");
   if (const auto v = json_find_number_token(s, "crop_x"); !v.empty()) o.load.crop_x = parse_num<std::size_t>(v, "crop_x");
@@ -95,37 +168,227 @@ void apply_json_config(CliOptions& o, const std::string& path) {
   if (const auto v = json_find_number_token(s, "pml"); !v.empty()) o.rtm.pml = parse_num<std::size_t>(v, "pml");
   if (const auto v = json_find_number_token(s, "receiver_stride"); !v.empty())
     o.rtm.receiver_stride = parse_num<std::size_t>(v, "receiver_stride");
+  if (const auto v = json_find_number_token(s, "ranks"); !v.empty()) o.rtm.ranks = parse_num<std::size_t>(v, "ranks");
+  if (const auto v = json_find_number_token(s, "record_length"); !v.empty())
+    o.plan.record_length = parse_num<float>(v, "record_length");
+  if (const auto v = json_find_number_token(s, "points_per_wavelength"); !v.empty())
+    o.plan.points_per_wavelength = parse_num<float>(v, "points_per_wavelength");
+  if (const auto v = json_find_number_token(s, "threads"); !v.empty()) o.rtm.threads = parse_num<std::size_t>(v, "threads");
+
+  if (const auto v = json_find_string(s, "snapshot_strategy"); !v.empty()) {
+    o.rtm.snapshot_strategy = parse_snapshot_strategy_or_throw(v, "config");
+  }
+  if (const auto v = json_find_number_token(s, "snapshot_stride"); !v.empty())
+    o.rtm.snapshot_stride = parse_num<std::size_t>(v, "snapshot_stride");
+  if (const auto v = json_find_number_token(s, "checkpoint_interval"); !v.empty())
+    o.rtm.checkpoint_interval = parse_num<std::size_t>(v, "checkpoint_interval");
+  if (const auto v = json_find_string(s, "max_memory"); !v.empty()) o.rtm.max_memory_bytes = parse_bytes(v, "max_memory");
+  if (const auto v = json_find_number_token(s, "max_memory"); !v.empty())
+    o.rtm.max_memory_bytes = parse_num<std::size_t>(v, "max_memory");
+  if (const auto v = json_find_string(s, "spill_dir"); !v.empty()) o.rtm.spill_dir = v;
+
+  if (const auto v = json_find_string(s, "imaging"); !v.empty()) o.rtm.imaging = parse_imaging_or_throw(v, "config");
+  if (const auto v = json_find_number_token(s, "max_dz_ratio"); !v.empty())
+    o.rtm.max_dz_ratio = parse_num<float>(v, "max_dz_ratio");
+  if (const auto v = json_find_string(s, "precision"); !v.empty()) o.rtm.precision = parse_wavefield_precision(v);
+  o.precision_report = json_find_bool(s, "precision_report", o.precision_report);
+  if (const auto v = json_find_number_token(s, "nfreq"); !v.empty()) o.rtm.nfreq = parse_num<std::size_t>(v, "nfreq");
+  if (const auto v = json_find_number_token(s, "freq_min"); !v.empty()) o.rtm.freq_min = parse_num<float>(v, "freq_min");
+  if (const auto v = json_find_number_token(s, "freq_max"); !v.empty()) o.rtm.freq_max = parse_num<float>(v, "freq_max");
+
+  if (const auto v = json_find_number_token(s, "shots"); !v.empty()) o.survey.shots = parse_num<std::size_t>(v, "shots");
+  if (const auto v = json_find_number_token(s, "first_shot_x"); !v.empty())
+    o.survey.first_shot_x = parse_num<float>(v, "first_shot_x");
+  if (const auto v = json_find_number_token(s, "last_shot_x"); !v.empty())
+    o.survey.last_shot_x = parse_num<float>(v, "last_shot_x");
+  if (const auto v = json_find_number_token(s, "aperture"); !v.empty()) o.survey.aperture = parse_num<float>(v, "aperture");
+  if (const auto v = json_find_number_token(s, "queue_depth"); !v.empty())
+    o.survey.queue_depth = parse_num<std::size_t>(v, "queue_depth");
+  if (const auto v = json_find_string(s, "checkpoint_dir"); !v.empty()) o.survey.checkpoint_dir = v;
+  if (const auto v = json_find_number_token(s, "checkpoint_every"); !v.empty())
+    o.survey.checkpoint_every = parse_num<std::size_t>(v, "checkpoint_every");
+  o.survey.resume = json_find_bool(s, "resume", o.survey.resume);
+  if (const auto v = json_find_string(s, "cache_dir"); !v.empty()) o.survey.cache_dir = v;
+  if (const auto v = json_find_string(s, "cache_max"); !v.empty()) o.survey.cache_max_bytes = parse_bytes(v, "cache_max");
+  if (const auto v = json_find_number_token(s, "state_checkpoint_steps"); !v.empty())
+    o.rtm.state_checkpoint_steps = parse_num<std::size_t>(v, "state_checkpoint_steps");
+
+  if (const auto v = json_find_string(s, "report_file"); !v.empty()) o.report_file = v;
+  o.perf_counters = json_find_bool(s, "perf_counters", o.perf_counters);
+  o.autotune = json_find_bool(s, "autotune", o.autotune);
+  if (const auto v = json_find_string(s, "tuning_cache"); !v.empty()) o.tuning_cache = v;
 }
 
 void validate(const CliOptions& o) {
-  if (o.x_file.empty() || o.z_file.empty() || o.values_file.empty()) {
-    throw std::runtime_error("x/z/values input files are required (or --data-dir / --config)");
+  if (o.model_3d.empty() && (o.x_file.empty() || o.z_file.empty() || o.values_file.empty())) {
+    throw std::runtime_error("x/z/values input files are required (or --data-dir / --config / --model-3d)");
   }
   if (o.load.decim_x == 0 || o.load.decim_z == 0) throw std::runtime_error("decimation must be >= 1");
   if (o.rtm.ny < 4 || o.rtm.nt < 2) throw std::runtime_error("ny>=4 and nt>=2 required");
   if (o.rtm.dy <= 0 || o.rtm.dt <= 0 || o.rtm.f0 <= 0) throw std::runtime_error("dy/dt/f0 must be > 0");
   if (o.rtm.pml == 0) throw std::runtime_error("pml must be > 0");
   if (o.rtm.receiver_stride == 0) throw std::runtime_error("receiver-stride must be > 0");
+  if (o.rtm.ranks == 0) throw std::runtime_error("ranks must be > 0");
+  if (o.plan.record_length < 0 || o.plan.points_per_wavelength < 0) {
+    throw std::runtime_error("record-length/ppw must be >= 0");
+  }
+  if (o.rtm.freq_min < 0 || o.rtm.freq_max < 0) throw std::runtime_error("freq-min/freq-max must be >= 0");
+  if (o.rtm.ranks > 1 && o.rtm.imaging != ImagingCondition::kCrossCorrelation) {
+    throw std::runtime_error("--ranks > 1 supports only cross_correlation imaging");
+  }
+  if (o.rtm.precision != WavefieldPrecision::kFloat32) {
+    if (o.rtm.propagator != PropagatorKind::kFiniteDifference) {
+      throw std::runtime_error("--precision fp16/bf16 requires --propagator fd");
+    }
+    if (o.rtm.ranks > 1) throw std::runtime_error("--precision fp16/bf16 supports only single-process runs");
+    if (o.rtm.state_checkpoint_steps > 0) {
+      throw std::runtime_error("--precision fp16/bf16 does not support --state-checkpoint-steps");
+    }
+    if (o.rtm.snapshot_strategy == SnapshotStrategy::kCheckpointed && !checkpointed_supported(o.rtm)) {
+      throw std::runtime_error("--precision fp16/bf16 does not support --snapshot-strategy checkpointed");
+    }
+  }
+  if (!(o.rtm.max_dz_ratio >= 1.0f)) throw std::runtime_error("max-dz-ratio must be >= 1");
+  if (o.rtm.max_dz_ratio > 1.0f) {
+    if (o.rtm.propagator != PropagatorKind::kFiniteDifference) {
+      throw std::runtime_error("--max-dz-ratio requires --propagator fd");
+    }
+    if (o.rtm.ranks > 1) throw std::runtime_error("--max-dz-ratio supports only single-process runs");
+    if (o.rtm.precision != WavefieldPrecision::kFloat32) {
+      throw std::runtime_error("--max-dz-ratio requires --precision fp32");
+    }
+  }
+  if (o.precision_report && o.mode == RunMode::kModel) throw std::runtime_error("--precision-report requires --mode migrate");
+  if (o.survey.shots == 0) throw std::runtime_error("shots must be > 0");
+  if (o.survey.aperture < 0 || o.survey.first_shot_x < 0 || o.survey.last_shot_x < 0) {
+    throw std::runtime_error("aperture/first-shot-x/last-shot-x must be >= 0");
+  }
+  if (o.survey.checkpoint_every == 0) throw std::runtime_error("checkpoint-every must be > 0");
+  if (o.survey.queue_depth == 0) throw std::runtime_error("queue-depth must be > 0");
+  if (o.survey.resume && o.survey.checkpoint_dir.empty()) throw std::runtime_error("--resume requires --checkpoint-dir");
+  if (!o.survey.cache_dir.empty() && (o.mode != RunMode::kMigrate || !o.model_3d.empty())) {
+    throw std::runtime_error("--cache-dir supports only --mode migrate on a 2D model");
+  }
+  if (o.survey.cache_max_bytes > 0 && o.survey.cache_dir.empty()) throw std::runtime_error("--cache-max requires --cache-dir");
+  if (o.rtm.state_checkpoint_steps > 0) {
+    if (o.survey.checkpoint_dir.empty()) throw std::runtime_error("--state-checkpoint-steps requires --checkpoint-dir");
+    if (o.rtm.imaging != ImagingCondition::kFrequencyDomain) {
+      throw std::runtime_error("--state-checkpoint-steps requires --imaging frequency");
+    }
+  }
+  if (o.mode == RunMode::kModel) {
+    if (o.rtm.ranks > 1) throw std::runtime_error("--mode model supports only single-process shots");
+    if (!o.survey.checkpoint_dir.empty()) throw std::runtime_error("--mode model does not checkpoint");
+    if (o.gather_dir.empty()) throw std::runtime_error("--gather-dir must not be empty");
+  }
+  if (o.mode == RunMode::kWorker || o.mode == RunMode::kReduce || o.mode == RunMode::kCoordinate) {
+    if (o.job.dir.empty()) throw std::runtime_error("--mode worker/reduce/coordinate requires --job-dir");
+    if (o.rtm.ranks > 1) throw std::runtime_error("job modes support only single-process shots");
+    if (!o.survey.checkpoint_dir.empty() || o.rtm.state_checkpoint_steps > 0) {
+      throw std::runtime_error("job modes keep partial images instead of checkpoints");
+    }
+    if (o.precision_report) throw std::runtime_error("--precision-report requires --mode migrate");
+  }
+  if (o.workers == 0) throw std::runtime_error("workers must be > 0");
+  if (!(o.job.lease_seconds > 0)) throw std::runtime_error("lease-seconds must be > 0");
+  if (!o.model_3d.empty()) {
+    if (o.mode != RunMode::kMigrate) throw std::runtime_error("--model-3d supports only --mode migrate");
+    if (o.plan_mode != PlanMode::kOff || o.autotune || o.precision_report) {
+      throw std::runtime_error("--model-3d does not support --plan, --auto-plan, --autotune or --precision-report");
+    }
+    if (o.rtm.ranks > 1 || o.rtm.max_dz_ratio > 1.0f) {
+      throw std::runtime_error("--model-3d supports only single-process shots on the uniform depth grid");
+    }
+    if (!o.survey.checkpoint_dir.empty()) throw std::runtime_error("--model-3d does not checkpoint");
+  }
+  if (o.autotune && o.rtm.ranks > 1) throw std::runtime_error("--autotune supports only single-process runs");
+  if (o.autotune && (o.rtm.precision != WavefieldPrecision::kFloat32 || o.rtm.max_dz_ratio > 1.0f)) {
+    throw std::runtime_error("--autotune requires --precision fp32 and --max-dz-ratio 1");
+  }
+  if (o.rtm.ranks > 1 && o.rtm.snapshot_strategy != SnapshotStrategy::kAuto &&
+      o.rtm.snapshot_strategy != SnapshotStrategy::kFull) {
+    throw std::runtime_error("--ranks > 1 supports only full snapshots");
+  }
+  if (o.rtm.snapshot_strategy == SnapshotStrategy::kRandomBoundary && !random_boundary_supported(o.rtm)) {
+    throw std::runtime_error("--snapshot-strategy random_boundary needs the fp32 fd propagator and --max-dz-ratio 1");
+  }
 }
 
 }  // namespace
 
 std::string cli_help() {
   return "Usage: rtm3d_cli [options]\n"
+         "Mode:\n"
+         "  --mode <migrate|model|worker|reduce|coordinate>\n"
+         "                                model: forward-model the shots and write gathers only\n"
+         "                                worker: migrate shots leased from --job-dir\n"
+         "                                reduce: stack the partial images in --job-dir\n"
+         "                                coordinate: run --workers workers on --job-dir and reduce\n"
+         "  --gather-dir <dir>            --mode model output directory (default output/gathers)\n"
+         "Job directory:\n"
+         "  --job-dir <dir>               Shared leases and partial images of the job modes\n"
+         "  --workers <n>                 --mode coordinate worker processes (default 2)\n"
+         "  --lease-seconds <s>           Heartbeat age after which a shot is re-queued (default 30)\n"
          "Input model:\n"
          "  --config <file.json>          JSON config file (recommended)\n"
          "  --data-dir <dir>              Directory containing x.json z.json vel.json\n"
          "  --x-file <path>               X axis JSON array\n"
          "  --z-file <path>               Z axis JSON array\n"
          "  --values-file <path>          2D values JSON array\n"
+         "  --model-3d <file>             3D float32 model [nz][ny][nx] with <file>.json header; shots\n"
+         "                                on its middle y row, windows paged in from disk per shot\n"
          "Load options:\n"
          "  --decim-x <n> --decim-z <n>   Decimation factors (>=1)\n"
          "  --crop-x <n> --crop-z <n>     Crop size (0 means full)\n"
          "RTM options:\n"
          "  --ny <n> --dy <m> --dt <s> --nt <n> --f0 <Hz> --pml <n> --receiver-stride <n>\n"
+         "  --propagator <fd|pseudo_spectral>\n"
+         "  --max-dz-ratio <r>            >1: stretch dz with depth up to r*dz where the velocity\n"
+         "                                allows; the image is mapped back to the model rows (fd)\n"
+         "Planning:\n"
+         "  --plan                        Print the CFL/sampling plan and cost before running\n"
+         "  --auto-plan                   Print and apply the plan (overrides decim/crop/ny/dy/dt/nt)\n"
+         "  --record-length <s>           Record length the plan must cover (default nt*dt)\n"
+         "  --ppw <n>                     Points per shortest wavelength (default fd 10, spectral 3)\n"
+         "Parallelism:\n"
+         "  --threads <n>                 Kernel threads per process (0 = all cores)\n"
+         "  --ranks <n>                   Split the grid into z-slabs over n local processes\n"
+         "  --autotune                    Time kernel loop orders/tiles/threads on a shot's grid and\n"
+         "                                reuse the winner from the per-host tuning cache\n"
+         "  --tuning-cache <file.json>    Tuning cache (default ~/.cache/rtm3d/tuning.json)\n"
+         "Imaging:\n"
+         "  --imaging <cross_correlation|frequency>\n"
+         "                                frequency: running DFTs instead of source snapshots\n"
+         "  --nfreq <n>                   Frequencies imaged (0 = DFT spacing 1/(nt*dt))\n"
+         "  --freq-min <Hz> --freq-max <Hz>  Imaged band (default 0 .. 2.5*f0)\n"
+         "  --precision <fp32|fp16|bf16>  Live wavefield storage; fp16/bf16 compute in fp32 (fd only)\n"
+         "  --precision-report            Compare one shot against fp32, write <output>.precision.json\n"
+         "Memory:\n"
+         "  --snapshot-strategy <auto|full|subsampled|compressed|checkpointed|spill|random_boundary>\n"
+         "  --max-memory <bytes[K|M|G]>   Budget for --snapshot-strategy auto (default available RAM)\n"
+         "  --snapshot-stride <n>         Subsampled: keep every n-th step (0 = Nyquist of 2*fmax)\n"
+         "  --checkpoint-interval <n>     Checkpointed: steps per replay segment (0 = sqrt(nt))\n"
+         "  --spill-dir <dir>             Spill: directory for the snapshot scratch file\n"
+         "Survey:\n"
+         "  --shots <n>                   Shots evenly spaced along x, migrated and stacked (default 1)\n"
+         "  --first-shot-x <m> --last-shot-x <m>  Shot span (default: centres of n equal segments)\n"
+         "  --aperture <m>                Half-width of the model window migrated per shot (0 = all)\n"
+         "  --queue-depth <n>             Shots buffered between the prepare/migrate/stack stages (default 2)\n"
+         "Checkpoint/restart:\n"
+         "  --checkpoint-dir <dir>        Write the stacked image and shot ledger there atomically\n"
+         "  --checkpoint-every <n>        Shots between checkpoints (default 1)\n"
+         "  --resume                      Skip shots in the ledger and continue the stack\n"
+         "  --state-checkpoint-steps <n>  Also checkpoint wavefields every n steps inside a shot\n"
+         "                                (frequency imaging only)\n"
+         "Shot image cache:\n"
+         "  --cache-dir <dir>             Keep each shot's image there by content hash; reruns stack\n"
+         "                                unchanged shots from it instead of migrating them\n"
+         "  --cache-max <bytes[K|M|G]>    Evict least recently used images beyond this size (default no cap)\n"
          "Output:\n"
          "  --output <path>               Output file path\n"
          "  --output-format <pgm8|float32_raw>\n"
+         "  --report <path>               Run report JSON (default <output>.report.json)\n"
+         "  --perf-counters               Add cycles/instructions/LLC misses to the report\n"
          "Other:\n"
          "  --help                         Show this message\n";
 }
@@ -141,16 +404,32 @@ CliOptions parse_cli_or_throw(int argc, char** argv) {
       apply_json_config(o, require_value(argc, argv, i));
     } else if (arg == "--data-dir") {
       apply_data_dir(o, require_value(argc, argv, i));
+    } else if (arg == "--model-3d") {
+      o.model_3d = require_value(argc, argv, i);
     } else if (arg == "--x-file") {
       o.x_file = require_value(argc, argv, i);
     } else if (arg == "--z-file") {
       o.z_file = require_value(argc, argv, i);
     } else if (arg == "--values-file") {
       o.values_file = require_value(argc, argv, i);
+    } else if (arg == "--mode") {
+      o.mode = parse_run_mode_or_throw(require_value(argc, argv, i), "--mode");
+    } else if (arg == "--gather-dir") {
+      o.gather_dir = require_value(argc, argv, i);
+    } else if (arg == "--job-dir") {
+      o.job.dir = require_value(argc, argv, i);
+    } else if (arg == "--workers") {
+      o.workers = parse_num<std::size_t>(require_value(argc, argv, i), "--workers");
+    } else if (arg == "--lease-seconds") {
+      o.job.lease_seconds = parse_num<float>(require_value(argc, argv, i), "--lease-seconds");
     } else if (arg == "--output") {
       o.output_file = require_value(argc, argv, i);
     } else if (arg == "--output-format") {
       o.output_format = parse_output_format_or_throw(require_value(argc, argv, i), "--output-format");
+    } else if (arg == "--report") {
+      o.report_file = require_value(argc, argv, i);
+    } else if (arg == "--perf-counters") {
+      o.perf_counters = true;
     } else if (arg == "--decim-x") {
       o.load.decim_x = parse_num<std::size_t>(require_value(argc, argv, i), "--decim-x");
     } else if (arg == "--decim-z") {
@@ -173,6 +452,70 @@ CliOptions parse_cli_or_throw(int argc, char** argv) {
       o.rtm.pml = parse_num<std::size_t>(require_value(argc, argv, i), "--pml");
     } else if (arg == "--receiver-stride") {
       o.rtm.receiver_stride = parse_num<std::size_t>(require_value(argc, argv, i), "--receiver-stride");
+    } else if (arg == "--plan") {
+      o.plan_mode = PlanMode::kPrint;
+    } else if (arg == "--auto-plan") {
+      o.plan_mode = PlanMode::kApply;
+    } else if (arg == "--record-length") {
+      o.plan.record_length = parse_num<float>(require_value(argc, argv, i), "--record-length");
+    } else if (arg == "--ppw") {
+      o.plan.points_per_wavelength = parse_num<float>(require_value(argc, argv, i), "--ppw");
+    } else if (arg == "--propagator") {
+      o.rtm.propagator = parse_propagator_or_throw(require_value(argc, argv, i), "--propagator");
+    } else if (arg == "--threads") {
+      o.rtm.threads = parse_num<std::size_t>(require_value(argc, argv, i), "--threads");
+    } else if (arg == "--ranks") {
+      o.rtm.ranks = parse_num<std::size_t>(require_value(argc, argv, i), "--ranks");
+    } else if (arg == "--imaging") {
+      o.rtm.imaging = parse_imaging_or_throw(require_value(argc, argv, i), "--imaging");
+    } else if (arg == "--max-dz-ratio") {
+      o.rtm.max_dz_ratio = parse_num<float>(require_value(argc, argv, i), "--max-dz-ratio");
+    } else if (arg == "--precision") {
+      o.rtm.precision = parse_wavefield_precision(require_value(argc, argv, i));
+    } else if (arg == "--precision-report") {
+      o.precision_report = true;
+    } else if (arg == "--nfreq") {
+      o.rtm.nfreq = parse_num<std::size_t>(require_value(argc, argv, i), "--nfreq");
+    } else if (arg == "--freq-min") {
+      o.rtm.freq_min = parse_num<float>(require_value(argc, argv, i), "--freq-min");
+    } else if (arg == "--freq-max") {
+      o.rtm.freq_max = parse_num<float>(require_value(argc, argv, i), "--freq-max");
+    } else if (arg == "--autotune") {
+      o.autotune = true;
+    } else if (arg == "--tuning-cache") {
+      o.tuning_cache = require_value(argc, argv, i);
+    } else if (arg == "--shots") {
+      o.survey.shots = parse_num<std::size_t>(require_value(argc, argv, i), "--shots");
+    } else if (arg == "--first-shot-x") {
+      o.survey.first_shot_x = parse_num<float>(require_value(argc, argv, i), "--first-shot-x");
+    } else if (arg == "--last-shot-x") {
+      o.survey.last_shot_x = parse_num<float>(require_value(argc, argv, i), "--last-shot-x");
+    } else if (arg == "--aperture") {
+      o.survey.aperture = parse_num<float>(require_value(argc, argv, i), "--aperture");
+    } else if (arg == "--queue-depth") {
+      o.survey.queue_depth = parse_num<std::size_t>(require_value(argc, argv, i), "--queue-depth");
+    } else if (arg == "--checkpoint-dir") {
+      o.survey.checkpoint_dir = require_value(argc, argv, i);
+    } else if (arg == "--checkpoint-every") {
+      o.survey.checkpoint_every = parse_num<std::size_t>(require_value(argc, argv, i), "--checkpoint-every");
+    } else if (arg == "--cache-dir") {
+      o.survey.cache_dir = require_value(argc, argv, i);
+    } else if (arg == "--cache-max") {
+      o.survey.cache_max_bytes = parse_bytes(require_value(argc, argv, i), "--cache-max");
+    } else if (arg == "--resume") {
+      o.survey.resume = true;
+    } else if (arg == "--state-checkpoint-steps") {
+      o.rtm.state_checkpoint_steps = parse_num<std::size_t>(require_value(argc, argv, i), "--state-checkpoint-steps");
+    } else if (arg == "--snapshot-strategy") {
+      o.rtm.snapshot_strategy = parse_snapshot_strategy_or_throw(require_value(argc, argv, i), "--snapshot-strategy");
+    } else if (arg == "--snapshot-stride") {
+      o.rtm.snapshot_stride = parse_num<std::size_t>(require_value(argc, argv, i), "--snapshot-stride");
+    } else if (arg == "--checkpoint-interval") {
+      o.rtm.checkpoint_interval = parse_num<std::size_t>(require_value(argc, argv, i), "--checkpoint-interval");
+    } else if (arg == "--max-memory") {
+      o.rtm.max_memory_bytes = parse_bytes(require_value(argc, argv, i), "--max-memory");
+    } else if (arg == "--spill-dir") {
+      o.rtm.spill_dir = require_value(argc, argv, i);
     } else if (is_flag(arg)) {
       throw std::runtime_error("unknown option: " + arg);
     } else {
@@ -0,0 +1,99 @@
+#include "rtm3d/io/GatherIO.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace rtm3d {
+
+static void validate_gather(const ShotGather& g) {
+  if (g.receiver_x.empty() || g.nt == 0) throw std::runtime_error("invalid gather shape");
+  if (g.traces.size() != g.receiver_x.size() * g.nt) throw std::runtime_error("gather size mismatch");
+}
+
+template <typename T>
+static void put_be(std::vector<unsigned char>& buf, std::size_t offset, T value) {
+  using U = std::make_unsigned_t<T>;
+  const auto u = static_cast<U>(value);
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    buf[offset + i] = static_cast<unsigned char>(u >> (8 * (sizeof(T) - 1 - i)));
+  }
+}
+
+void write_gather_float32(const std::string& path, const ShotGather& gather) {
+  validate_gather(gather);
+
+  std::ofstream f(path, std::ios::binary);
+  if (!f) throw std::runtime_error("cannot write gather: " + path);
+  f.write(reinterpret_cast<const char*>(gather.traces.data()),
+          static_cast<std::streamsize>(gather.traces.size() * sizeof(float)));
+
+  const std::size_t nrec = gather.receiver_x.size();
+  const float receiver_dx = nrec > 1 ? gather.receiver_x[1] - gather.receiver_x[0] : 0.0f;
+  const std::string hdr_path = path + ".json";
+  std::ofstream h(hdr_path);
+  if (!h) throw std::runtime_error("cannot write header: " + hdr_path);
+  h << "{\n"
+    << "  \"n_receivers\": " << nrec << ",\n"
+    << "  \"nt\": " << gather.nt << ",\n"
+    << "  \"dt\": " << gather.dt << ",\n"
+    << "  \"shot_x\": " << gather.shot_x << ",\n"
+    << "  \"shot_z\": " << gather.shot_z << ",\n"
+    << "  \"receiver_x0\": " << gather.receiver_x[0] << ",\n"
+    << "  \"receiver_dx\": " << receiver_dx << ",\n"
+    << "  \"dtype\": \"float32\",\n"
+    << "  \"order\": \"row-major [n_receivers][nt]\",\n"
+    << "  \"units\": \"arbitrary amplitude\"\n"
+    << "}\n";
+}
+
+void write_segy_like(const std::string& path, const ShotGather& gather) {
+  validate_gather(gather);
+  if (gather.nt > 32767) throw std::runtime_error("SEG-Y-like traces hold at most 32767 samples");
+  const auto dt_us = static_cast<std::int16_t>(std::lround(gather.dt * 1e6));
+
+  std::ofstream f(path, std::ios::binary);
+  if (!f) throw std::runtime_error("cannot write gather: " + path);
+
+  std::string text =
+      "C01 RTM3D SYNTHETIC SEG-Y-LIKE FILE\n"
+      "C02 NOT FULL SEG-Y COMPLIANCE; CORE HEADER+TRACE STRUCTURE ONLY\n"
+      "C03 SAMPLES: IEEE FLOAT32 BIG-ENDIAN\n"
+      "C04 GENERATED BY rtm3d_cli --mode model\n";
+  text.resize(3200, ' ');
+  f.write(text.data(), static_cast<std::streamsize>(text.size()));
+
+  std::vector<unsigned char> bh(400, 0);
+  put_be<std::int16_t>(bh, 16, dt_us);                                 // sample interval
+  put_be<std::int16_t>(bh, 20, static_cast<std::int16_t>(gather.nt));  // samples per trace
+  put_be<std::int16_t>(bh, 24, 5);                                     // format 5: IEEE float
+  f.write(reinterpret_cast<const char*>(bh.data()), static_cast<std::streamsize>(bh.size()));
+
+  std::vector<unsigned char> th(240);
+  std::vector<unsigned char> samples(gather.nt * sizeof(float));
+  for (std::size_t tr = 0; tr < gather.receiver_x.size(); ++tr) {
+    std::fill(th.begin(), th.end(), 0);
+    put_be<std::int32_t>(th, 0, static_cast<std::int32_t>(tr + 1));
+    put_be<std::int32_t>(th, 20, static_cast<std::int32_t>(tr + 1));
+    put_be<std::int32_t>(th, 36, static_cast<std::int32_t>(gather.shot_x));
+    put_be<std::int32_t>(th, 40, static_cast<std::int32_t>(gather.receiver_x[tr]));
+    put_be<std::int16_t>(th, 114, static_cast<std::int16_t>(gather.nt));
+    put_be<std::int16_t>(th, 116, dt_us);
+    f.write(reinterpret_cast<const char*>(th.data()), static_cast<std::streamsize>(th.size()));
+
+    const float* trace = gather.traces.data() + tr * gather.nt;
+    for (std::size_t it = 0; it < gather.nt; ++it) {
+      std::uint32_t bits = 0;
+      std::memcpy(&bits, &trace[it], sizeof(bits));
+      put_be<std::uint32_t>(samples, it * sizeof(float), bits);
+    }
+    f.write(reinterpret_cast<const char*>(samples.data()), static_cast<std::streamsize>(samples.size()));
+  }
+  if (!f) throw std::runtime_error("cannot write gather: " + path);
+}
+
+}  // namespace rtm3d
@@ -0,0 +1,169 @@
+#include "rtm3d/io/GridModel3D.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace rtm3d {
+namespace {
+
+std::string header_value(const std::string& s, const std::string& key, const std::string& path) {
+  std::smatch m;
+  if (!std::regex_search(s, m, std::regex("\"" + key + "\"\\s*:\\s*([-+0-9eE.]+)"))) {
+    throw std::runtime_error("3D model header " + path + " lacks \"" + key + "\"");
+  }
+  return m[1].str();
+}
+
+// [begin, end) widened to whole pages; the mapping itself starts on a page boundary.
+std::pair<std::size_t, std::size_t> page_span(std::size_t begin, std::size_t end) {
+  const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return {begin / page * page, (end + page - 1) / page * page};
+}
+
+}  // namespace
+
+GridModel3D GridModel3D::open(const std::string& path) {
+  std::ifstream h(path + ".json");
+  if (!h) throw std::runtime_error("cannot open 3D model header: " + path + ".json");
+  std::ostringstream ss;
+  ss << h.rdbuf();
+  const std::string s = ss.str();
+
+  GridModel3D m;
+  m.nx_ = std::stoul(header_value(s, "nx", path));
+  m.ny_ = std::stoul(header_value(s, "ny", path));
+  m.nz_ = std::stoul(header_value(s, "nz", path));
+  m.dx_ = std::stof(header_value(s, "dx", path));
+  m.dy_ = std::stof(header_value(s, "dy", path));
+  m.dz_ = std::stof(header_value(s, "dz", path));
+  if (m.nx_ == 0 || m.ny_ == 0 || m.nz_ == 0) throw std::runtime_error("empty 3D model: " + path);
+  if (!(m.dx_ > 0.0f && m.dy_ > 0.0f && m.dz_ > 0.0f)) throw std::runtime_error("invalid 3D model spacing: " + path);
+
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) throw std::runtime_error("cannot open 3D model " + path + ": " + std::strerror(errno));
+  struct stat st {};
+  const std::size_t bytes = m.nx_ * m.ny_ * m.nz_ * sizeof(float);
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) != bytes) {
+    ::close(fd);
+    throw std::runtime_error("3D model " + path + " does not hold " + std::to_string(bytes) + " bytes");
+  }
+  void* p = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) throw std::runtime_error("cannot map 3D model " + path + ": " + std::strerror(errno));
+  // Windows are read a few rows per plane at a time; readahead of whole plane runs would page in
+  // the rest of the model.
+  ::madvise(p, bytes, MADV_RANDOM);
+  m.data_ = static_cast<const float*>(p);
+  m.mapped_bytes_ = bytes;
+  return m;
+}
+
+GridModel3D::~GridModel3D() {
+  if (data_) ::munmap(const_cast<float*>(data_), mapped_bytes_);
+}
+
+GridModel3D::GridModel3D(GridModel3D&& other) noexcept { *this = std::move(other); }
+
+GridModel3D& GridModel3D::operator=(GridModel3D&& other) noexcept {
+  if (this != &other) {
+    if (data_) ::munmap(const_cast<float*>(data_), mapped_bytes_);
+    nx_ = other.nx_;
+    ny_ = other.ny_;
+    nz_ = other.nz_;
+    dx_ = other.dx_;
+    dy_ = other.dy_;
+    dz_ = other.dz_;
+    data_ = std::exchange(other.data_, nullptr);
+    mapped_bytes_ = std::exchange(other.mapped_bytes_, 0);
+  }
+  return *this;
+}
+
+void GridModel3D::check_planes(std::size_t iz0, std::size_t iz1) const {
+  if (!data_) throw std::runtime_error("3D model is not open");
+  if (iz0 > iz1 || iz1 > nz_) throw std::runtime_error("3D model planes out of range");
+}
+
+std::span<const float> GridModel3D::z_slab(std::size_t iz0, std::size_t iz1) const {
+  check_planes(iz0, iz1);
+  const std::size_t plane = nx_ * ny_;
+  return {data_ + iz0 * plane, (iz1 - iz0) * plane};
+}
+
+void GridModel3D::evict(std::size_t iz0, std::size_t iz1) const {
+  check_planes(iz0, iz1);
+  if (iz0 == iz1) return;
+  const std::size_t plane_bytes = nx_ * ny_ * sizeof(float);
+  const auto [begin, end] = page_span(iz0 * plane_bytes, iz1 * plane_bytes);
+  auto* base = reinterpret_cast<char*>(const_cast<float*>(data_));
+  ::madvise(base + begin, std::min(end, mapped_bytes_) - begin, MADV_DONTNEED);
+}
+
+Volume3D GridModel3D::read_window(std::size_t x0, std::size_t x1, std::size_t y0, std::size_t y1) const {
+  check_planes(0, nz_);
+  if (x0 >= x1 || x1 > nx_ || y0 >= y1 || y1 > ny_) throw std::runtime_error("3D model window out of range");
+  Volume3D vel(x1 - x0, y1 - y0, nz_);
+  auto* base = reinterpret_cast<char*>(const_cast<float*>(data_));
+  // Byte range of a plane's window rows, from the first row's x0 to the last row's x1.
+  const auto rows = [&](std::size_t iz) {
+    const std::size_t first = ((iz * ny_ + y0) * nx_ + x0) * sizeof(float);
+    const std::size_t last = ((iz * ny_ + y1 - 1) * nx_ + x1) * sizeof(float);
+    return page_span(first, last);
+  };
+  for (std::size_t iz = 0; iz < nz_; ++iz) {
+    if (iz + 1 < nz_) {
+      const auto [begin, end] = rows(iz + 1);
+      ::madvise(base + begin, std::min(end, mapped_bytes_) - begin, MADV_WILLNEED);
+    }
+    for (std::size_t iy = y0; iy < y1; ++iy) {
+      const float* src = data_ + (iz * ny_ + iy) * nx_ + x0;
+      std::copy_n(src, x1 - x0, &vel(0, iy - y0, iz));
+    }
+    const auto [begin, end] = rows(iz);
+    ::madvise(base + begin, std::min(end, mapped_bytes_) - begin, MADV_DONTNEED);
+  }
+  return vel;
+}
+
+GridModel2D GridModel3D::inline_section(std::size_t iy) const {
+  check_planes(0, nz_);
+  if (iy >= ny_) throw std::runtime_error("3D model row out of range");
+  const auto slice = read_window(0, nx_, iy, iy + 1);
+  return {.nx = nx_, .nz = nz_, .dx = dx_, .dz = dz_, .values = slice.raw()};
+}
+
+void write_grid_model_3d(const std::string& path, std::size_t nx, std::size_t ny, std::size_t nz, float dx, float dy,
+                         float dz, const std::vector<float>& values) {
+  if (values.size() != nx * ny * nz) throw std::runtime_error("3D model size mismatch");
+  std::ofstream f(path, std::ios::binary);
+  if (!f) throw std::runtime_error("cannot write 3D model: " + path);
+  f.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(float)));
+  if (!f) throw std::runtime_error("cannot write 3D model: " + path);
+
+  std::ofstream h(path + ".json");
+  if (!h) throw std::runtime_error("cannot write header: " + path + ".json");
+  h << "{\n"
+    << "  \"nx\": " << nx << ",\n"
+    << "  \"ny\": " << ny << ",\n"
+    << "  \"nz\": " << nz << ",\n"
+    << "  \"dx\": " << dx << ",\n"
+    << "  \"dy\": " << dy << ",\n"
+    << "  \"dz\": " << dz << ",\n"
+    << "  \"dtype\": \"float32\",\n"
+    << "  \"order\": \"row-major [nz][ny][nx]\",\n"
+    << "  \"units\": \"m/s\"\n"
+    << "}\n";
+}
+
+}  // namespace rtm3d
@@ -23,25 +23,40 @@ GridModel2D load_grid_model_from_json_arrays(const std::string& x_file,
     if (row.size() != x.size()) throw std::runtime_error("values col count must match x size");
   }
 
-  const std::size_t nx0 = x.size();
-  const std::size_t nz0 = z.size();
-  const std::size_t nx_max = (nx0 + opts.decim_x - 1) / opts.decim_x;
-  const std::size_t nz_max = (nz0 + opts.decim_z - 1) / opts.decim_z;
+  GridModel2D native;
+  native.nx = x.size();
+  native.nz = z.size();
+  native.dx = x[1] - x[0];
+  native.dz = z[1] - z[0];
+  native.values.resize(native.nx * native.nz);
+  for (std::size_t iz = 0; iz < native.nz; ++iz) {
+    std::copy(values[iz].begin(), values[iz].end(), native.values.begin() + iz * native.nx);
+  }
+
+  return resample_grid_model(native, opts);
+}
+
+GridModel2D resample_grid_model(const GridModel2D& model, const GridLoadOptions& opts) {
+  if (opts.decim_x == 0 || opts.decim_z == 0) throw std::runtime_error("decimation must be >= 1");
+  if (model.values.size() != model.nx * model.nz) throw std::runtime_error("model values size mismatch");
+
+  const std::size_t nx_max = (model.nx + opts.decim_x - 1) / opts.decim_x;
+  const std::size_t nz_max = (model.nz + opts.decim_z - 1) / opts.decim_z;
   const std::size_t nx = opts.crop_x == 0 ? nx_max : std::min(opts.crop_x, nx_max);
   const std::size_t nz = opts.crop_z == 0 ? nz_max : std::min(opts.crop_z, nz_max);
 
   GridModel2D out;
   out.nx = nx;
   out.nz = nz;
-  out.dx = (x[1] - x[0]) * static_cast<float>(opts.decim_x);
-  out.dz = (z[1] - z[0]) * static_cast<float>(opts.decim_z);
+  out.dx = model.dx * static_cast<float>(opts.decim_x);
+  out.dz = model.dz * static_cast<float>(opts.decim_z);
   out.values.resize(nx * nz);
 
   for (std::size_t iz = 0; iz < nz; ++iz) {
     const std::size_t src_z = iz * opts.decim_z;
     for (std::size_t ix = 0; ix < nx; ++ix) {
       const std::size_t src_x = ix * opts.decim_x;
-      out.values[iz * nx + ix] = values[src_z][src_x];
+      out.values[iz * nx + ix] = model.values[src_z * model.nx + src_x];
     }
   }
 
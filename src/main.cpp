@@ -1,28 +1,241 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
 #include <filesystem>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/io/GatherIO.hpp"
+#include "rtm3d/io/GridModel3D.hpp"
 #include "rtm3d/io/GridModelLoader.hpp"
 #include "rtm3d/io/ImageIO.hpp"
+#include "rtm3d/rtm/Autotuner.hpp"
+#include "rtm3d/rtm/JobQueue.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/Precision.hpp"
 #include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/RunPlanner.hpp"
+#include "rtm3d/rtm/RunProfile.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+namespace {
+
+rtm3d::GridModel2D load_model(rtm3d::CliOptions& cli) {
+  if (cli.plan_mode == rtm3d::PlanMode::kOff) {
+    return rtm3d::load_grid_model_from_json_arrays(cli.x_file, cli.z_file, cli.values_file, cli.load);
+  }
+
+  // Plan on the native sampling of the configured crop window, then resample in memory.
+  const rtm3d::GridLoadOptions native_opts{.decim_x = 1,
+                                           .decim_z = 1,
+                                           .crop_x = cli.load.crop_x * cli.load.decim_x,
+                                           .crop_z = cli.load.crop_z * cli.load.decim_z};
+  const auto native = rtm3d::load_grid_model_from_json_arrays(cli.x_file, cli.z_file, cli.values_file, native_opts);
+  const auto plan = rtm3d::plan_run(native, cli.rtm, cli.plan);
+  std::cout << rtm3d::format_plan(plan);
+  if (cli.plan_mode == rtm3d::PlanMode::kApply) {
+    rtm3d::apply_plan(plan, cli.load, cli.rtm);
+    std::cout << "plan applied\n";
+  }
+  return rtm3d::resample_grid_model(native, cli.load);
+}
+
+// --mode model: forward-model every shot and write its gather as float32 + JSON and SEG-Y-like.
+void run_modeling(const rtm3d::CliOptions& cli, const rtm3d::GridModel2D& model, rtm3d::RunProfile& profile) {
+  std::filesystem::create_directories(cli.gather_dir);
+  rtm3d::model_survey(
+      model, cli.rtm, cli.survey,
+      [&](std::size_t shot, const rtm3d::ShotGather& gather) {
+        char stem[32];
+        std::snprintf(stem, sizeof(stem), "/shot_%04zu", shot + 1);
+        rtm3d::write_gather_float32(cli.gather_dir + stem + "_gather.bin", gather);
+        rtm3d::write_segy_like(cli.gather_dir + stem + ".segy_like", gather);
+      },
+      &profile);
+
+  const auto report_file = cli.report_file.empty() ? cli.gather_dir + "/report.json" : cli.report_file;
+  rtm3d::write_run_report_json(report_file, profile, model, cli.rtm);
+  std::cout << "modeling finished\n"
+            << "model nx=" << model.nx << " nz=" << model.nz << " dx=" << model.dx << " dz=" << model.dz << "\n"
+            << "shots=" << cli.survey.shots << " gathers=" << cli.gather_dir << "\n"
+            << rtm3d::format_run_profile(profile) << "report=" << report_file << "\n";
+}
+
+// Resolves snapshot_strategy auto against the memory budget (cross-correlation imaging only).
+void plan_memory(rtm3d::CliOptions& cli, const rtm3d::GridModel2D& model, bool write_plan) {
+  if (cli.rtm.imaging == rtm3d::ImagingCondition::kFrequencyDomain) {
+    const auto bytes = rtm3d::estimate_frequency_imaging_bytes(model, cli.rtm);
+    std::cout << "imaging=frequency nfreq=" << rtm3d::imaging_frequencies(cli.rtm).size()
+              << " ram=" << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MiB\n";
+    return;
+  }
+  const auto memory = rtm3d::select_snapshot_strategy(model, cli.rtm);
+  cli.rtm.snapshot_strategy = memory.chosen;
+  if (write_plan) rtm3d::write_memory_plan_json(cli.output_file + ".memory.json", memory);
+  std::cout << "snapshots=" << rtm3d::snapshot_strategy_name(memory.chosen)
+            << " budget=" << static_cast<double>(memory.budget_bytes) / (1024.0 * 1024.0) << " MiB\n";
+  if (!memory.fits) std::cerr << "warning: no snapshot strategy fits the memory budget\n";
+}
+
+void write_image(const rtm3d::CliOptions& cli, const rtm3d::MigrationResult& migration, rtm3d::RunProfile& profile) {
+  const auto scope = profile.phase("output");
+  if (cli.output_format == rtm3d::OutputFormat::kFloat32Raw) {
+    rtm3d::write_float32_raw(cli.output_file, migration.inline_xz, migration.nx, migration.nz);
+  } else {
+    rtm3d::write_pgm(cli.output_file, migration.inline_xz, migration.nx, migration.nz);
+  }
+}
+
+// --mode worker: migrate leased shots until the job is done. Each worker keeps its own report in
+// <job-dir>/reports so several of them never write the same file.
+void run_worker(rtm3d::CliOptions& cli, const rtm3d::GridModel2D& model, rtm3d::RunProfile& profile) {
+  rtm3d::init_job_dir(model, cli.rtm, cli.survey, cli.job);
+  cli.rtm = rtm3d::job_config(cli.rtm, cli.job);
+  plan_memory(cli, model, false);
+  const auto shots = rtm3d::run_job_worker(model, cli.rtm, cli.survey, cli.job, &profile);
+
+  std::filesystem::create_directories(cli.job.dir + "/reports");
+  const auto report_file = cli.job.dir + "/reports/worker_" + std::to_string(::getpid()) + ".json";
+  rtm3d::write_run_report_json(report_file, profile, model, cli.rtm);
+  std::cout << "worker finished\n"
+            << "shots=" << shots << " job=" << cli.job.dir << "\n"
+            << rtm3d::format_run_profile(profile) << "report=" << report_file << "\n";
+}
+
+pid_t spawn_worker(const std::vector<std::string>& args) {
+  const pid_t pid = ::fork();
+  if (pid < 0) throw std::runtime_error("cannot fork a worker process");
+  if (pid == 0) {
+    std::vector<char*> argv;
+    for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+    ::execv("/proc/self/exe", argv.data());
+    std::perror("execv");
+    ::_exit(127);
+  }
+  return pid;
+}
+
+// --mode coordinate: runs cli.workers copies of this command line in --mode worker on the job.
+rtm3d::SurveyResult run_coordinator(const rtm3d::CliOptions& cli, const rtm3d::GridModel2D& model, int argc,
+                                    char** argv) {
+  std::vector<std::string> args(argv, argv + argc);
+  args.insert(args.end(), {"--mode", "worker"});
+  auto run = rtm3d::run_job_coordinator(model, cli.rtm, cli.survey, cli.job, cli.workers,
+                                        [&] { return spawn_worker(args); }, std::cerr);
+  std::cout << "workers=" << cli.workers << " restarts=" << run.restarts << "\n";
+  return std::move(run.survey);
+}
+
+// --model-3d: migrate the survey over the memory-mapped 3D model. The inline section under the
+// shots stands in for the 2D model in the memory plan and the run report.
+int run_3d_survey(rtm3d::CliOptions& cli, rtm3d::RunProfile& profile) {
+  rtm3d::GridModel3D model;
+  rtm3d::GridModel2D section;
+  {
+    const auto scope = profile.phase("load_model");
+    model = rtm3d::GridModel3D::open(cli.model_3d);
+    section = model.inline_section(model.ny() / 2);
+  }
+  cli.rtm.ny = std::min(cli.rtm.ny, model.ny());
+  cli.rtm.dy = model.dy();
+  std::filesystem::create_directories(std::filesystem::path(cli.output_file).parent_path());
+  plan_memory(cli, section, true);
+
+  const auto survey = rtm3d::run_survey(model, cli.rtm, cli.survey, &profile);
+  write_image(cli, survey.stack, profile);
+  const auto report_file = cli.report_file.empty() ? cli.output_file + ".report.json" : cli.report_file;
+  rtm3d::write_run_report_json(report_file, profile, section, cli.rtm);
+  std::cout << "RTM finished\n"
+            << "model nx=" << model.nx() << " ny=" << model.ny() << " nz=" << model.nz() << " dx=" << model.dx()
+            << " dy=" << model.dy() << " dz=" << model.dz() << "\n"
+            << "shots=" << survey.shots << "\n"
+            << "output=" << cli.output_file << "\n"
+            << rtm3d::format_run_profile(profile) << "report=" << report_file << "\n";
+  return 0;
+}
+
+}  // namespace
 
 int main(int argc, char** argv) {
   try {
-    const auto cli = rtm3d::parse_cli_or_throw(argc, argv);
+    auto cli = rtm3d::parse_cli_or_throw(argc, argv);
+
+    // Counters follow the calling thread only; kernel threads and slab ranks would go uncounted.
+    const bool single_thread = cli.rtm.threads == 1 && cli.rtm.ranks <= 1;
+    if (cli.perf_counters && !single_thread) {
+      std::cerr << "warning: --perf-counters needs --threads 1 and --ranks 1, reporting timings only\n";
+    }
+    rtm3d::RunProfile profile(cli.perf_counters && single_thread);
+    if (cli.perf_counters && single_thread && !profile.hw_counters_available()) {
+      std::cerr << "warning: perf_event_open unavailable, reporting timings only\n";
+    }
 
-    const auto model = rtm3d::load_grid_model_from_json_arrays(cli.x_file, cli.z_file, cli.values_file, cli.load);
-    const auto migration = rtm3d::run_single_shot_rtm(model, cli.rtm);
+    if (!cli.model_3d.empty()) return run_3d_survey(cli, profile);
 
+    rtm3d::GridModel2D model;
+    {
+      const auto scope = profile.phase("load_model");
+      model = load_model(cli);
+    }
+    if (cli.autotune) {
+      const auto scope = profile.phase("autotune");
+      const auto tuning =
+          rtm3d::autotune_kernels(model, cli.rtm, {.cache_path = cli.tuning_cache, .aperture = cli.survey.aperture});
+      rtm3d::apply_tuning(tuning, cli.rtm);
+      std::cout << rtm3d::format_tuning(tuning);
+    }
+
+    if (cli.mode == rtm3d::RunMode::kModel) {
+      run_modeling(cli, model, profile);
+      return 0;
+    }
+    if (cli.mode == rtm3d::RunMode::kWorker) {
+      run_worker(cli, model, profile);
+      return 0;
+    }
     std::filesystem::create_directories(std::filesystem::path(cli.output_file).parent_path());
-    if (cli.output_format == rtm3d::OutputFormat::kFloat32Raw) {
-      rtm3d::write_float32_raw(cli.output_file, migration.inline_xz, migration.nx, migration.nz);
+
+    rtm3d::SurveyResult survey;
+    if (cli.mode == rtm3d::RunMode::kReduce) {
+      const auto scope = profile.phase("reduce");
+      survey = rtm3d::reduce_job(model, cli.rtm, cli.survey, cli.job);
+    } else if (cli.mode == rtm3d::RunMode::kCoordinate) {
+      const auto scope = profile.phase("coordinate");
+      survey = run_coordinator(cli, model, argc, argv);
     } else {
-      rtm3d::write_pgm(cli.output_file, migration.inline_xz, migration.nx, migration.nz);
+      plan_memory(cli, model, true);
+      survey = rtm3d::run_survey(model, cli.rtm, cli.survey, &profile);
     }
+    write_image(cli, survey.stack, profile);
+    if (cli.precision_report) {
+      const auto scope = profile.phase("precision_report");
+      const auto precision = rtm3d::compare_precision_to_fp32(model, cli.rtm);
+      rtm3d::write_precision_report_json(cli.output_file + ".precision.json", precision);
+      std::cout << rtm3d::format_precision_report(precision);
+    }
+    const auto report_file = cli.report_file.empty() ? cli.output_file + ".report.json" : cli.report_file;
+    rtm3d::write_run_report_json(report_file, profile, model, cli.rtm);
 
     std::cout << "RTM finished\n"
               << "model nx=" << model.nx << " nz=" << model.nz << " dx=" << model.dx << " dz=" << model.dz << "\n"
-              << "output=" << cli.output_file << "\n";
+              << "shots=" << survey.shots << " resumed=" << survey.resumed << "\n";
+    if (!cli.survey.cache_dir.empty()) {
+      rtm3d::write_shot_cache_stats_json(cli.output_file + ".cache.json", survey.cache);
+      std::cout << "cache hits=" << survey.cache.hits << " misses=" << survey.cache.misses
+                << " evicted=" << survey.cache.evicted << " entries=" << survey.cache.entries
+                << " bytes=" << survey.cache.bytes << "\n";
+      if (survey.cache.failed > 0) {
+        std::cerr << "warning: " << survey.cache.failed << " shot image(s) not cached: " << survey.cache.error << "\n";
+      }
+    }
+    std::cout << "output=" << cli.output_file << "\n"
+              << rtm3d::format_run_profile(profile) << "report=" << report_file << "\n";
     return 0;
   } catch (const std::exception& e) {
     const std::string m = e.what();
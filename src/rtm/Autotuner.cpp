@@ -0,0 +1,224 @@
+#include "rtm3d/rtm/Autotuner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Boundary.hpp"
+#include "DurableFile.hpp"
+#include "Geometry.hpp"
+#include "Parallel.hpp"
+#include "Propagation.hpp"
+#include "ShotWindows.hpp"
+
+namespace rtm3d {
+namespace {
+
+constexpr int kStencilOrder = 2;
+
+std::string cpu_model_name() {
+  std::ifstream f("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(f, line)) {
+    if (line.rfind("model name", 0) == 0) {
+      const auto colon = line.find(':');
+      std::string name = colon == std::string::npos ? line : line.substr(colon + 1);
+      name.erase(0, name.find_first_not_of(' '));
+      std::replace_if(name.begin(), name.end(), [](char c) { return c == '"' || c == '\\' || c == ';'; }, ' ');
+      return name;
+    }
+  }
+  return "unknown";
+}
+
+std::size_t hardware_threads() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+const char* order_name(FdKernelTuning::LoopOrder o) { return o == FdKernelTuning::LoopOrder::kYzx ? "yzx" : "zyx"; }
+
+// The cache is a small JSON document with one entry object per line, rewritten on every store.
+std::map<std::string, TuningResult> load_cache(const std::string& path) {
+  std::map<std::string, TuningResult> out;
+  std::ifstream f(path);
+  if (!f) return out;
+  const std::regex rx(
+      "\\{\"key\": \"([^\"]+)\", \"order\": \"(zyx|yzx)\", \"tile_y\": ([0-9]+), \"tile_x\": ([0-9]+), "
+      "\"threads\": ([0-9]+), \"mpoints_per_second\": ([-+0-9.eE]+)\\}");
+  std::string line;
+  while (std::getline(f, line)) {
+    std::smatch m;
+    if (!std::regex_search(line, m, rx)) continue;
+    TuningResult t;
+    t.key = m[1].str();
+    t.tuning.order = m[2].str() == "yzx" ? FdKernelTuning::LoopOrder::kYzx : FdKernelTuning::LoopOrder::kZyx;
+    t.tuning.tile_y = std::stoul(m[3].str());
+    t.tuning.tile_x = std::stoul(m[4].str());
+    t.threads = std::max<std::size_t>(1, std::stoul(m[5].str()));
+    t.points_per_second = std::stod(m[6].str()) * 1e6;
+    t.from_cache = true;
+    out[t.key] = t;
+  }
+  return out;
+}
+
+void store_cache(const std::string& path, const TuningResult& result) {
+  auto entries = load_cache(path);
+  entries[result.key] = result;
+
+  const std::filesystem::path p(path);
+  if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  std::ostringstream f;
+  f << "{\n  \"entries\": [\n";
+  std::size_t i = 0;
+  for (const auto& [key, t] : entries) {
+    f << "    {\"key\": \"" << key << "\", \"order\": \"" << order_name(t.tuning.order)
+      << "\", \"tile_y\": " << t.tuning.tile_y << ", \"tile_x\": " << t.tuning.tile_x
+      << ", \"threads\": " << t.threads << ", \"mpoints_per_second\": " << t.points_per_second * 1e-6 << "}"
+      << (++i < entries.size() ? "," : "") << "\n";
+  }
+  f << "  ]\n}\n";
+  // Each writer has its own temporary, so concurrent runs see the old or a new file, never half;
+  // the last rename wins and may drop an entry another run added meanwhile.
+  rtm_internal::write_file_durably(path, f.str());
+}
+
+class CandidateTimer {
+ public:
+  CandidateTimer(const GridModel2D& model, const RtmConfig& cfg, std::size_t steps)
+      : model_(model), cfg_(cfg), steps_(steps), vel_(rtm_internal::make_velocity_volume(model, cfg)),
+        damp_(rtm_internal::make_damp(vel_.nx(), vel_.ny(), vel_.nz(), cfg.pml)),
+        prev_(vel_.size(), 0.5f), cur_(vel_.size(), 1.0f), nxt_(vel_.size(), 0.0f) {}
+
+  // Median grid points per second of `steps` propagator steps.
+  double points_per_second(const FdKernelTuning& tuning, std::size_t threads) {
+    RtmConfig cfg = cfg_;
+    cfg.fd_tuning = tuning;
+    rtm_internal::WorkerPool pool(threads);
+    const auto prop = rtm_internal::make_propagator(cfg, vel_, damp_, model_.dx, model_.dz, pool);
+    prop->step(prev_, cur_, nxt_);
+    std::vector<double> samples;
+    for (std::size_t i = 0; i < steps_; ++i) {
+      const auto t0 = std::chrono::steady_clock::now();
+      prop->step(prev_, cur_, nxt_);
+      samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(samples.size() / 2), samples.end());
+    ++timed_;
+    return static_cast<double>(vel_.size()) / std::max(samples[samples.size() / 2], 1e-12);
+  }
+
+  std::size_t timed() const { return timed_; }
+
+ private:
+  const GridModel2D& model_;
+  const RtmConfig& cfg_;
+  std::size_t steps_;
+  Volume3D vel_;
+  std::vector<float> damp_;
+  std::vector<float> prev_, cur_, nxt_;
+  std::size_t timed_ = 0;
+};
+
+std::vector<FdKernelTuning> tiling_candidates(std::size_t nx, std::size_t ny) {
+  std::vector<FdKernelTuning> out = {{}};
+  const std::size_t rows = ny > 2 ? ny - 2 : 0;
+  const std::size_t cols = nx > 2 ? nx - 2 : 0;
+  std::vector<std::size_t> tile_x = {0};
+  for (const std::size_t tx : {64, 256}) {
+    if (tx < cols) tile_x.push_back(tx);
+  }
+  for (const std::size_t ty : {0, 4, 8, 16, 32, 64}) {
+    if (ty >= rows) continue;
+    for (const std::size_t tx : tile_x) out.push_back({FdKernelTuning::LoopOrder::kYzx, ty, tx});
+  }
+  return out;
+}
+
+std::vector<std::size_t> thread_candidates() {
+  const std::size_t hw = hardware_threads();
+  std::vector<std::size_t> out;
+  for (std::size_t t = 1; t < hw; t *= 2) out.push_back(t);
+  out.push_back(hw);
+  return out;
+}
+
+}  // namespace
+
+std::string default_tuning_cache_path() {
+  if (const char* p = std::getenv("RTM3D_TUNING_CACHE"); p && *p) return p;
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) return std::string(xdg) + "/rtm3d/tuning.json";
+  if (const char* home = std::getenv("HOME"); home && *home) return std::string(home) + "/.cache/rtm3d/tuning.json";
+  return "rtm3d_tuning.json";
+}
+
+std::string tuning_cache_key(const GridModel2D& model, const RtmConfig& cfg) {
+  std::ostringstream s;
+  s << "cpu=" << cpu_model_name() << ";hw_threads=" << hardware_threads()
+    << ";kernel=" << (cfg.propagator == PropagatorKind::kPseudoSpectral ? "pseudo_spectral" : "fd")
+    << ";order=" << kStencilOrder << ";grid=" << model.nx << "x" << cfg.ny << "x" << model.nz;
+  return s.str();
+}
+
+TuningResult autotune_kernels(const GridModel2D& model, const RtmConfig& cfg, const AutotuneOptions& opts) {
+  if (cfg.precision != WavefieldPrecision::kFloat32 || cfg.max_dz_ratio > 1.0f) {
+    throw std::runtime_error("autotuning times the fp32 kernels on the uniform depth grid only");
+  }
+  const auto [x0, x1] = rtm_internal::shot_window(model, model.nx / 2, opts.aperture);
+  const GridModel2D grid = x1 - x0 < model.nx ? rtm_internal::crop_columns(model, x0, x1) : model;
+  const std::string path = opts.cache_path.empty() ? default_tuning_cache_path() : opts.cache_path;
+  const std::string key = tuning_cache_key(grid, cfg);
+  const auto cached = load_cache(path);
+  if (const auto it = cached.find(key); it != cached.end()) return it->second;
+
+  CandidateTimer timer(grid, cfg, std::max<std::size_t>(1, opts.steps));
+  TuningResult best;
+  best.key = key;
+  const auto threads = thread_candidates();
+
+  // Loop order and tiles at full width first, then the thread count for the winning tiling.
+  best.threads = threads.back();
+  if (cfg.propagator == PropagatorKind::kFiniteDifference) {
+    for (const auto& t : tiling_candidates(grid.nx, cfg.ny)) {
+      const double pps = timer.points_per_second(t, best.threads);
+      if (pps > best.points_per_second) {
+        best.points_per_second = pps;
+        best.tuning = t;
+      }
+    }
+  }
+  for (const std::size_t n : threads) {
+    if (n == best.threads && best.points_per_second > 0.0) continue;
+    const double pps = timer.points_per_second(best.tuning, n);
+    if (pps > best.points_per_second) {
+      best.points_per_second = pps;
+      best.threads = n;
+    }
+  }
+  best.candidates = timer.timed();
+  store_cache(path, best);
+  return best;
+}
+
+void apply_tuning(const TuningResult& tuning, RtmConfig& cfg) {
+  cfg.fd_tuning = tuning.tuning;
+  cfg.threads = tuning.threads;
+}
+
+std::string format_tuning(const TuningResult& t) {
+  std::ostringstream s;
+  s << "autotune " << (t.from_cache ? "cached" : "tuned") << " order=" << order_name(t.tuning.order)
+    << " tile_y=" << t.tuning.tile_y << " tile_x=" << t.tuning.tile_x << " threads=" << t.threads
+    << " mpoints_per_second=" << t.points_per_second * 1e-6;
+  if (!t.from_cache) s << " candidates=" << t.candidates;
+  s << "\n";
+  return s.str();
+}
+
+}  // namespace rtm3d
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <random>
 
 namespace rtm3d::rtm_internal {
 
@@ -23,4 +24,25 @@ std::vector<float> make_damp(std::size_t nx, std::size_t ny, std::size_t nz, std
   return d;
 }
 
+Volume3D make_random_boundary_velocity(const Volume3D& vel, std::size_t pml, std::uint32_t seed) {
+  const std::size_t nx = vel.nx(), ny = vel.ny(), nz = vel.nz() + pml;
+  Volume3D out(nx, ny, nz);
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> slowdown(0.25f, 0.75f);
+  for (std::size_t iz = 0; iz < nz; ++iz) {
+    for (std::size_t iy = 0; iy < ny; ++iy) {
+      for (std::size_t ix = 0; ix < nx; ++ix) {
+        float v = vel(ix, iy, iz < pml ? 0 : iz - pml);
+        const auto dist = std::min({ix, nx - 1 - ix, iy, ny - 1 - iy, iz, nz - 1 - iz});
+        if (dist < pml) {
+          const float x = static_cast<float>(pml - dist) / static_cast<float>(pml);
+          v *= 1.0f - x * slowdown(rng);
+        }
+        out(ix, iy, iz) = v;
+      }
+    }
+  }
+  return out;
+}
+
 }  // namespace rtm3d::rtm_internal
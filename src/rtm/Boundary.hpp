@@ -1,10 +1,20 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include "rtm3d/core/Volume3D.hpp"
+
 namespace rtm3d::rtm_internal {
 
 std::vector<float> make_damp(std::size_t nx, std::size_t ny, std::size_t nz, std::size_t pml);
 
+// `vel` with `pml` extra planes on top (copies of its first plane) and the make_damp shell of that
+// taller grid slowed down by a random 25-75% at the faces, tapering to nothing at its inner edge.
+// Waves run into the shell undamped and scatter incoherently instead of reflecting, so an
+// undamped propagation on it can be run backwards. The extra planes keep the source and receiver
+// plane outside the shell. Velocities only decrease, so the model's stable dt still holds.
+Volume3D make_random_boundary_velocity(const Volume3D& vel, std::size_t pml, std::uint32_t seed = 1);
+
 }  // namespace rtm3d::rtm_internal
@@ -0,0 +1,179 @@
+#include "Decomposition.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+#include "Geometry.hpp"
+#include "Imaging.hpp"
+#include "Propagation.hpp"
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+constexpr std::size_t kHaloDepth = 4;
+
+// Slab-local copy of the global grid: owned planes plus one halo plane on each side.
+struct SlabGrid {
+  Volume3D vel;
+  std::vector<float> damp;
+  std::size_t z0{};  // global z of local plane 0
+  std::size_t plane{};
+  std::size_t owned_n{};
+};
+
+SlabGrid make_slab_grid(const Volume3D& vel, const std::vector<float>& damp, const SlabRange& slab) {
+  SlabGrid g;
+  g.z0 = slab.begin - 1;
+  g.plane = vel.nx() * vel.ny();
+  const std::size_t nzl = slab.end - slab.begin + 2;
+  g.vel = Volume3D(vel.nx(), vel.ny(), nzl);
+  const auto first = static_cast<std::ptrdiff_t>(g.z0 * g.plane);
+  const auto last = static_cast<std::ptrdiff_t>((g.z0 + nzl) * g.plane);
+  std::copy(vel.raw().begin() + first, vel.raw().begin() + last, g.vel.raw().begin());
+  g.damp.assign(damp.begin() + first, damp.begin() + last);
+  g.owned_n = (nzl - 2) * g.plane;
+  return g;
+}
+
+// One time step on a slab: edge planes first so their halos can be posted while the interior is
+// computed, then the neighbours' edge planes are received into the local halo planes.
+template <typename PointUpdates>
+void slab_step(const GridModel2D& model, const RtmConfig& cfg, const SlabGrid& g,
+               HaloTransport& transport, const std::vector<float>& prev,
+               const std::vector<float>& cur, std::vector<float>& nxt, PointUpdates&& point_updates) {
+  const std::size_t lo = 1;
+  const std::size_t hi = g.vel.nz() - 2;
+  const bool has_lower = transport.rank() > 0;
+  const bool has_upper = transport.rank() + 1 < transport.size();
+
+  auto compute = [&](std::size_t b, std::size_t e) {
+    step_fd3d_planes(g.vel, g.damp, cfg.dt, model.dx, cfg.dy, model.dz, prev, cur, nxt, b, e);
+    point_updates(b, e);
+  };
+
+  compute(lo, lo + 1);
+  if (hi != lo) compute(hi, hi + 1);
+  if (has_lower) transport.send(HaloSide::kLower, nxt.data() + lo * g.plane);
+  if (has_upper) transport.send(HaloSide::kUpper, nxt.data() + hi * g.plane);
+
+  if (hi > lo + 1) compute(lo + 1, hi);
+
+  if (has_lower) transport.recv(HaloSide::kLower, nxt.data());
+  if (has_upper) transport.recv(HaloSide::kUpper, nxt.data() + (hi + 1) * g.plane);
+}
+
+}  // namespace
+
+std::vector<SlabRange> partition_slabs(std::size_t nz, std::size_t ranks) {
+  if (ranks == 0 || nz < 3 || ranks > nz - 2) throw std::runtime_error("cannot split grid into requested slab ranks");
+  const std::size_t interior = nz - 2;
+  std::vector<SlabRange> out(ranks);
+  std::size_t z = 1;
+  for (std::size_t r = 0; r < ranks; ++r) {
+    const std::size_t count = interior / ranks + (r < interior % ranks ? 1 : 0);
+    out[r] = SlabRange{z, z + count};
+    z += count;
+  }
+  return out;
+}
+
+void run_slab_rank(const GridModel2D& model, const RtmConfig& cfg, const Volume3D& vel,
+                   const std::vector<float>& damp, const std::vector<float>& wavelet,
+                   std::size_t sx, std::size_t sy, std::size_t sz,
+                   const std::vector<std::size_t>& rx, const SlabRange& slab,
+                   HaloTransport& transport, float* inline_xz) {
+  const SlabGrid g = make_slab_grid(vel, damp, slab);
+  const std::size_t n = g.vel.size();
+  const bool owns_src = sz >= slab.begin && sz < slab.end;
+  const std::size_t lsz = owns_src ? sz - g.z0 : 0;
+
+  std::vector<float> src_snaps(cfg.nt * g.owned_n, 0.0f);
+  std::vector<float> rec_data(owns_src ? cfg.nt * rx.size() : 0, 0.0f);
+
+  {
+    std::vector<float> prev(n, 0.0f), cur(n, 0.0f), nxt(n, 0.0f);
+    for (std::size_t it = 0; it < cfg.nt; ++it) {
+      slab_step(model, cfg, g, transport, prev, cur, nxt, [&](std::size_t b, std::size_t e) {
+        if (owns_src && lsz >= b && lsz < e) nxt[g.vel.index(sx, sy, lsz)] += wavelet[it];
+      });
+      if (owns_src) record_receivers(g.vel, sy, lsz, rx, nxt, rec_data, it);
+      std::copy(nxt.begin() + static_cast<std::ptrdiff_t>(g.plane),
+                nxt.begin() + static_cast<std::ptrdiff_t>(g.plane + g.owned_n),
+                src_snaps.begin() + static_cast<std::ptrdiff_t>(it * g.owned_n));
+      prev.swap(cur);
+      cur.swap(nxt);
+    }
+  }
+
+  std::vector<float> image(g.owned_n, 0.0f);
+  {
+    std::vector<float> prev(n, 0.0f), cur(n, 0.0f), nxt(n, 0.0f);
+    for (std::size_t rit = 0; rit < cfg.nt; ++rit) {
+      const std::size_t it = cfg.nt - 1 - rit;
+      slab_step(model, cfg, g, transport, prev, cur, nxt, [&](std::size_t b, std::size_t e) {
+        if (owns_src && lsz >= b && lsz < e) inject_receivers(g.vel, sy, lsz, rx, rec_data, it, nxt);
+      });
+      accumulate_cross_correlation_image(src_snaps.data() + it * g.owned_n, nxt.data() + g.plane,
+                                         image.data(), g.owned_n);
+      prev.swap(cur);
+      cur.swap(nxt);
+    }
+  }
+
+  const std::size_t ymid = vel.ny() / 2;
+  for (std::size_t iz = slab.begin; iz < slab.end; ++iz) {
+    const float* row = image.data() + ((iz - slab.begin) * vel.ny() + ymid) * vel.nx();
+    std::copy(row, row + vel.nx(), inline_xz + iz * vel.nx());
+  }
+}
+
+std::vector<float> run_slab_decomposed_shot(const GridModel2D& model, const RtmConfig& cfg,
+                                            const Volume3D& vel, const std::vector<float>& damp,
+                                            const std::vector<float>& wavelet, std::size_t sx,
+                                            std::size_t sy, std::size_t sz,
+                                            const std::vector<std::size_t>& rx) {
+  const auto slabs = partition_slabs(vel.nz(), cfg.ranks);
+  ShmHaloArena arena(cfg.ranks, vel.nx() * vel.ny(), kHaloDepth, vel.nx() * vel.nz());
+
+  // Children inherit stdio buffers; flush so nothing is emitted twice.
+  std::cout.flush();
+  std::fflush(nullptr);
+
+  std::vector<pid_t> pids;
+  for (std::size_t r = 0; r < cfg.ranks; ++r) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      ShmRingTransport transport(arena, r);
+      int code = 0;
+      try {
+        run_slab_rank(model, cfg, vel, damp, wavelet, sx, sy, sz, rx, slabs[r], transport, arena.extra());
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "slab rank %zu failed: %s\n", r, e.what());
+        transport.abort();
+        code = 1;
+      }
+      _exit(code);
+    }
+    if (pid < 0) {
+      arena.abort_flag().store(1);
+      break;
+    }
+    pids.push_back(pid);
+  }
+
+  bool ok = pids.size() == cfg.ranks;
+  for (const pid_t pid : pids) {
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+  }
+  if (!ok) throw std::runtime_error("slab-decomposed run failed (see rank errors above)");
+
+  return std::vector<float>(arena.extra(), arena.extra() + vel.nx() * vel.nz());
+}
+
+}  // namespace rtm3d::rtm_internal
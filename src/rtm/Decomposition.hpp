@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "HaloExchange.hpp"
+#include "rtm3d/core/Volume3D.hpp"
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// Global interior z-planes [begin, end) owned by one slab rank. Planes 0 and nz-1 are the fixed
+// zero boundary and are never owned.
+struct SlabRange {
+  std::size_t begin{};
+  std::size_t end{};
+};
+
+std::vector<SlabRange> partition_slabs(std::size_t nz, std::size_t ranks);
+
+// Runs forward propagation, backpropagation and imaging for the slab owned by `transport.rank()`
+// and writes that slab's rows of the inline image into `inline_xz` (nz * nx, shared by all ranks).
+void run_slab_rank(const GridModel2D& model, const RtmConfig& cfg, const Volume3D& vel,
+                   const std::vector<float>& damp, const std::vector<float>& wavelet,
+                   std::size_t sx, std::size_t sy, std::size_t sz,
+                   const std::vector<std::size_t>& rx, const SlabRange& slab,
+                   HaloTransport& transport, float* inline_xz);
+
+// Forks cfg.ranks worker processes that exchange halos through shared-memory rings and returns the
+// assembled inline image, identical to the single-process result.
+std::vector<float> run_slab_decomposed_shot(const GridModel2D& model, const RtmConfig& cfg,
+                                            const Volume3D& vel, const std::vector<float>& damp,
+                                            const std::vector<float>& wavelet, std::size_t sx,
+                                            std::size_t sy, std::size_t sz,
+                                            const std::vector<std::size_t>& rx);
+
+}  // namespace rtm3d::rtm_internal
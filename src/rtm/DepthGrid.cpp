@@ -0,0 +1,73 @@
+#include "rtm3d/rtm/DepthGrid.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace rtm3d {
+
+DepthGrid make_stretched_depth_grid(const GridModel2D& model, float max_ratio, float max_growth) {
+  if (model.nz < 2 || model.dz <= 0.0f || model.values.size() != model.nx * model.nz) {
+    throw std::runtime_error("invalid model for a depth grid");
+  }
+  if (max_ratio < 1.0f || max_growth < 1.0f) throw std::runtime_error("depth grid ratios must be >= 1");
+
+  // Slowest velocity of each row and of everything below it.
+  std::vector<float> vmin_below(model.nz);
+  for (std::size_t iz = model.nz; iz-- > 0;) {
+    const auto row = model.values.begin() + static_cast<std::ptrdiff_t>(iz * model.nx);
+    vmin_below[iz] = *std::min_element(row, row + static_cast<std::ptrdiff_t>(model.nx));
+    if (iz + 1 < model.nz) vmin_below[iz] = std::min(vmin_below[iz], vmin_below[iz + 1]);
+  }
+  if (!(vmin_below[0] > 0.0f)) throw std::runtime_error("model velocities must be > 0");
+
+  const float bottom = static_cast<float>(model.nz - 1) * model.dz;
+  DepthGrid g;
+  g.z.push_back(0.0f);
+  float h = model.dz;
+  while (g.z.back() < bottom) {
+    if (g.z.size() > kUniformTopPlanes - 1) {
+      // Row at or above the current depth, so the spacing never outruns a slower layer below.
+      const auto iz = std::min(model.nz - 1, static_cast<std::size_t>(g.z.back() / model.dz));
+      const float target = model.dz * std::clamp(vmin_below[iz] / vmin_below[0], 1.0f, max_ratio);
+      h = std::max(model.dz, std::min(target, h * max_growth));
+    }
+    g.z.push_back(g.z.back() + h);
+  }
+  return g;
+}
+
+DepthGrid propagation_depth_grid(const GridModel2D& model, const RtmConfig& cfg) {
+  if (cfg.max_dz_ratio > 1.0f) return make_stretched_depth_grid(model, cfg.max_dz_ratio);
+  return {uniform_depths(model.nz, model.dz)};
+}
+
+std::vector<float> uniform_depths(std::size_t nz, float dz) {
+  std::vector<float> z(nz);
+  for (std::size_t iz = 0; iz < nz; ++iz) z[iz] = static_cast<float>(iz) * dz;
+  return z;
+}
+
+std::vector<float> resample_depth(const std::vector<float>& rows, std::size_t nx, const std::vector<float>& from,
+                                  const std::vector<float>& to) {
+  if (from.empty() || rows.size() != from.size() * nx) throw std::runtime_error("depth resample size mismatch");
+  std::vector<float> out(to.size() * nx);
+  std::size_t k = 0;  // from[k] <= depth < from[k + 1]; `to` is increasing, so k only moves down
+  for (std::size_t iz = 0; iz < to.size(); ++iz) {
+    const float depth = to[iz];
+    while (k + 1 < from.size() && from[k + 1] <= depth) ++k;
+    std::size_t a = k, b = std::min(k + 1, from.size() - 1);
+    float w = 0.0f;
+    if (depth <= from.front()) {
+      a = b = 0;
+    } else if (b > a) {
+      w = (depth - from[a]) / (from[b] - from[a]);
+    }
+    const float* ra = rows.data() + a * nx;
+    const float* rb = rows.data() + b * nx;
+    float* o = out.data() + iz * nx;
+    for (std::size_t ix = 0; ix < nx; ++ix) o[ix] = ra[ix] + w * (rb[ix] - ra[ix]);
+  }
+  return out;
+}
+
+}  // namespace rtm3d
@@ -0,0 +1,86 @@
+#include "DurableFile.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+[[noreturn]] void throw_io(const std::string& what, const std::string& path) {
+  throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void fsync_directory_of(const std::string& path) {
+  auto dir = std::filesystem::path(path).parent_path();
+  if (dir.empty()) dir = ".";
+  const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) throw_io("cannot open directory", dir.string());
+  const int r = ::fsync(fd);
+  ::close(fd);
+  if (r != 0) throw_io("cannot sync directory", dir.string());
+}
+
+}  // namespace
+
+DurableFileWriter::DurableFileWriter(std::string path)
+    : path_(std::move(path)), tmp_(path_ + ".tmp." + std::to_string(::getpid())) {
+  fd_ = ::open(tmp_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw_io("cannot create", tmp_);
+}
+
+DurableFileWriter::~DurableFileWriter() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    ::unlink(tmp_.c_str());
+  }
+}
+
+void DurableFileWriter::write(const void* data, std::size_t bytes) {
+  const auto* p = static_cast<const char*>(data);
+  std::size_t done = 0;
+  while (done < bytes) {
+    const ssize_t r = ::write(fd_, p + done, bytes - done);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) throw_io("cannot write", tmp_);
+    done += static_cast<std::size_t>(r);
+  }
+}
+
+void DurableFileWriter::commit() {
+  if (::fsync(fd_) != 0) throw_io("cannot sync", tmp_);
+  const int r = ::close(fd_);
+  fd_ = -1;
+  if (r != 0) {
+    ::unlink(tmp_.c_str());
+    throw_io("cannot close", tmp_);
+  }
+  if (std::rename(tmp_.c_str(), path_.c_str()) != 0) {
+    ::unlink(tmp_.c_str());
+    throw_io("cannot rename onto", path_);
+  }
+  fsync_directory_of(path_);
+}
+
+void write_file_durably(const std::string& path, const std::string& contents) {
+  DurableFileWriter w(path);
+  w.write(contents.data(), contents.size());
+  w.commit();
+}
+
+std::uint64_t fnv1a(const void* data, std::size_t bytes, std::uint64_t hash) {
+  const auto* p = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < bytes; ++i) {
+    hash ^= p[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+}  // namespace rtm3d::rtm_internal
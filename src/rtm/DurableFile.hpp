@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rtm3d::rtm_internal {
+
+// Replaces `path` so that a crash at any point leaves either the previous file or the complete
+// new one: data goes to <path>.tmp.<pid>, which is fsync'ed and renamed over `path` by commit(), and
+// the directory entry is fsync'ed too. A writer destroyed before commit() removes the temporary.
+// Processes writing the same path concurrently do not share a temporary; the last rename wins.
+class DurableFileWriter {
+ public:
+  explicit DurableFileWriter(std::string path);
+  ~DurableFileWriter();
+  DurableFileWriter(const DurableFileWriter&) = delete;
+  DurableFileWriter& operator=(const DurableFileWriter&) = delete;
+
+  void write(const void* data, std::size_t bytes);
+  void commit();
+
+ private:
+  std::string path_;
+  std::string tmp_;
+  int fd_ = -1;
+};
+
+void write_file_durably(const std::string& path, const std::string& contents);
+
+// 64-bit FNV-1a, chained through `hash` to fingerprint several buffers.
+constexpr std::uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+std::uint64_t fnv1a(const void* data, std::size_t bytes, std::uint64_t hash = kFnvOffsetBasis);
+
+}  // namespace rtm3d::rtm_internal
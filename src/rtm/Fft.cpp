@@ -0,0 +1,114 @@
+#include "Fft.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+bool is_pow2(std::size_t n) { return n != 0 && (n & (n - 1)) == 0; }
+
+// Plain complex product; std::complex operator* goes through the Annex G NaN/Inf recovery path
+// (__mulsc3) unless -ffast-math is on, which dominates the butterfly cost.
+inline std::complex<float> cmul(std::complex<float> a, std::complex<float> b) {
+  return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+std::size_t next_pow2(std::size_t n) {
+  std::size_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+}  // namespace
+
+FftPlan::FftPlan(std::size_t n) : n_(n), m_(is_pow2(n) ? n : next_pow2(2 * n - 1)) {
+  if (n == 0) throw std::runtime_error("FFT length must be > 0");
+
+  twiddles_.resize(m_ / 2);
+  for (std::size_t k = 0; k < m_ / 2; ++k) {
+    const double a = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(m_);
+    twiddles_[k] = {static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a))};
+  }
+  bitrev_.resize(m_);
+  std::size_t bits = 0;
+  while ((std::size_t{1} << bits) < m_) ++bits;
+  for (std::size_t i = 0; i < m_; ++i) {
+    std::size_t r = 0;
+    for (std::size_t b = 0; b < bits; ++b) r |= ((i >> b) & 1u) << (bits - 1 - b);
+    bitrev_[i] = r;
+  }
+
+  if (is_pow2(n)) return;
+
+  chirp_.resize(n);
+  for (std::size_t k = 0; k < n; ++k) {
+    // k^2 mod 2n keeps the phase argument small and exact for large k.
+    const auto k2 = (static_cast<unsigned long long>(k) * k) % (2ull * n);
+    const double a = -kPi * static_cast<double>(k2) / static_cast<double>(n);
+    chirp_[k] = {static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a))};
+  }
+  chirp_fft_.assign(m_, {0.0f, 0.0f});
+  chirp_fft_[0] = std::conj(chirp_[0]);
+  for (std::size_t k = 1; k < n; ++k) {
+    chirp_fft_[k] = std::conj(chirp_[k]);
+    chirp_fft_[m_ - k] = std::conj(chirp_[k]);
+  }
+  radix2(chirp_fft_.data());
+  const float inv_m = 1.0f / static_cast<float>(m_);
+  for (auto& c : chirp_fft_) c *= inv_m;
+}
+
+void FftPlan::radix2(std::complex<float>* data) const {
+  for (std::size_t i = 0; i < m_; ++i) {
+    if (i < bitrev_[i]) std::swap(data[i], data[bitrev_[i]]);
+  }
+  for (std::size_t len = 2; len <= m_; len <<= 1) {
+    const std::size_t half = len / 2;
+    const std::size_t step = m_ / len;
+    for (std::size_t i = 0; i < m_; i += len) {
+      for (std::size_t j = 0; j < half; ++j) {
+        const auto t = cmul(twiddles_[j * step], data[i + j + half]);
+        data[i + j + half] = data[i + j] - t;
+        data[i + j] += t;
+      }
+    }
+  }
+}
+
+void FftPlan::forward(std::complex<float>* data, std::complex<float>* scratch) const {
+  if (chirp_.empty()) {
+    radix2(data);
+    return;
+  }
+  for (std::size_t k = 0; k < n_; ++k) scratch[k] = cmul(data[k], chirp_[k]);
+  std::fill(scratch + n_, scratch + m_, std::complex<float>{0.0f, 0.0f});
+  radix2(scratch);
+  for (std::size_t k = 0; k < m_; ++k) scratch[k] = std::conj(cmul(scratch[k], chirp_fft_[k]));
+  // Inverse radix-2 through conjugation: ifft(x) = conj(fft(conj(x))); the 1/m is in chirp_fft_.
+  radix2(scratch);
+  for (std::size_t k = 0; k < n_; ++k) data[k] = cmul(std::conj(scratch[k]), chirp_[k]);
+}
+
+void FftPlan::inverse(std::complex<float>* data, std::complex<float>* scratch) const {
+  for (std::size_t k = 0; k < n_; ++k) data[k] = std::conj(data[k]);
+  forward(data, scratch);
+  for (std::size_t k = 0; k < n_; ++k) data[k] = std::conj(data[k]);
+}
+
+const FftPlan& cached_fft_plan(std::size_t n) {
+  static std::mutex mu;
+  static std::map<std::size_t, std::unique_ptr<FftPlan>> plans;
+  std::lock_guard<std::mutex> lock(mu);
+  auto& slot = plans[n];
+  if (!slot) slot = std::make_unique<FftPlan>(n);
+  return *slot;
+}
+
+}  // namespace rtm3d::rtm_internal
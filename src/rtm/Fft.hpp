@@ -0,0 +1,37 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace rtm3d::rtm_internal {
+
+// Complex single-precision 1D FFT of arbitrary length: iterative radix-2 for powers of two,
+// Bluestein's chirp-z (via a power-of-two convolution) otherwise. Transforms are unnormalised;
+// inverse(forward(x)) == n * x.
+class FftPlan {
+ public:
+  explicit FftPlan(std::size_t n);
+
+  std::size_t size() const { return n_; }
+  // Number of complex scratch elements a caller must provide to forward()/inverse().
+  std::size_t scratch_size() const { return chirp_.empty() ? 0 : m_; }
+
+  void forward(std::complex<float>* data, std::complex<float>* scratch) const;
+  void inverse(std::complex<float>* data, std::complex<float>* scratch) const;
+
+ private:
+  void radix2(std::complex<float>* data) const;  // in-place, length m_
+
+  std::size_t n_;
+  std::size_t m_;  // power-of-two length of the radix-2 core (== n_ unless Bluestein)
+  std::vector<std::complex<float>> twiddles_;
+  std::vector<std::size_t> bitrev_;
+  std::vector<std::complex<float>> chirp_;      // exp(-i*pi*k^2/n), k < n (Bluestein only)
+  std::vector<std::complex<float>> chirp_fft_;  // FFT of the conjugate chirp filter, scaled by 1/m
+};
+
+// Plans are immutable once built and cached per length for the lifetime of the process.
+const FftPlan& cached_fft_plan(std::size_t n);
+
+}  // namespace rtm3d::rtm_internal
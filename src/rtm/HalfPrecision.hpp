@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace rtm3d::rtm_internal {
+
+inline std::uint32_t float_bits(float f) {
+  std::uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float bits_float(std::uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// IEEE binary16: 5-bit exponent, 10-bit mantissa, normal range [6.1e-5, 65504]. Conversions are
+// branch-light bit manipulation so the stencil loops vectorize without F16C.
+struct Fp16 {
+  static constexpr float kMaxFinite = 65504.0f;
+
+  static float decode(std::uint16_t h) {
+    // Shift exponent and mantissa into place and rebias by 2^112; subnormals come out right
+    // because the multiply normalises them. Encoding never produces inf or NaN.
+    const float magnitude = bits_float(static_cast<std::uint32_t>(h & 0x7fffu) << 13) * 0x1p112f;
+    return bits_float(float_bits(magnitude) | (static_cast<std::uint32_t>(h & 0x8000u) << 16));
+  }
+
+  // Round to nearest even; saturates at +-65504 instead of overflowing to infinity. All three cases
+  // are computed and selected with masks so the loop stays branch-free.
+  static std::uint16_t encode(float f) {
+    const std::uint32_t bits = float_bits(f);
+    const std::uint32_t sign = (bits >> 16) & 0x8000u;
+    const std::uint32_t u = bits & 0x7fffffffu;
+    // Below the smallest normal the FPU rounds the subnormal when adding 0.5.
+    const std::uint32_t subnormal = float_bits(bits_float(u) + 0.5f) - float_bits(0.5f);
+    const std::uint32_t normal = (u + 0xc8000fffu + ((u >> 13) & 1u)) >> 13;  // rebias by -112 and round
+    const std::uint32_t saturate = 0u - static_cast<std::uint32_t>(u >= 0x477ff000u);  // rounds to >= 65520
+    const std::uint32_t tiny = 0u - static_cast<std::uint32_t>(u < 0x38800000u);
+    const std::uint32_t h = (saturate & 0x7bffu) | (~saturate & ((tiny & subnormal) | (~tiny & normal)));
+    return static_cast<std::uint16_t>(h | sign);
+  }
+};
+
+// bfloat16: the top half of an fp32, so the fp32 exponent range with an 8-bit mantissa.
+struct Bf16 {
+  static constexpr float kMaxFinite = 3.38e38f;
+
+  static float decode(std::uint16_t h) { return bits_float(static_cast<std::uint32_t>(h) << 16); }
+
+  static std::uint16_t encode(float f) {  // round to nearest even
+    const std::uint32_t u = float_bits(f);
+    return static_cast<std::uint16_t>((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+  }
+};
+
+}  // namespace rtm3d::rtm_internal
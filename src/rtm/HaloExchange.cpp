@@ -0,0 +1,99 @@
+#include "HaloExchange.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "process-shared rings need lock-free 64-bit atomics");
+
+constexpr std::size_t kCacheLine = 64;
+
+std::size_t round_up(std::size_t v, std::size_t a) { return (v + a - 1) / a * a; }
+
+// Links are numbered 2 * rank + side; the upper side of the last rank and the lower side of
+// rank 0 are allocated but never used, which keeps the indexing trivial.
+std::size_t link_index(std::size_t from, HaloSide to) {
+  return 2 * from + (to == HaloSide::kUpper ? 1 : 0);
+}
+
+void wait_until(const std::atomic<int>& abort_flag, auto&& ready) {
+  for (std::size_t spin = 0; !ready(); ++spin) {
+    if (abort_flag.load(std::memory_order_relaxed) != 0) {
+      throw std::runtime_error("halo exchange aborted by peer rank");
+    }
+    if (spin >= 64) std::this_thread::yield();
+  }
+}
+
+}  // namespace
+
+ShmHaloArena::ShmHaloArena(std::size_t ranks, std::size_t plane_size, std::size_t depth,
+                           std::size_t extra_floats)
+    : ranks_(ranks), plane_size_(plane_size), depth_(depth) {
+  if (ranks == 0 || plane_size == 0 || depth == 0) throw std::runtime_error("invalid halo arena shape");
+
+  ring_bytes_ = 2 * kCacheLine + round_up(depth * plane_size * sizeof(float), kCacheLine);
+  const std::size_t header = kCacheLine;
+  const std::size_t rings = 2 * ranks * ring_bytes_;
+  bytes_ = header + rings + round_up(extra_floats * sizeof(float), kCacheLine) + kCacheLine;
+
+  base_ = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    throw std::runtime_error("cannot map shared halo arena");
+  }
+
+  auto* bytes = static_cast<unsigned char*>(base_);
+  abort_ = new (bytes) std::atomic<int>(0);
+  rings_ = bytes + header;
+  for (std::size_t l = 0; l < 2 * ranks; ++l) {
+    unsigned char* r = rings_ + l * ring_bytes_;
+    new (r) std::atomic<std::uint64_t>(0);
+    new (r + kCacheLine) std::atomic<std::uint64_t>(0);
+  }
+  extra_ = reinterpret_cast<float*>(rings_ + rings);
+}
+
+ShmHaloArena::~ShmHaloArena() {
+  if (base_ != nullptr) munmap(base_, bytes_);
+}
+
+ShmHaloArena::Ring ShmHaloArena::ring(std::size_t from, HaloSide to) const {
+  unsigned char* r = rings_ + link_index(from, to) * ring_bytes_;
+  return Ring{std::launder(reinterpret_cast<std::atomic<std::uint64_t>*>(r)),
+              std::launder(reinterpret_cast<std::atomic<std::uint64_t>*>(r + kCacheLine)),
+              reinterpret_cast<float*>(r + 2 * kCacheLine)};
+}
+
+void ShmRingTransport::send(HaloSide to, const float* plane) {
+  const auto ring = arena_.ring(rank_, to);
+  const auto head = ring.head->load(std::memory_order_relaxed);
+  wait_until(arena_.abort_flag(), [&] {
+    return head - ring.tail->load(std::memory_order_acquire) < arena_.depth();
+  });
+  float* slot = ring.slots + (head % arena_.depth()) * arena_.plane_size();
+  std::copy(plane, plane + arena_.plane_size(), slot);
+  ring.head->store(head + 1, std::memory_order_release);
+}
+
+void ShmRingTransport::recv(HaloSide from, float* plane) {
+  // The lower neighbour sends towards its upper side, and vice versa.
+  const std::size_t peer = from == HaloSide::kLower ? rank_ - 1 : rank_ + 1;
+  const auto ring = arena_.ring(peer, from == HaloSide::kLower ? HaloSide::kUpper : HaloSide::kLower);
+  const auto tail = ring.tail->load(std::memory_order_relaxed);
+  wait_until(arena_.abort_flag(), [&] { return ring.head->load(std::memory_order_acquire) != tail; });
+  const float* slot = ring.slots + (tail % arena_.depth()) * arena_.plane_size();
+  std::copy(slot, slot + arena_.plane_size(), plane);
+  ring.tail->store(tail + 1, std::memory_order_release);
+}
+
+void ShmRingTransport::abort() { arena_.abort_flag().store(1, std::memory_order_relaxed); }
+
+}  // namespace rtm3d::rtm_internal
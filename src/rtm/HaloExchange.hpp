@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace rtm3d::rtm_internal {
+
+enum class HaloSide { kLower, kUpper };
+
+// Point-to-point transport for z-plane halos between neighbouring slab ranks. send() may return
+// before the peer has received (buffered, like MPI_Isend + eager protocol); recv() blocks until
+// the next plane from that side is available. Planes from one side arrive in send order.
+class HaloTransport {
+ public:
+  virtual ~HaloTransport() = default;
+
+  virtual std::size_t rank() const = 0;
+  virtual std::size_t size() const = 0;
+  virtual void send(HaloSide to, const float* plane) = 0;
+  virtual void recv(HaloSide from, float* plane) = 0;
+  // Tells every peer to stop waiting; used when this rank fails.
+  virtual void abort() = 0;
+};
+
+// Process-shared arena holding one single-producer/single-consumer ring buffer per directed
+// neighbour link plus an abort flag. Must be created before fork() so children inherit the
+// MAP_SHARED mapping.
+class ShmHaloArena {
+ public:
+  ShmHaloArena(std::size_t ranks, std::size_t plane_size, std::size_t depth, std::size_t extra_floats);
+  ~ShmHaloArena();
+
+  ShmHaloArena(const ShmHaloArena&) = delete;
+  ShmHaloArena& operator=(const ShmHaloArena&) = delete;
+
+  std::size_t ranks() const { return ranks_; }
+  std::size_t plane_size() const { return plane_size_; }
+  std::size_t depth() const { return depth_; }
+
+  // Ring for the directed link from rank `from` towards its `to` side.
+  struct Ring {
+    std::atomic<std::uint64_t>* head;
+    std::atomic<std::uint64_t>* tail;
+    float* slots;
+  };
+  Ring ring(std::size_t from, HaloSide to) const;
+
+  std::atomic<int>& abort_flag() const { return *abort_; }
+  // Zero-initialised shared scratch of `extra_floats` floats (e.g. for gathering results).
+  float* extra() const { return extra_; }
+
+ private:
+  std::size_t ranks_;
+  std::size_t plane_size_;
+  std::size_t depth_;
+  std::size_t ring_bytes_ = 0;
+  std::size_t bytes_ = 0;
+  void* base_ = nullptr;
+  std::atomic<int>* abort_ = nullptr;
+  unsigned char* rings_ = nullptr;
+  float* extra_ = nullptr;
+};
+
+class ShmRingTransport final : public HaloTransport {
+ public:
+  ShmRingTransport(const ShmHaloArena& arena, std::size_t rank) : arena_(arena), rank_(rank) {}
+
+  std::size_t rank() const override { return rank_; }
+  std::size_t size() const override { return arena_.ranks(); }
+  void send(HaloSide to, const float* plane) override;
+  void recv(HaloSide from, float* plane) override;
+  void abort() override;
+
+ private:
+  const ShmHaloArena& arena_;
+  std::size_t rank_;
+};
+
+}  // namespace rtm3d::rtm_internal
@@ -1,13 +1,70 @@
 #include "Imaging.hpp"
 
+#include <cmath>
+#include <utility>
+
 namespace rtm3d::rtm_internal {
 
 void accumulate_cross_correlation_image(const float* src, const std::vector<float>& rec_field,
                                         std::vector<float>& image) {
-  const auto n = image.size();
+  accumulate_cross_correlation_image(src, rec_field.data(), image.data(), image.size());
+}
+
+void accumulate_cross_correlation_image(const float* src, const float* rec_field, float* image,
+                                        std::size_t n) {
   for (std::size_t i = 0; i < n; ++i) {
     image[i] += src[i] * rec_field[i];
   }
 }
 
+FrequencyAccumulator::FrequencyAccumulator(std::size_t n, std::vector<float> freqs, float dt)
+    : freqs_(std::move(freqs)), dt_(dt), spectra_(2 * n * freqs_.size(), 0.0f), twiddle_(2 * freqs_.size(), 0.0f) {}
+
+void FrequencyAccumulator::set_step(std::size_t it) {
+  constexpr double kTwoPi = 6.283185307179586476925286766559;
+  const double t = static_cast<double>(it) * dt_;
+  for (std::size_t f = 0; f < freqs_.size(); ++f) {
+    // Reduce the phase in double so late steps keep full float accuracy.
+    const double phase = kTwoPi * std::fmod(static_cast<double>(freqs_[f]) * t, 1.0);
+    twiddle_[2 * f] = static_cast<float>(std::cos(phase));
+    twiddle_[2 * f + 1] = static_cast<float>(-std::sin(phase));
+  }
+}
+
+void FrequencyAccumulator::accumulate(const float* field, std::size_t begin, std::size_t end) {
+  const std::size_t nf = freqs_.size();
+  const float* tw = twiddle_.data();
+  for (std::size_t i = begin; i < end; ++i) {
+    const float u = field[i];
+    if (u == 0.0f) continue;  // most of the grid before the wavefront arrives
+    float* s = spectra_.data() + 2 * nf * i;
+    for (std::size_t k = 0; k < 2 * nf; ++k) s[k] += u * tw[k];
+  }
+}
+
+std::vector<float> frequency_image_weights(const std::vector<float>& freqs, float dt, std::size_t nt) {
+  const double nyquist = 0.5 / dt;
+  const double df = freqs.size() > 1 ? (freqs.back() - freqs.front()) / static_cast<double>(freqs.size() - 1)
+                                     : 1.0 / (static_cast<double>(nt) * dt);
+  std::vector<float> w(freqs.size());
+  for (std::size_t f = 0; f < freqs.size(); ++f) {
+    const bool unpaired = freqs[f] <= 0.0f || std::abs(freqs[f] - nyquist) < 1e-6 * nyquist;
+    w[f] = static_cast<float>((unpaired ? 1.0 : 2.0) * df * dt);
+  }
+  return w;
+}
+
+void accumulate_frequency_image(const FrequencyAccumulator& src, const FrequencyAccumulator& rec,
+                                const std::vector<float>& weights, float* image, std::size_t begin,
+                                std::size_t end) {
+  const std::size_t nf = weights.size();
+  for (std::size_t i = begin; i < end; ++i) {
+    const float* s = src.data() + 2 * nf * i;
+    const float* r = rec.data() + 2 * nf * i;
+    float sum = 0.0f;
+    for (std::size_t f = 0; f < nf; ++f) sum += weights[f] * (s[2 * f] * r[2 * f] + s[2 * f + 1] * r[2 * f + 1]);
+    image[i] += sum;
+  }
+}
+
 }  // namespace rtm3d::rtm_internal
@@ -1,10 +1,45 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 namespace rtm3d::rtm_internal {
 
 void accumulate_cross_correlation_image(const float* src, const std::vector<float>& rec_field,
                                         std::vector<float>& image);
+void accumulate_cross_correlation_image(const float* src, const float* rec_field, float* image,
+                                        std::size_t n);
+
+// Running DFT U(x, f) = sum_t u(x, t) exp(-i 2 pi f t dt) of a wavefield at fixed frequencies,
+// stored [n][nfreq] as interleaved (re, im) so one pass over the field updates every frequency.
+class FrequencyAccumulator {
+ public:
+  FrequencyAccumulator(std::size_t n, std::vector<float> freqs, float dt);
+
+  // Sets the phase of time step `it`; call once per step before accumulate().
+  void set_step(std::size_t it);
+  // Adds field[begin, end) at the current step. Disjoint ranges may run concurrently.
+  void accumulate(const float* field, std::size_t begin, std::size_t end);
+
+  std::size_t nfreq() const { return freqs_.size(); }
+  const float* data() const { return spectra_.data(); }
+  std::vector<float>& spectra() { return spectra_; }  // for shot checkpoints
+
+ private:
+  std::vector<float> freqs_;
+  float dt_;
+  std::vector<float> spectra_;
+  std::vector<float> twiddle_;  // (cos, -sin) per frequency for the current step
+};
+
+// Quadrature weights that turn sum_f w_f Re(S_f conj(R_f)) into the zero-lag time correlation
+// sum_t s(t) r(t) (Parseval): 2 df dt per frequency, df dt at 0 Hz and at Nyquist. Exact when the
+// frequencies are the DFT bins k / (nt dt), 0 <= k <= nt / 2.
+std::vector<float> frequency_image_weights(const std::vector<float>& freqs, float dt, std::size_t nt);
+
+// image[i] += sum_f weights[f] * Re(src[i, f] * conj(rec[i, f])) for i in [begin, end).
+void accumulate_frequency_image(const FrequencyAccumulator& src, const FrequencyAccumulator& rec,
+                                const std::vector<float>& weights, float* image, std::size_t begin,
+                                std::size_t end);
 
 }  // namespace rtm3d::rtm_internal
@@ -0,0 +1,388 @@
+#include "rtm3d/rtm/JobQueue.hpp"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <mutex>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DurableFile.hpp"
+#include "ShotWindows.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+
+namespace rtm3d {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr const char* kJobFile = "job.json";
+constexpr char kPartialMagic[8] = {'R', 'T', 'M', '3', 'D', 'P', 'I', '1'};
+
+struct PartialHeader {
+  char magic[8];
+  char fingerprint[16];
+  std::uint64_t shot;
+  std::uint64_t x0;
+  std::uint64_t nx;
+  std::uint64_t nz;
+};
+
+struct JobInfo {
+  std::string fingerprint;
+  std::size_t shots{};
+  std::string snapshot_strategy;  // empty unless cross-correlation imaging
+};
+
+std::string shot_file(const std::string& dir, const char* sub, std::size_t k, const char* ext) {
+  char name[40];
+  std::snprintf(name, sizeof(name), "/%s/shot_%06zu.%s", sub, k, ext);
+  return dir + name;
+}
+
+std::string lease_path(const JobOptions& job, std::size_t k) { return shot_file(job.dir, "leases", k, "lease"); }
+std::string partial_path(const JobOptions& job, std::size_t k) { return shot_file(job.dir, "partials", k, "bin"); }
+
+std::string default_worker_id() {
+  char host[256] = {};
+  if (::gethostname(host, sizeof(host) - 1) != 0) std::strcpy(host, "localhost");
+  return std::string(host) + ":" + std::to_string(::getpid());
+}
+
+bool read_job_file(const std::string& dir, JobInfo& info) {
+  std::ifstream f(dir + "/" + kJobFile);
+  if (!f) return false;
+  const std::string s((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  std::smatch m;
+  if (!std::regex_search(s, m, std::regex("\"fingerprint\"\\s*:\\s*\"([0-9a-f]+)\""))) {
+    throw std::runtime_error("corrupt job file in " + dir);
+  }
+  info.fingerprint = m[1].str();
+  if (!std::regex_search(s, m, std::regex("\"shots\"\\s*:\\s*([0-9]+)"))) {
+    throw std::runtime_error("corrupt job file in " + dir);
+  }
+  info.shots = std::stoul(m[1].str());
+  info.snapshot_strategy.clear();
+  if (std::regex_search(s, m, std::regex("\"snapshot_strategy\"\\s*:\\s*\"([a-z_]+)\""))) {
+    info.snapshot_strategy = m[1].str();
+  }
+  return true;
+}
+
+JobInfo require_job(const JobOptions& job, const std::string& fingerprint) {
+  JobInfo info;
+  if (!read_job_file(job.dir, info)) throw std::runtime_error("no job in " + job.dir + "; run init_job_dir first");
+  if (info.fingerprint != fingerprint) {
+    throw std::runtime_error("job in " + job.dir + " was created for a different model, configuration or survey");
+  }
+  return info;
+}
+
+// Age of a lease's heartbeat, or a negative value if the lease does not exist.
+double lease_age(const std::string& path) {
+  std::error_code ec;
+  const auto t = fs::last_write_time(path, ec);
+  if (ec) return -1.0;
+  return std::chrono::duration<double>(fs::file_time_type::clock::now() - t).count();
+}
+
+// Takes an expired lease out of the way: moves it under a name only this thread uses and checks
+// its age again. Another worker may have broken the lease and claimed a fresh one since our age
+// check; that lease is put back (link() never replaces a newer claim) and the takeover fails, so of
+// several workers breaking the same expired lease at most one succeeds.
+bool break_lease(const std::string& path, double lease_seconds) {
+  static std::atomic<std::uint64_t> serial{0};
+  const std::string dead = path + ".expired." + std::to_string(::getpid()) + "." + std::to_string(serial++);
+  if (std::rename(path.c_str(), dead.c_str()) != 0) return false;
+  const bool expired = lease_age(dead) > lease_seconds;
+  if (!expired) ::link(dead.c_str(), path.c_str());
+  ::unlink(dead.c_str());
+  return expired;
+}
+
+bool try_claim(const std::string& path, const std::string& worker_id, double lease_seconds) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+      const std::string line = worker_id + "\n";
+      const bool ok = ::write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size());
+      ::close(fd);
+      if (!ok) {
+        ::unlink(path.c_str());
+        throw std::runtime_error("cannot write lease " + path + ": " + std::strerror(errno));
+      }
+      return true;
+    }
+    if (errno != EEXIST) throw std::runtime_error("cannot create lease " + path + ": " + std::strerror(errno));
+    if (lease_age(path) <= lease_seconds || !break_lease(path, lease_seconds)) return false;
+  }
+  return false;
+}
+
+// Holds a claimed lease: a thread refreshes its mtime every quarter lease until release().
+class Lease {
+ public:
+  Lease(std::string path, std::string worker_id, double lease_seconds)
+      : path_(std::move(path)), worker_id_(std::move(worker_id)) {
+    const auto period = std::chrono::duration<double>(lease_seconds / 4.0);
+    heartbeat_ = std::thread([this, period] {
+      std::unique_lock<std::mutex> lock(mu_);
+      while (!cv_.wait_for(lock, period, [this] { return stop_; })) {
+        std::error_code ec;
+        fs::last_write_time(path_, fs::file_time_type::clock::now(), ec);
+      }
+    });
+  }
+  ~Lease() { release(); }
+  Lease(const Lease&) = delete;
+  Lease& operator=(const Lease&) = delete;
+
+  // Removes the lease unless another worker has taken it over meanwhile.
+  void release() {
+    if (!heartbeat_.joinable()) return;
+    {
+      const std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    heartbeat_.join();
+    std::ifstream f(path_);
+    std::string owner;
+    if (f && std::getline(f, owner) && owner == worker_id_) {
+      f.close();
+      ::unlink(path_.c_str());
+    }
+  }
+
+ private:
+  std::string path_;
+  std::string worker_id_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread heartbeat_;
+};
+
+void write_partial(const std::string& path, const std::string& fingerprint, std::size_t shot, std::size_t x0,
+                   const MigrationResult& image) {
+  PartialHeader h{};
+  std::memcpy(h.magic, kPartialMagic, sizeof(kPartialMagic));
+  std::memcpy(h.fingerprint, fingerprint.data(), std::min(fingerprint.size(), sizeof(h.fingerprint)));
+  h.shot = shot;
+  h.x0 = x0;
+  h.nx = image.nx;
+  h.nz = image.nz;
+  rtm_internal::DurableFileWriter w(path);
+  w.write(&h, sizeof(h));
+  w.write(image.inline_xz.data(), image.inline_xz.size() * sizeof(float));
+  w.commit();
+}
+
+MigrationResult read_partial(const std::string& path, const std::string& fingerprint, std::size_t shot,
+                             std::size_t x0, std::size_t nx, std::size_t nz) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) throw std::runtime_error("shot " + std::to_string(shot) + " has no partial image: " + path);
+  PartialHeader h{};
+  if (!f.read(reinterpret_cast<char*>(&h), sizeof(h)) ||
+      std::memcmp(h.magic, kPartialMagic, sizeof(kPartialMagic)) != 0) {
+    throw std::runtime_error("corrupt partial image: " + path);
+  }
+  if (fingerprint.compare(0, sizeof(h.fingerprint), h.fingerprint, sizeof(h.fingerprint)) != 0 || h.shot != shot ||
+      h.x0 != x0 || h.nx != nx || h.nz != nz) {
+    throw std::runtime_error("partial image " + path + " was written for a different survey");
+  }
+  MigrationResult image{.nx = nx, .nz = nz, .inline_xz = std::vector<float>(nx * nz)};
+  if (!f.read(reinterpret_cast<char*>(image.inline_xz.data()),
+              static_cast<std::streamsize>(image.inline_xz.size() * sizeof(float)))) {
+    throw std::runtime_error("truncated partial image: " + path);
+  }
+  return image;
+}
+
+}  // namespace
+
+RtmConfig job_config(const RtmConfig& cfg, const JobOptions& job) {
+  JobInfo info;
+  if (!read_job_file(job.dir, info)) throw std::runtime_error("no job in " + job.dir + "; run init_job_dir first");
+  if (info.snapshot_strategy.empty() || cfg.imaging != ImagingCondition::kCrossCorrelation) return cfg;
+  RtmConfig out = cfg;
+  const auto planned = parse_snapshot_strategy(info.snapshot_strategy);
+  if (cfg.snapshot_strategy == SnapshotStrategy::kAuto) {
+    out.snapshot_strategy = planned;
+  } else if (cfg.snapshot_strategy != planned) {
+    throw std::runtime_error("job in " + job.dir + " was planned with snapshot strategy " + info.snapshot_strategy +
+                             ", not " + snapshot_strategy_name(cfg.snapshot_strategy));
+  }
+  return out;
+}
+
+void init_job_dir(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey, const JobOptions& job) {
+  if (job.dir.empty()) throw std::runtime_error("job directory must not be empty");
+  if (!(job.lease_seconds > 0.0)) throw std::runtime_error("lease_seconds must be > 0");
+  if (!survey.checkpoint_dir.empty() || cfg.state_checkpoint_steps > 0) {
+    throw std::runtime_error("job directories do not support survey checkpoints; partial images replace them");
+  }
+  const auto columns = survey_shot_columns(model, survey);
+  fs::create_directories(job.dir + "/leases");
+  fs::create_directories(job.dir + "/partials");
+
+  JobInfo existing;
+  if (read_job_file(job.dir, existing)) {
+    require_job(job, rtm_internal::survey_fingerprint(model, job_config(cfg, job), survey, columns));
+    return;
+  }
+  // Resolved once here, so workers on hosts with different free RAM all stack the same images.
+  RtmConfig job_cfg = cfg;
+  const bool snapshots = cfg.imaging == ImagingCondition::kCrossCorrelation;
+  if (snapshots) job_cfg.snapshot_strategy = select_snapshot_strategy(model, cfg).chosen;
+  const std::string fingerprint = rtm_internal::survey_fingerprint(model, job_cfg, survey, columns);
+  std::ostringstream s;
+  s << "{\n"
+    << "  \"fingerprint\": \"" << fingerprint << "\",\n"
+    << "  \"shots\": " << columns.size() << ",\n";
+  if (snapshots) s << "  \"snapshot_strategy\": \"" << snapshot_strategy_name(job_cfg.snapshot_strategy) << "\",\n";
+  s << "  \"nx\": " << model.nx << ",\n"
+    << "  \"nz\": " << model.nz << "\n"
+    << "}\n";
+  rtm_internal::write_file_durably(job.dir + "/" + kJobFile, s.str());
+}
+
+std::size_t run_job_worker(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey,
+                           const JobOptions& job, RunProfile* profile) {
+  const auto columns = survey_shot_columns(model, survey);
+  const RtmConfig job_cfg = job_config(cfg, job);
+  const std::string fingerprint = rtm_internal::survey_fingerprint(model, job_cfg, survey, columns);
+  require_job(job, fingerprint);
+  const std::string worker_id = job.worker_id.empty() ? default_worker_id() : job.worker_id;
+  const auto poll = std::chrono::duration<double>(std::min(0.25, job.lease_seconds / 4.0));
+
+  std::size_t migrated = 0;
+  while (true) {
+    bool waiting = false;
+    for (std::size_t k = 0; k < columns.size(); ++k) {
+      const std::string partial = partial_path(job, k);
+      if (fs::exists(partial)) continue;
+      const std::string lease_file = lease_path(job, k);
+      if (!try_claim(lease_file, worker_id, job.lease_seconds)) {
+        waiting = true;
+        continue;
+      }
+      Lease lease(lease_file, worker_id, job.lease_seconds);
+      if (fs::exists(partial)) continue;  // finished by another worker after our existence check
+
+      const auto [x0, x1] = rtm_internal::shot_window(model, columns[k], survey.aperture);
+      RtmConfig shot_cfg = job_cfg;
+      shot_cfg.source_ix = columns[k] - x0;
+      const auto image = (x0 == 0 && x1 == model.nx)
+                             ? run_single_shot_rtm(model, shot_cfg, profile)
+                             : run_single_shot_rtm(rtm_internal::crop_columns(model, x0, x1), shot_cfg, profile);
+      write_partial(partial, fingerprint, k, x0, image);
+      lease.release();
+      if (++migrated == job.max_shots) return migrated;
+    }
+    if (!waiting) return migrated;
+    std::this_thread::sleep_for(poll);
+  }
+}
+
+JobStatus job_status(const JobOptions& job) {
+  JobInfo info;
+  if (!read_job_file(job.dir, info)) throw std::runtime_error("no job in " + job.dir);
+  JobStatus st;
+  st.shots = info.shots;
+  for (std::size_t k = 0; k < info.shots; ++k) {
+    if (fs::exists(partial_path(job, k))) {
+      ++st.done;
+    } else if (const double age = lease_age(lease_path(job, k)); age >= 0.0) {
+      ++(age > job.lease_seconds ? st.expired : st.leased);
+    }
+  }
+  return st;
+}
+
+std::size_t requeue_expired_leases(const JobOptions& job) {
+  std::size_t requeued = 0;
+  std::error_code ec;
+  const std::regex lease("shot_[0-9]+\\.lease");
+  for (const auto& e : fs::directory_iterator(job.dir + "/leases", ec)) {
+    if (!std::regex_match(e.path().filename().string(), lease)) continue;
+    const std::string path = e.path().string();
+    if (lease_age(path) > job.lease_seconds && break_lease(path, job.lease_seconds)) ++requeued;
+  }
+  return requeued;
+}
+
+CoordinatorResult run_job_coordinator(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey,
+                                      const JobOptions& job, std::size_t workers,
+                                      const std::function<pid_t()>& spawn_worker, std::ostream& log) {
+  init_job_dir(model, cfg, survey, job);
+  CoordinatorResult out;
+  std::set<pid_t> live;
+  for (std::size_t w = 0; w < workers; ++w) live.insert(spawn_worker());
+  const auto poll = std::chrono::duration<double>(std::min(0.25, job.lease_seconds / 4.0));
+  while (!live.empty()) {
+    int status = 0;
+    if (const pid_t pid = ::waitpid(-1, &status, WNOHANG); pid > 0) {
+      live.erase(pid);
+      if (WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+      const auto st = job_status(job);
+      log << "warning: worker " << pid << " failed with " << st.done << "/" << st.shots << " shots done\n";
+      if (st.done < st.shots && out.restarts < workers) {
+        ++out.restarts;
+        live.insert(spawn_worker());
+      }
+      continue;
+    }
+    if (const auto requeued = requeue_expired_leases(job); requeued > 0) {
+      out.requeued += requeued;
+      log << "warning: re-queued " << requeued << " expired shot lease(s)\n";
+    }
+    std::this_thread::sleep_for(poll);
+  }
+
+  const auto st = job_status(job);
+  if (st.done < st.shots) {
+    throw std::runtime_error("workers stopped with " + std::to_string(st.shots - st.done) + " shot(s) unfinished in " +
+                             job.dir);
+  }
+  out.survey = reduce_job(model, cfg, survey, job);
+  return out;
+}
+
+SurveyResult reduce_job(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& survey,
+                        const JobOptions& job) {
+  const auto columns = survey_shot_columns(model, survey);
+  const std::string fingerprint = rtm_internal::survey_fingerprint(model, job_config(cfg, job), survey, columns);
+  require_job(job, fingerprint);
+
+  SurveyResult out;
+  out.shots = columns.size();
+  out.stack.nx = model.nx;
+  out.stack.nz = model.nz;
+  out.stack.inline_xz.assign(model.nx * model.nz, 0.0f);
+  for (std::size_t k = 0; k < columns.size(); ++k) {
+    const auto [x0, x1] = rtm_internal::shot_window(model, columns[k], survey.aperture);
+    const auto image = read_partial(partial_path(job, k), fingerprint, k, x0, x1 - x0, model.nz);
+    rtm_internal::add_window(out.stack, image, x0);
+  }
+  return out;
+}
+
+}  // namespace rtm3d
@@ -0,0 +1,186 @@
+#include "rtm3d/rtm/MemoryBudget.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "SnapshotStore.hpp"
+#include "rtm3d/rtm/DepthGrid.hpp"
+
+namespace rtm3d {
+namespace {
+
+// Cost-model constants: a conservative single-process stencil rate and sequential disk bandwidth.
+constexpr double kNominalPointsPerSecond = 3e8;
+constexpr double kNominalDiskBytesPerSecond = 1e9;
+constexpr double kCompressionOverhead = 0.05;  // quantise + dequantise passes per step
+
+std::size_t spill_free_bytes(const RtmConfig& cfg) {
+  std::error_code ec;
+  const auto dir = cfg.spill_dir.empty() ? std::filesystem::temp_directory_path(ec) : std::filesystem::path(cfg.spill_dir);
+  const auto info = std::filesystem::space(dir, ec);
+  return ec ? std::numeric_limits<std::size_t>::max() : static_cast<std::size_t>(info.available);
+}
+
+// Points of the propagation grid, which a stretched depth grid makes smaller than the model's.
+std::size_t grid_points(const GridModel2D& model, const RtmConfig& cfg) {
+  return model.nx * cfg.ny * propagation_depth_grid(model, cfg).z.size();
+}
+
+// Three live wavefields, velocity, damping and image volumes, plus the recorded gather.
+std::size_t common_shot_bytes(const GridModel2D& model, const RtmConfig& cfg) {
+  const std::size_t f = sizeof(float);
+  const std::size_t n = grid_points(model, cfg);
+  const std::size_t nrec = std::max<std::size_t>(2, model.nx / std::max<std::size_t>(1, cfg.receiver_stride));
+  std::size_t common = 6 * n * f + cfg.nt * nrec * f;
+  if (cfg.precision != WavefieldPrecision::kFloat32) {
+    // fp32 fields swap for three 16-bit levels, 16-bit coefficient/damping copies and the fp32
+    // view of the current level handed to imaging.
+    common -= 3 * n * f;
+    common += 5 * n * sizeof(std::uint16_t) + n * f;
+  }
+  if (cfg.propagator == PropagatorKind::kPseudoSpectral) common += n * f;  // Laplacian scratch
+  return common;
+}
+
+}  // namespace
+
+bool checkpointed_supported(const RtmConfig& cfg) { return cfg.precision == WavefieldPrecision::kFloat32; }
+
+bool random_boundary_supported(const RtmConfig& cfg) {
+  return cfg.propagator == PropagatorKind::kFiniteDifference && cfg.precision == WavefieldPrecision::kFloat32 &&
+         cfg.max_dz_ratio <= 1.0f && cfg.ranks <= 1;
+}
+
+const char* snapshot_strategy_name(SnapshotStrategy s) {
+  switch (s) {
+    case SnapshotStrategy::kAuto: return "auto";
+    case SnapshotStrategy::kFull: return "full";
+    case SnapshotStrategy::kSubsampled: return "subsampled";
+    case SnapshotStrategy::kCompressed: return "compressed";
+    case SnapshotStrategy::kCheckpointed: return "checkpointed";
+    case SnapshotStrategy::kSpill: return "spill";
+    case SnapshotStrategy::kRandomBoundary: return "random_boundary";
+  }
+  return "unknown";
+}
+
+SnapshotStrategy parse_snapshot_strategy(const std::string& name) {
+  for (const auto s : {SnapshotStrategy::kAuto, SnapshotStrategy::kFull, SnapshotStrategy::kSubsampled,
+                       SnapshotStrategy::kCompressed, SnapshotStrategy::kCheckpointed, SnapshotStrategy::kSpill,
+                       SnapshotStrategy::kRandomBoundary}) {
+    if (name == snapshot_strategy_name(s)) return s;
+  }
+  throw std::runtime_error("unknown snapshot strategy: " + name);
+}
+
+std::size_t detect_available_memory() {
+  std::ifstream f("/proc/meminfo");
+  std::string key;
+  std::size_t value = 0;
+  std::string unit;
+  while (f >> key >> value >> unit) {
+    if (key == "MemAvailable:") return value * 1024;
+  }
+  const long pages = sysconf(_SC_AVPHYS_PAGES);
+  const long page = sysconf(_SC_PAGESIZE);
+  return pages > 0 && page > 0 ? static_cast<std::size_t>(pages) * static_cast<std::size_t>(page) : 0;
+}
+
+std::size_t estimate_frequency_imaging_bytes(const GridModel2D& model, const RtmConfig& cfg) {
+  const std::size_t n = grid_points(model, cfg);
+  // Complex source and receiver spectra per frequency.
+  return common_shot_bytes(model, cfg) + 4 * imaging_frequencies(cfg).size() * n * sizeof(float);
+}
+
+std::vector<StrategyEstimate> estimate_snapshot_strategies(const GridModel2D& model, const RtmConfig& cfg) {
+  const std::size_t f = sizeof(float);
+  const std::size_t n = grid_points(model, cfg);
+  const std::size_t nt = cfg.nt;
+  const std::size_t common = common_shot_bytes(model, cfg);
+
+  const std::size_t stride = rtm_internal::effective_snapshot_stride(cfg);
+  const std::size_t interval = rtm_internal::effective_checkpoint_interval(cfg);
+  const double compute_s = 2.0 * static_cast<double>(nt) * static_cast<double>(n) / kNominalPointsPerSecond;
+  const double spill_io_s = 2.0 * static_cast<double>(nt * n * f) / kNominalDiskBytesPerSecond;
+
+  std::vector<StrategyEstimate> estimates{
+      {SnapshotStrategy::kFull, common + nt * n * f, 0, 1.0, true},
+      {SnapshotStrategy::kSubsampled, common + ((nt + stride - 1) / stride) * n * f, 0, 1.0, stride == 1},
+      {SnapshotStrategy::kCompressed, common + nt * n * 2 + nt * f + n * f, 0, 1.0 + kCompressionOverhead, false},
+  };
+  if (checkpointed_supported(cfg)) {
+    estimates.push_back({SnapshotStrategy::kCheckpointed,
+                         common + (((nt + interval - 1) / interval) * 2 + interval + 3) * n * f, 0, 1.5, true});
+  }
+  estimates.push_back(
+      {SnapshotStrategy::kSpill, common + n * f, nt * n * f, 1.0 + spill_io_s / std::max(compute_s, 1e-9), true});
+  if (random_boundary_supported(cfg)) {
+    // Velocity, unit damping and three fields on the grid with pml extra planes on top; the source
+    // is propagated once more forward and once backward.
+    const std::size_t padded = n + model.nx * cfg.ny * cfg.pml;
+    estimates.push_back({SnapshotStrategy::kRandomBoundary, common + 5 * padded * f, 0, 2.0, false});
+  }
+  return estimates;
+}
+
+MemoryPlan select_snapshot_strategy(const GridModel2D& model, const RtmConfig& cfg) {
+  MemoryPlan plan;
+  plan.strategies = estimate_snapshot_strategies(model, cfg);
+  plan.budget_detected = cfg.max_memory_bytes == 0;
+  plan.budget_bytes = plan.budget_detected ? detect_available_memory() : cfg.max_memory_bytes;
+  const std::size_t budget = plan.budget_bytes == 0 ? std::numeric_limits<std::size_t>::max() : plan.budget_bytes;
+  const std::size_t disk_free = spill_free_bytes(cfg);
+
+  auto fits = [&](const StrategyEstimate& e) { return e.ram_bytes <= budget && e.disk_bytes <= disk_free; };
+  if (cfg.snapshot_strategy != SnapshotStrategy::kAuto || cfg.ranks > 1) {
+    plan.chosen = cfg.snapshot_strategy == SnapshotStrategy::kAuto ? SnapshotStrategy::kFull : cfg.snapshot_strategy;
+    const auto it = std::find_if(plan.strategies.begin(), plan.strategies.end(),
+                                 [&](const auto& e) { return e.strategy == plan.chosen; });
+    plan.fits = it != plan.strategies.end() && fits(*it);  // absent: unsupported by cfg
+    return plan;
+  }
+
+  auto ranked = plan.strategies;
+  std::stable_sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+    if (a.relative_cost != b.relative_cost) return a.relative_cost < b.relative_cost;
+    return a.exact && !b.exact;
+  });
+  for (const auto& e : ranked) {
+    if (fits(e)) {
+      plan.chosen = e.strategy;
+      return plan;
+    }
+  }
+  plan.fits = false;
+  plan.chosen = std::min_element(plan.strategies.begin(), plan.strategies.end(), [](const auto& a, const auto& b) {
+                  return a.ram_bytes < b.ram_bytes;
+                })->strategy;
+  return plan;
+}
+
+void write_memory_plan_json(const std::string& path, const MemoryPlan& plan) {
+  std::ofstream f(path);
+  if (!f) throw std::runtime_error("cannot write memory plan: " + path);
+  f << "{\n"
+    << "  \"budget_bytes\": " << plan.budget_bytes << ",\n"
+    << "  \"budget_source\": \"" << (plan.budget_detected ? "available_ram" : "max_memory") << "\",\n"
+    << "  \"chosen\": \"" << snapshot_strategy_name(plan.chosen) << "\",\n"
+    << "  \"fits\": " << (plan.fits ? "true" : "false") << ",\n"
+    << "  \"strategies\": [\n";
+  for (std::size_t i = 0; i < plan.strategies.size(); ++i) {
+    const auto& e = plan.strategies[i];
+    f << "    {\"name\": \"" << snapshot_strategy_name(e.strategy) << "\", \"ram_bytes\": " << e.ram_bytes
+      << ", \"disk_bytes\": " << e.disk_bytes << ", \"relative_cost\": " << e.relative_cost
+      << ", \"exact\": " << (e.exact ? "true" : "false") << "}" << (i + 1 < plan.strategies.size() ? "," : "") << "\n";
+  }
+  f << "  ]\n}\n";
+}
+
+}  // namespace rtm3d
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rtm3d::rtm_internal {
+
+// Persistent fork-join pool for the per-step kernels. The calling thread takes the first chunk, so
+// a pool of size 1 spawns no threads and runs everything inline.
+class WorkerPool {
+ public:
+  explicit WorkerPool(std::size_t threads);  // 0 means std::thread::hardware_concurrency()
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  std::size_t size() const { return workers_.size() + 1; }
+
+  // Splits [0, count) into at most size() contiguous chunks and runs fn(begin, end) on each.
+  // Blocks until all chunks are done; rethrows the first exception raised by a chunk.
+  void parallel_for(std::size_t count, const std::function<void(std::size_t, std::size_t)>& fn);
+
+ private:
+  void worker_loop(std::size_t id);
+  void run_chunk(std::size_t id);
+
+  std::vector<std::thread> workers_;
+  std::mutex mu_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  std::size_t generation_ = 0;
+  std::size_t pending_ = 0;
+  bool stop_ = false;
+
+  const std::function<void(std::size_t, std::size_t)>* fn_ = nullptr;
+  std::size_t count_ = 0;
+  std::size_t chunks_ = 0;
+  std::exception_ptr error_;
+};
+
+}  // namespace rtm3d::rtm_internal
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rtm3d/rtm/RunProfile.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// Blocking FIFO between two pipeline stages. push() waits while `capacity` items are queued, so a
+// fast producer cannot run ahead of its consumer by more than that.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(std::size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+  // False when the queue was closed, e.g. because the consumer failed; the item is dropped.
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(mu_);
+    not_full_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+    if (closed_) return false;
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Empty once the queue is closed and drained.
+  std::optional<T> pop() {
+    std::unique_lock<std::mutex> lock(mu_);
+    not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+    if (items_.empty()) return std::nullopt;
+    T item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return item;
+  }
+
+  // Ends the stream: pop() drains what is queued, push() fails.
+  void close() {
+    const std::lock_guard<std::mutex> lock(mu_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  // Ends the stream and drops what is queued: pop() returns empty at once, push() fails.
+  void cancel() {
+    const std::lock_guard<std::mutex> lock(mu_);
+    items_.clear();
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+ private:
+  std::size_t capacity_;
+  std::mutex mu_;
+  std::condition_variable not_empty_, not_full_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+// Splits one stage thread's time into waiting for input, working and waiting to hand on output.
+class StageClock {
+ public:
+  explicit StageClock(std::string name) { stats_.name = std::move(name); }
+
+  template <typename T>
+  std::optional<T> pop(BoundedQueue<T>& q) {
+    const auto t0 = now();
+    auto item = q.pop();
+    stats_.input_wait_seconds += since(t0);
+    return item;
+  }
+  template <typename T>
+  bool push(BoundedQueue<T>& q, T item) {
+    const auto t0 = now();
+    const bool ok = q.push(std::move(item));
+    stats_.output_wait_seconds += since(t0);
+    return ok;
+  }
+  template <typename F>
+  auto work(F&& f) {
+    const auto t0 = now();
+    struct Done {
+      StageClock& c;
+      std::chrono::steady_clock::time_point t0;
+      ~Done() {
+        c.stats_.busy_seconds += since(t0);
+        c.stats_.items += 1;
+      }
+    } done{*this, t0};
+    return f();
+  }
+
+  StageStats finish(double wall_seconds) {
+    stats_.wall_seconds = wall_seconds;
+    return stats_;
+  }
+
+ private:
+  static std::chrono::steady_clock::time_point now() { return std::chrono::steady_clock::now(); }
+  static double since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+  }
+
+  StageStats stats_;
+};
+
+// Passes every item k < count with !skip[k], in order, through prepare(k) -> migrate(job) ->
+// stack(result); migrate may move from its job. Threaded, prepare and stack run on their own
+// threads joined to the calling thread (which migrates) by queues of `depth` items. The first
+// exception drops the queued jobs, so migrate starts no further item while stack still finishes
+// the results already queued, and it is rethrown once the threads are joined. Otherwise each item
+// runs through all three inline.
+template <typename Prepare, typename Migrate, typename Stack>
+void run_stages(std::size_t count, const std::vector<bool>& skip, std::size_t depth, bool threaded, Prepare&& prepare,
+                Migrate&& migrate, Stack&& stack, StageClock& prepare_clock, StageClock& migrate_clock,
+                StageClock& stack_clock) {
+  using Job = decltype(prepare(std::size_t{}));
+  using Result = decltype(migrate(std::declval<Job&>()));
+  if (!threaded) {
+    for (std::size_t k = 0; k < count; ++k) {
+      if (skip[k]) continue;
+      auto job = prepare_clock.work([&] { return prepare(k); });
+      const auto result = migrate_clock.work([&] { return migrate(job); });
+      stack_clock.work([&] { stack(result); });
+    }
+    return;
+  }
+
+  BoundedQueue<Job> jobs(depth);
+  BoundedQueue<Result> results(depth);
+  std::exception_ptr error;
+  std::mutex error_mu;
+  const auto fail = [&] {
+    {
+      const std::lock_guard<std::mutex> lock(error_mu);
+      if (!error) error = std::current_exception();
+    }
+    jobs.cancel();
+    results.close();
+  };
+
+  std::thread prepare_thread([&] {
+    try {
+      for (std::size_t k = 0; k < count; ++k) {
+        if (skip[k]) continue;
+        if (!prepare_clock.push(jobs, prepare_clock.work([&] { return prepare(k); }))) break;
+      }
+      jobs.close();
+    } catch (...) {
+      fail();
+    }
+  });
+  std::thread stack_thread([&] {
+    try {
+      while (const auto item = stack_clock.pop(results)) stack_clock.work([&] { stack(*item); });
+    } catch (...) {
+      fail();
+    }
+  });
+  try {
+    while (auto job = migrate_clock.pop(jobs)) {
+      if (!migrate_clock.push(results, migrate_clock.work([&] { return migrate(*job); }))) break;
+    }
+    results.close();
+  } catch (...) {
+    fail();
+  }
+  prepare_thread.join();
+  stack_thread.join();
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace rtm3d::rtm_internal
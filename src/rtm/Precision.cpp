@@ -0,0 +1,111 @@
+#include "rtm3d/rtm/Precision.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace rtm3d {
+namespace {
+
+struct Errors {
+  double relative_l2{};
+  double relative_max{};
+  double correlation{};
+};
+
+Errors compare(const std::vector<float>& values, const std::vector<float>& reference) {
+  double diff2 = 0.0, ref2 = 0.0, val2 = 0.0, dot = 0.0, diff_max = 0.0, ref_max = 0.0;
+  for (std::size_t i = 0; i < reference.size(); ++i) {
+    const double r = reference[i];
+    const double v = values[i];
+    diff2 += (v - r) * (v - r);
+    ref2 += r * r;
+    val2 += v * v;
+    dot += v * r;
+    diff_max = std::max(diff_max, std::abs(v - r));
+    ref_max = std::max(ref_max, std::abs(r));
+  }
+  Errors e;
+  e.relative_l2 = ref2 > 0.0 ? std::sqrt(diff2 / ref2) : std::sqrt(diff2);
+  e.relative_max = ref_max > 0.0 ? diff_max / ref_max : diff_max;
+  e.correlation = ref2 > 0.0 && val2 > 0.0 ? dot / std::sqrt(ref2 * val2) : 0.0;
+  return e;
+}
+
+template <typename F>
+double timed(F&& f) {
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+}  // namespace
+
+const char* wavefield_precision_name(WavefieldPrecision p) {
+  switch (p) {
+    case WavefieldPrecision::kFloat32: return "fp32";
+    case WavefieldPrecision::kFloat16: return "fp16";
+    case WavefieldPrecision::kBFloat16: return "bf16";
+  }
+  return "unknown";
+}
+
+WavefieldPrecision parse_wavefield_precision(const std::string& name) {
+  for (const auto p : {WavefieldPrecision::kFloat32, WavefieldPrecision::kFloat16, WavefieldPrecision::kBFloat16}) {
+    if (name == wavefield_precision_name(p)) return p;
+  }
+  throw std::runtime_error("unknown wavefield precision: " + name);
+}
+
+PrecisionReport compare_precision_to_fp32(const GridModel2D& model, const RtmConfig& cfg) {
+  RtmConfig ref_cfg = cfg;
+  ref_cfg.precision = WavefieldPrecision::kFloat32;
+  ref_cfg.state_checkpoint_steps = 0;
+  RtmConfig test_cfg = cfg;
+  test_cfg.state_checkpoint_steps = 0;
+
+  PrecisionReport r;
+  r.precision = cfg.precision;
+  MigrationResult reference, image;
+  r.reference_seconds = timed([&] { reference = run_single_shot_rtm(model, ref_cfg); });
+  r.seconds = timed([&] { image = run_single_shot_rtm(model, test_cfg); });
+  const auto e = compare(image.inline_xz, reference.inline_xz);
+  r.image_relative_l2 = e.relative_l2;
+  r.image_relative_max = e.relative_max;
+  r.image_correlation = e.correlation;
+
+  const auto ref_gather = run_forward_modeling(model, ref_cfg);
+  const auto gather = run_forward_modeling(model, test_cfg);
+  r.gather_relative_l2 = compare(gather.traces, ref_gather.traces).relative_l2;
+  return r;
+}
+
+void write_precision_report_json(const std::string& path, const PrecisionReport& r) {
+  std::ofstream f(path);
+  if (!f) throw std::runtime_error("cannot write precision report: " + path);
+  f << "{\n"
+    << "  \"precision\": \"" << wavefield_precision_name(r.precision) << "\",\n"
+    << "  \"reference\": \"fp32\",\n"
+    << "  \"image_relative_l2\": " << r.image_relative_l2 << ",\n"
+    << "  \"image_relative_max\": " << r.image_relative_max << ",\n"
+    << "  \"image_correlation\": " << r.image_correlation << ",\n"
+    << "  \"gather_relative_l2\": " << r.gather_relative_l2 << ",\n"
+    << "  \"seconds\": " << r.seconds << ",\n"
+    << "  \"reference_seconds\": " << r.reference_seconds << "\n"
+    << "}\n";
+}
+
+std::string format_precision_report(const PrecisionReport& r) {
+  std::ostringstream s;
+  s << "precision " << wavefield_precision_name(r.precision) << " vs fp32: image rel_l2=" << r.image_relative_l2
+    << " rel_max=" << r.image_relative_max << " corr=" << r.image_correlation
+    << " gather rel_l2=" << r.gather_relative_l2 << " time " << r.seconds << " s vs " << r.reference_seconds
+    << " s\n";
+  return s.str();
+}
+
+}  // namespace rtm3d
@@ -2,26 +2,157 @@
 
 #include <algorithm>
 
+#include "PseudoSpectral.hpp"
+
 namespace rtm3d::rtm_internal {
+namespace {
+
+// Centred second difference of f at i along the axis whose neighbours are `stride` apart.
+inline float second_difference(const std::vector<float>& f, std::size_t i, std::size_t stride, float h) {
+  return (f[i + stride] - 2.0f * f[i] + f[i - stride]) / (h * h);
+}
+
+// Damped leapfrog update of interior point i, shared by every FD kernel; `d2z` is the kernel's z term.
+inline float fd_point(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx, float dy,
+                      const std::vector<float>& prev, const std::vector<float>& cur, std::size_t i, float d2z) {
+  const float lap = second_difference(cur, i, 1, dx) + second_difference(cur, i, vel.nx(), dy) + d2z;
+  const float v = vel.raw()[i];
+  return (2.0f * cur[i] - prev[i] + (v * v) * (dt * dt) * lap) * damp[i];
+}
+
+}  // namespace
 
 void step_fd3d(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx, float dy,
                float dz, const std::vector<float>& prev, const std::vector<float>& cur,
                std::vector<float>& nxt) {
   std::fill(nxt.begin(), nxt.end(), 0.0f);
+  if (vel.nz() < 3) return;
+  step_fd3d_planes(vel, damp, dt, dx, dy, dz, prev, cur, nxt, 1, vel.nz() - 1);
+}
+
+void step_fd3d_planes(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx,
+                      float dy, float dz, const std::vector<float>& prev,
+                      const std::vector<float>& cur, std::vector<float>& nxt, std::size_t iz_begin,
+                      std::size_t iz_end) {
+  const std::size_t plane = vel.nx() * vel.ny();
+
+  for (std::size_t iz = iz_begin; iz < iz_end; ++iz) {
+    std::fill(nxt.begin() + iz * plane, nxt.begin() + (iz + 1) * plane, 0.0f);
+    for (std::size_t iy = 1; iy + 1 < vel.ny(); ++iy) {
+      for (std::size_t ix = 1; ix + 1 < vel.nx(); ++ix) {
+        const auto i = vel.index(ix, iy, iz);
+        nxt[i] = fd_point(vel, damp, dt, dx, dy, prev, cur, i, second_difference(cur, i, plane, dz));
+      }
+    }
+  }
+}
+
+DepthStencil make_depth_stencil(const std::vector<float>& depths) {
+  DepthStencil s{std::vector<float>(depths.size(), 0.0f), std::vector<float>(depths.size(), 0.0f)};
+  for (std::size_t iz = 1; iz + 1 < depths.size(); ++iz) {
+    const double hm = double(depths[iz]) - depths[iz - 1];
+    const double hp = double(depths[iz + 1]) - depths[iz];
+    s.below[iz] = static_cast<float>(2.0 / (hm * (hm + hp)));
+    s.above[iz] = static_cast<float>(2.0 / (hp * (hm + hp)));
+  }
+  return s;
+}
 
-  for (std::size_t iz = 1; iz + 1 < vel.nz(); ++iz) {
+void step_fd3d_planes_stretched(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx,
+                                float dy, const DepthStencil& depth, const std::vector<float>& prev,
+                                const std::vector<float>& cur, std::vector<float>& nxt, std::size_t iz_begin,
+                                std::size_t iz_end) {
+  const std::size_t plane = vel.nx() * vel.ny();
+
+  for (std::size_t iz = iz_begin; iz < iz_end; ++iz) {
+    std::fill(nxt.begin() + iz * plane, nxt.begin() + (iz + 1) * plane, 0.0f);
+    const float wb = depth.below[iz];
+    const float wa = depth.above[iz];
     for (std::size_t iy = 1; iy + 1 < vel.ny(); ++iy) {
       for (std::size_t ix = 1; ix + 1 < vel.nx(); ++ix) {
         const auto i = vel.index(ix, iy, iz);
-        const float d2x = (cur[vel.index(ix + 1, iy, iz)] - 2.0f * cur[i] + cur[vel.index(ix - 1, iy, iz)]) / (dx * dx);
-        const float d2y = (cur[vel.index(ix, iy + 1, iz)] - 2.0f * cur[i] + cur[vel.index(ix, iy - 1, iz)]) / (dy * dy);
-        const float d2z = (cur[vel.index(ix, iy, iz + 1)] - 2.0f * cur[i] + cur[vel.index(ix, iy, iz - 1)]) / (dz * dz);
-        const float lap = d2x + d2y + d2z;
-        const float v = vel.raw()[i];
-        nxt[i] = (2.0f * cur[i] - prev[i] + (v * v) * (dt * dt) * lap) * damp[i];
+        const float d2z = wb * (cur[i - plane] - cur[i]) + wa * (cur[i + plane] - cur[i]);
+        nxt[i] = fd_point(vel, damp, dt, dx, dy, prev, cur, i, d2z);
+      }
+    }
+  }
+}
+
+void step_fd3d_tiled(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx,
+                     float dy, float dz, const std::vector<float>& prev,
+                     const std::vector<float>& cur, std::vector<float>& nxt, std::size_t iy_begin,
+                     std::size_t iy_end, const FdKernelTuning& tiling) {
+  const std::size_t plane = vel.nx() * vel.ny();
+  const std::size_t x_end = vel.nx() - 1;
+  const std::size_t ty = tiling.tile_y > 0 ? tiling.tile_y : iy_end - iy_begin;
+  const std::size_t tx = tiling.tile_x > 0 ? tiling.tile_x : x_end - 1;
+
+  for (std::size_t y0 = iy_begin; y0 < iy_end; y0 += ty) {
+    const std::size_t y1 = std::min(iy_end, y0 + ty);
+    for (std::size_t x0 = 1; x0 < x_end; x0 += tx) {
+      const std::size_t x1 = std::min(x_end, x0 + tx);
+      for (std::size_t iz = 1; iz + 1 < vel.nz(); ++iz) {
+        for (std::size_t iy = y0; iy < y1; ++iy) {
+          for (std::size_t ix = x0; ix < x1; ++ix) {
+            const auto i = vel.index(ix, iy, iz);
+            nxt[i] = fd_point(vel, damp, dt, dx, dy, prev, cur, i, second_difference(cur, i, plane, dz));
+          }
+        }
       }
     }
   }
 }
 
+void FdPropagator::step(const std::vector<float>& prev, const std::vector<float>& cur,
+                        std::vector<float>& nxt) {
+  const std::size_t nx = vel_.nx();
+  const std::size_t ny = vel_.ny();
+  const std::size_t nz = vel_.nz();
+  const std::size_t plane = nx * ny;
+  std::fill(nxt.begin(), nxt.begin() + static_cast<std::ptrdiff_t>(plane), 0.0f);
+  std::fill(nxt.end() - static_cast<std::ptrdiff_t>(plane), nxt.end(), 0.0f);
+  if (nz < 3) return;
+
+  if (depth_) {
+    pool_.parallel_for(nz - 2, [&](std::size_t b, std::size_t e) {
+      step_fd3d_planes_stretched(vel_, damp_, dt_, dx_, dy_, *depth_, prev, cur, nxt, b + 1, e + 1);
+    });
+    return;
+  }
+
+  if (tuning_.order == FdKernelTuning::LoopOrder::kYzx && ny >= 3 && nx >= 3) {
+    // Tiles only write interior points, so clear the y and x borders of the interior planes.
+    for (std::size_t iz = 1; iz + 1 < nz; ++iz) {
+      auto* p = nxt.data() + iz * plane;
+      std::fill(p, p + nx, 0.0f);
+      std::fill(p + (ny - 1) * nx, p + plane, 0.0f);
+      for (std::size_t iy = 1; iy + 1 < ny; ++iy) {
+        p[iy * nx] = 0.0f;
+        p[iy * nx + nx - 1] = 0.0f;
+      }
+    }
+    const std::size_t rows = ny - 2;
+    const std::size_t ty = tuning_.tile_y > 0 ? std::min(tuning_.tile_y, rows) : rows;
+    const std::size_t tiles = (rows + ty - 1) / ty;
+    pool_.parallel_for(tiles, [&](std::size_t b, std::size_t e) {
+      step_fd3d_tiled(vel_, damp_, dt_, dx_, dy_, dz_, prev, cur, nxt, 1 + b * ty, std::min(ny - 1, 1 + e * ty),
+                      tuning_);
+    });
+    return;
+  }
+
+  pool_.parallel_for(nz - 2, [&](std::size_t b, std::size_t e) {
+    step_fd3d_planes(vel_, damp_, dt_, dx_, dy_, dz_, prev, cur, nxt, b + 1, e + 1);
+  });
+}
+
+std::unique_ptr<Propagator> make_propagator(const RtmConfig& cfg, const Volume3D& vel,
+                                            const std::vector<float>& damp, float dx, float dz,
+                                            WorkerPool& pool, const DepthStencil* depth) {
+  if (cfg.propagator == PropagatorKind::kPseudoSpectral) {
+    return std::make_unique<PseudoSpectralPropagator>(vel, damp, cfg.dt, dx, cfg.dy, dz, pool);
+  }
+  return std::make_unique<FdPropagator>(vel, damp, cfg.dt, dx, cfg.dy, dz, pool, cfg.fd_tuning, depth);
+}
+
 }  // namespace rtm3d::rtm_internal
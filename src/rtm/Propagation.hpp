@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <vector>
 
+#include "Parallel.hpp"
 #include "rtm3d/core/Volume3D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
 
 namespace rtm3d::rtm_internal {
 
@@ -10,4 +14,68 @@ void step_fd3d(const Volume3D& vel, const std::vector<float>& damp, float dt, fl
                float dz, const std::vector<float>& prev, const std::vector<float>& cur,
                std::vector<float>& nxt);
 
+// Updates only z-planes [iz_begin, iz_end) of nxt; planes outside the range are left untouched.
+// Callers must keep iz_begin >= 1 and iz_end <= nz - 1.
+void step_fd3d_planes(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx,
+                      float dy, float dz, const std::vector<float>& prev,
+                      const std::vector<float>& cur, std::vector<float>& nxt, std::size_t iz_begin,
+                      std::size_t iz_end);
+
+// Updates the interior points of rows [iy_begin, iy_end) on every interior z-plane, y-tile by
+// y-tile (tiling.tile_y rows, tiling.tile_x points per row segment) with z innermost but one, so
+// the three cur planes of a tile stay in cache. Border points of nxt are left untouched.
+void step_fd3d_tiled(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx,
+                     float dy, float dz, const std::vector<float>& prev,
+                     const std::vector<float>& cur, std::vector<float>& nxt, std::size_t iy_begin,
+                     std::size_t iy_end, const FdKernelTuning& tiling);
+
+// Second z-derivative weights of each plane of a non-uniform depth grid (see DepthGrid.hpp):
+// d2z = below[iz] (u[iz-1] - u[iz]) + above[iz] (u[iz+1] - u[iz]), the three-point formula with
+// spacings h- = z[iz] - z[iz-1] and h+ = z[iz+1] - z[iz]. Reduces to 1/dz^2 for uniform spacing.
+struct DepthStencil {
+  std::vector<float> below;
+  std::vector<float> above;
+};
+DepthStencil make_depth_stencil(const std::vector<float>& depths);
+
+// step_fd3d_planes with per-plane z weights instead of a fixed dz.
+void step_fd3d_planes_stretched(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx,
+                                float dy, const DepthStencil& depth, const std::vector<float>& prev,
+                                const std::vector<float>& cur, std::vector<float>& nxt, std::size_t iz_begin,
+                                std::size_t iz_end);
+
+// One leapfrog time step of the damped acoustic wave equation on a fixed grid:
+// nxt = (2 cur - prev + v^2 dt^2 lap(cur)) * damp.
+class Propagator {
+ public:
+  virtual ~Propagator() = default;
+  virtual void step(const std::vector<float>& prev, const std::vector<float>& cur,
+                    std::vector<float>& nxt) = 0;
+};
+
+// Second-order finite differences (step_fd3d). kZyx splits z-planes across the pool; kYzx splits
+// y-tiles (step_fd3d_tiled). With a depth stencil, dz is unused and planes are always split.
+class FdPropagator final : public Propagator {
+ public:
+  FdPropagator(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx, float dy,
+               float dz, WorkerPool& pool, const FdKernelTuning& tuning = {}, const DepthStencil* depth = nullptr)
+      : vel_(vel), damp_(damp), dt_(dt), dx_(dx), dy_(dy), dz_(dz), pool_(pool), tuning_(tuning), depth_(depth) {}
+
+  void step(const std::vector<float>& prev, const std::vector<float>& cur,
+            std::vector<float>& nxt) override;
+
+ private:
+  const Volume3D& vel_;
+  const std::vector<float>& damp_;
+  float dt_, dx_, dy_, dz_;
+  WorkerPool& pool_;
+  FdKernelTuning tuning_;
+  const DepthStencil* depth_;
+};
+
+// `depth` (FD only) replaces the uniform dz with per-plane weights of a stretched depth grid.
+std::unique_ptr<Propagator> make_propagator(const RtmConfig& cfg, const Volume3D& vel,
+                                            const std::vector<float>& damp, float dx, float dz,
+                                            WorkerPool& pool, const DepthStencil* depth = nullptr);
+
 }  // namespace rtm3d::rtm_internal
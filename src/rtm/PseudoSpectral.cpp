@@ -0,0 +1,102 @@
+#include "PseudoSpectral.hpp"
+
+#include <algorithm>
+#include <complex>
+
+#include "Fft.hpp"
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+constexpr std::size_t kLineBatch = 8;
+constexpr float kTwoPi = 6.28318530717958647692f;
+
+std::vector<float> second_derivative_symbol(std::size_t n, float d) {
+  std::vector<float> s(n);
+  for (std::size_t j = 0; j < n; ++j) {
+    const float m = j <= n / 2 ? static_cast<float>(j) : static_cast<float>(j) - static_cast<float>(n);
+    const float k = kTwoPi * m / (static_cast<float>(n) * d);
+    s[j] = -(k * k) / static_cast<float>(n);
+  }
+  return s;
+}
+
+}  // namespace
+
+PseudoSpectralPropagator::PseudoSpectralPropagator(const Volume3D& vel, const std::vector<float>& damp,
+                                                   float dt, float dx, float dy, float dz,
+                                                   WorkerPool& pool)
+    : vel_(vel), damp_(damp), dt_(dt), pool_(pool), lap_(vel.size(), 0.0f) {
+  const std::size_t nx = vel.nx(), ny = vel.ny(), nz = vel.nz();
+  axes_[0] = {nx, 1, nx, ny * nz, 1, 0, second_derivative_symbol(nx, dx)};
+  axes_[1] = {ny, nx, 1, nx, nz, nx * ny, second_derivative_symbol(ny, dy)};
+  axes_[2] = {nz, nx * ny, 1, nx * ny, 1, 0, second_derivative_symbol(nz, dz)};
+  // Build plans up front so worker threads only ever read the cache.
+  for (const auto& a : axes_) (void)cached_fft_plan(a.len);
+}
+
+void PseudoSpectralPropagator::apply_axis(const AxisLayout& axis, const float* u, float* lap,
+                                          bool accumulate) {
+  const FftPlan& plan = cached_fft_plan(axis.len);
+  const std::size_t blocks_per_outer = (axis.inner + kLineBatch - 1) / kLineBatch;
+
+  pool_.parallel_for(axis.outer * blocks_per_outer, [&](std::size_t begin, std::size_t end) {
+    // Two real lines share one complex transform (line a in the real part, line b in the
+    // imaginary part): the symbol is real and even, so the parts stay separate.
+    std::vector<std::complex<float>> lines((kLineBatch / 2) * axis.len);
+    std::vector<std::complex<float>> scratch(plan.scratch_size());
+
+    for (std::size_t blk = begin; blk < end; ++blk) {
+      const std::size_t o = blk / blocks_per_outer;
+      const std::size_t i0 = (blk % blocks_per_outer) * kLineBatch;
+      const std::size_t count = std::min(kLineBatch, axis.inner - i0);
+      const std::size_t pairs = (count + 1) / 2;
+      const std::size_t start = o * axis.outer_stride + i0 * axis.line_step;
+
+      // For y/z, adjacent lines are adjacent in memory, so each strided gather row is contiguous.
+      for (std::size_t k = 0; k < axis.len; ++k) {
+        const float* row = u + start + k * axis.stride;
+        for (std::size_t p = 0; p < pairs; ++p) {
+          const float a = row[2 * p * axis.line_step];
+          const float b = 2 * p + 1 < count ? row[(2 * p + 1) * axis.line_step] : 0.0f;
+          lines[p * axis.len + k] = {a, b};
+        }
+      }
+      for (std::size_t p = 0; p < pairs; ++p) {
+        auto* line = lines.data() + p * axis.len;
+        plan.forward(line, scratch.data());
+        for (std::size_t k = 0; k < axis.len; ++k) line[k] *= axis.symbol[k];
+        plan.inverse(line, scratch.data());
+      }
+      for (std::size_t k = 0; k < axis.len; ++k) {
+        float* row = lap + start + k * axis.stride;
+        for (std::size_t j = 0; j < count; ++j) {
+          const auto c = lines[(j / 2) * axis.len + k];
+          const float v = j % 2 == 0 ? c.real() : c.imag();
+          float& dst = row[j * axis.line_step];
+          dst = accumulate ? dst + v : v;
+        }
+      }
+    }
+  });
+}
+
+void PseudoSpectralPropagator::laplacian(const std::vector<float>& field, std::vector<float>& lap) {
+  apply_axis(axes_[0], field.data(), lap.data(), false);
+  apply_axis(axes_[1], field.data(), lap.data(), true);
+  apply_axis(axes_[2], field.data(), lap.data(), true);
+}
+
+void PseudoSpectralPropagator::step(const std::vector<float>& prev, const std::vector<float>& cur,
+                                    std::vector<float>& nxt) {
+  laplacian(cur, lap_);
+  const auto& v = vel_.raw();
+  const float dt2 = dt_ * dt_;
+  pool_.parallel_for(nxt.size(), [&](std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i) {
+      nxt[i] = (2.0f * cur[i] - prev[i] + (v[i] * v[i]) * dt2 * lap_[i]) * damp_[i];
+    }
+  });
+}
+
+}  // namespace rtm3d::rtm_internal
@@ -2,70 +2,306 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <stdexcept>
+#include <string>
 
 #include "Boundary.hpp"
+#include "Decomposition.hpp"
 #include "Geometry.hpp"
 #include "Imaging.hpp"
+#include "Parallel.hpp"
 #include "Propagation.hpp"
+#include "ShotCheckpoint.hpp"
+#include "ShotSetup.hpp"
+#include "SnapshotStore.hpp"
+#include "Wavefields.hpp"
 #include "rtm3d/core/Volume3D.hpp"
+#include "rtm3d/rtm/DepthGrid.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/RunPlanner.hpp"
+#include "rtm3d/rtm/RunProfile.hpp"
 
 namespace rtm3d {
 namespace {
 
-void validate_cfg(const GridModel2D& model, const RtmConfig& cfg) {
-  if (model.nx < 8 || model.nz < 8) throw std::runtime_error("model too small");
-  if (model.dx <= 0.0f || model.dz <= 0.0f) throw std::runtime_error("invalid model spacing");
+// Compulsory traffic per grid point: imaging reads both fields and updates the image (steps: see
+// step_bytes_per_point).
+constexpr double kImagingBytesPerPoint = 4.0 * sizeof(float);
+constexpr double kSnapshotBytesPerPoint = 2.0 * sizeof(float);
+
+// Checks a shot on an nx x cfg.ny x nz grid whose fastest velocity is vmax.
+void validate_grid(std::size_t nx, std::size_t nz, float dx, float dz, float vmax, const RtmConfig& cfg) {
+  if (nx < 8 || nz < 8) throw std::runtime_error("model too small");
+  if (dx <= 0.0f || dz <= 0.0f) throw std::runtime_error("invalid model spacing");
   if (cfg.ny < 4 || cfg.nt < 2) throw std::runtime_error("ny/nt too small");
   if (cfg.dy <= 0.0f || cfg.dt <= 0.0f || cfg.f0 <= 0.0f) throw std::runtime_error("invalid RTM scalar parameter");
   if (cfg.receiver_stride == 0) throw std::runtime_error("receiver_stride must be > 0");
   if (cfg.pml == 0) throw std::runtime_error("pml must be > 0");
+  if (cfg.ranks == 0 || cfg.ranks > nz - 2) throw std::runtime_error("ranks must be in [1, nz-2]");
+  if (cfg.ranks > 1 && cfg.propagator != PropagatorKind::kFiniteDifference) {
+    throw std::runtime_error("slab decomposition supports only the finite-difference propagator");
+  }
+  if (cfg.ranks > 1 && cfg.snapshot_strategy != SnapshotStrategy::kAuto &&
+      cfg.snapshot_strategy != SnapshotStrategy::kFull) {
+    throw std::runtime_error("slab decomposition supports only full snapshots");
+  }
+  if (cfg.snapshot_strategy == SnapshotStrategy::kCheckpointed && !checkpointed_supported(cfg)) {
+    throw std::runtime_error("checkpointed snapshots need fp32 wavefields");
+  }
+  if (cfg.snapshot_strategy == SnapshotStrategy::kRandomBoundary && !random_boundary_supported(cfg)) {
+    throw std::runtime_error("random-boundary snapshots need the fp32 fd propagator on a uniform depth grid");
+  }
+  if (cfg.ranks > 1 && cfg.imaging != ImagingCondition::kCrossCorrelation) {
+    throw std::runtime_error("slab decomposition supports only the cross-correlation imaging condition");
+  }
+  if (cfg.source_ix >= nx) throw std::runtime_error("source_ix must be < nx");
+  if (cfg.state_checkpoint_steps > 0 && cfg.imaging != ImagingCondition::kFrequencyDomain) {
+    throw std::runtime_error("intra-shot checkpoints require the frequency-domain imaging condition");
+  }
+  if (cfg.state_checkpoint_steps > 0 && cfg.ranks > 1) {
+    throw std::runtime_error("intra-shot checkpoints support only single-process runs");
+  }
+  if (cfg.precision != WavefieldPrecision::kFloat32) {
+    if (cfg.propagator != PropagatorKind::kFiniteDifference) {
+      throw std::runtime_error("16-bit wavefields support only the finite-difference propagator");
+    }
+    if (cfg.ranks > 1) throw std::runtime_error("16-bit wavefields support only single-process runs");
+    if (cfg.state_checkpoint_steps > 0) throw std::runtime_error("intra-shot checkpoints need fp32 wavefields");
+  }
+  if (!(cfg.max_dz_ratio >= 1.0f)) throw std::runtime_error("max_dz_ratio must be >= 1");
+  if (cfg.max_dz_ratio > 1.0f) {
+    if (cfg.propagator != PropagatorKind::kFiniteDifference) {
+      throw std::runtime_error("stretched depth grids support only the finite-difference propagator");
+    }
+    if (cfg.ranks > 1) throw std::runtime_error("stretched depth grids support only single-process runs");
+    if (cfg.precision != WavefieldPrecision::kFloat32) {
+      throw std::runtime_error("stretched depth grids need fp32 wavefields");
+    }
+  }
+  if (cfg.freq_min < 0.0f || cfg.freq_max < 0.0f) throw std::runtime_error("imaging frequencies must be >= 0");
+  if (cfg.freq_max > 0.0f && cfg.freq_min > cfg.freq_max) throw std::runtime_error("freq_min must be <= freq_max");
+  if (vmax <= 0.0f) throw std::runtime_error("model velocities must be > 0");
+  // A stretched grid never samples finer than dz, so the uniform limit also covers it.
+  const float dt_max = max_stable_dt(cfg.propagator, vmax, dx, cfg.dy, dz);
+  if (cfg.dt > dt_max) {
+    throw std::runtime_error("dt=" + std::to_string(cfg.dt) + " exceeds the stability limit " +
+                             std::to_string(dt_max) + " for vmax=" + std::to_string(vmax) +
+                             " (use --plan/--auto-plan)");
+  }
 }
 
-void forward_source_propagation(const GridModel2D& model, const RtmConfig& cfg, const Volume3D& vel,
-                                const std::vector<float>& damp, const std::vector<float>& wavelet,
-                                std::size_t sx, std::size_t sy, std::size_t sz,
-                                const std::vector<std::size_t>& rx, std::vector<float>& src_snaps,
-                                std::vector<float>& rec_data) {
-  const auto n = vel.size();
-  std::vector<float> src_prev(n, 0.0f), src_cur(n, 0.0f), src_nxt(n, 0.0f);
+void validate_cfg(const GridModel2D& model, const RtmConfig& cfg) {
+  if (model.values.size() != model.nx * model.nz) throw std::runtime_error("model values size mismatch");
+  const float vmax = model.values.empty() ? 0.0f : *std::max_element(model.values.begin(), model.values.end());
+  validate_grid(model.nx, model.nz, model.dx, model.dz, vmax, cfg);
+}
+
+// What the forward pass keeps of the source wavefield, and how the backward pass images with it.
+class ImagingPass {
+ public:
+  virtual ~ImagingPass() = default;
+  virtual void source(std::size_t it, const std::vector<float>& field, RunProfile& profile) = 0;
+  virtual void receiver(std::size_t it, const std::vector<float>& field, RunProfile& profile) = 0;
+  virtual void finish(RunProfile&) {}
+  // Whether step `it` is used at all, so 16-bit wavefields skip converting the others.
+  virtual bool needs(std::size_t) const { return true; }
+  // Accumulated state an intra-shot checkpoint must save; empty when the pass cannot be resumed.
+  virtual std::vector<std::vector<float>*> state() { return {}; }
+};
+
+// Zero-lag cross-correlation with the source field replayed from a SnapshotStore.
+class CrossCorrelationPass final : public ImagingPass {
+ public:
+  CrossCorrelationPass(rtm_internal::SnapshotStore& snaps, std::vector<float>& image)
+      : snaps_(snaps), image_(image), weight_(snaps.weight()) {}
+
+  void source(std::size_t it, const std::vector<float>& field, RunProfile& profile) override {
+    const double points = static_cast<double>(field.size());
+    const auto scope = profile.phase("snapshots", 0.0, points * kSnapshotBytesPerPoint);
+    snaps_.store(it, field);
+  }
+
+  void receiver(std::size_t it, const std::vector<float>& field, RunProfile& profile) override {
+    const auto n = field.size();
+    const double points = static_cast<double>(n);
+    const float* src = nullptr;
+    {
+      const auto scope = profile.phase("snapshots", 0.0, points * kSnapshotBytesPerPoint);
+      src = snaps_.load(it);
+    }
+    if (!src) return;
+    const auto scope = profile.phase("imaging", points, points * kImagingBytesPerPoint);
+    if (weight_ == 1.0f) {
+      rtm_internal::accumulate_cross_correlation_image(src, field.data(), image_.data(), n);
+    } else {
+      for (std::size_t i = 0; i < n; ++i) image_[i] += weight_ * src[i] * field[i];
+    }
+  }
+
+ private:
+  rtm_internal::SnapshotStore& snaps_;
+  std::vector<float>& image_;
+  float weight_;
+};
+
+// Running DFTs of both fields, multiplied once after the backward pass. The fields are band-limited
+// to max(wavelet fmax, highest imaged frequency), so the DFTs only sample every stride-th step, at
+// the Nyquist rate of that band; each decimated sum is 1/stride of the full one.
+class FrequencyDomainPass final : public ImagingPass {
+ public:
+  FrequencyDomainPass(const RtmConfig& cfg, std::size_t n, rtm_internal::WorkerPool& pool, std::vector<float>& image)
+      : freqs_(imaging_frequencies(cfg)), stride_(dft_stride(cfg, freqs_)),
+        weights_(rtm_internal::frequency_image_weights(freqs_, cfg.dt, cfg.nt)),
+        src_(n, freqs_, cfg.dt), rec_(n, freqs_, cfg.dt), pool_(pool), image_(image) {
+    const float scale = static_cast<float>(stride_ * stride_);
+    for (auto& w : weights_) w *= scale;
+  }
+
+  bool needs(std::size_t it) const override { return it % stride_ == 0; }
+  void source(std::size_t it, const std::vector<float>& field, RunProfile& profile) override {
+    if (it % stride_ == 0) accumulate(src_, it, field, profile);
+  }
+  void receiver(std::size_t it, const std::vector<float>& field, RunProfile& profile) override {
+    if (it % stride_ == 0) accumulate(rec_, it, field, profile);
+  }
+
+  void finish(RunProfile& profile) override {
+    const double points = static_cast<double>(image_.size());
+    const auto scope = profile.phase("imaging", points, points * (4.0 * freqs_.size() + 2.0) * sizeof(float));
+    pool_.parallel_for(image_.size(), [&](std::size_t b, std::size_t e) {
+      rtm_internal::accumulate_frequency_image(src_, rec_, weights_, image_.data(), b, e);
+    });
+  }
+
+  std::vector<std::vector<float>*> state() override { return {&src_.spectra(), &rec_.spectra()}; }
 
-  for (std::size_t it = 0; it < cfg.nt; ++it) {
-    rtm_internal::step_fd3d(vel, damp, cfg.dt, model.dx, cfg.dy, model.dz, src_prev, src_cur, src_nxt);
-    src_nxt[vel.index(sx, sy, sz)] += wavelet[it];
+ private:
+  void accumulate(rtm_internal::FrequencyAccumulator& acc, std::size_t it, const std::vector<float>& field,
+                  RunProfile& profile) {
+    const double points = static_cast<double>(field.size());
+    const auto scope = profile.phase("dft", points, points * (1.0 + 4.0 * freqs_.size()) * sizeof(float));
+    acc.set_step(it);
+    pool_.parallel_for(field.size(), [&](std::size_t b, std::size_t e) { acc.accumulate(field.data(), b, e); });
+  }
+
+  static std::size_t dft_stride(const RtmConfig& cfg, const std::vector<float>& freqs) {
+    const float band = std::max(ricker_max_frequency(cfg.f0), freqs.empty() ? 0.0f : freqs.back());
+    return std::max<std::size_t>(1, static_cast<std::size_t>(1.0f / (2.0f * band * cfg.dt)));
+  }
+
+  std::vector<float> freqs_;
+  std::size_t stride_;
+  std::vector<float> weights_;
+  rtm_internal::FrequencyAccumulator src_, rec_;
+  rtm_internal::WorkerPool& pool_;
+  std::vector<float>& image_;
+};
+
+// The current level of `fields` in fp32, timing the conversion from 16-bit storage.
+const std::vector<float>& current_fp32(const RtmConfig& cfg, rtm_internal::Wavefields& fields, RunProfile& profile) {
+  if (cfg.precision == WavefieldPrecision::kFloat32) return fields.current();
+  const double points = static_cast<double>(fields.current().size());
+  const auto scope = profile.phase("precision_convert", points, points * (sizeof(std::uint16_t) + sizeof(float)));
+  return fields.current();
+}
 
-    rtm_internal::record_receivers(vel, sy, sz, rx, src_nxt, rec_data, it);
-    std::copy(src_nxt.begin(), src_nxt.end(), src_snaps.begin() + it * n);
+void forward_source_propagation(const RtmConfig& cfg, const Volume3D& vel, rtm_internal::Wavefields& src,
+                                const std::vector<float>& wavelet, std::size_t sx, std::size_t sy,
+                                std::size_t sz, const std::vector<std::size_t>& rx, ImagingPass& imaging,
+                                std::vector<float>& rec_data, std::size_t first_step,
+                                const std::function<void(std::size_t)>& after_step, RunProfile& profile) {
+  const double points = static_cast<double>(vel.size());
+  const double step_bytes = points * rtm_internal::step_bytes_per_point(cfg);
 
-    src_prev.swap(src_cur);
-    src_cur.swap(src_nxt);
+  for (std::size_t it = first_step; it < cfg.nt; ++it) {
+    {
+      const auto scope = profile.phase("forward_steps", points, step_bytes);
+      src.step();
+      src.add(vel.index(sx, sy, sz), wavelet[it]);
+      src.record_receivers(vel, sy, sz, rx, rec_data, it);
+    }
+    if (imaging.needs(it)) imaging.source(it, current_fp32(cfg, src, profile), profile);
+    after_step(it + 1);
   }
 }
 
-void receiver_backpropagation_and_imaging(const GridModel2D& model, const RtmConfig& cfg,
-                                          const Volume3D& vel, const std::vector<float>& damp,
-                                          std::size_t sy, std::size_t sz,
-                                          const std::vector<std::size_t>& rx,
-                                          const std::vector<float>& src_snaps,
-                                          const std::vector<float>& rec_data,
-                                          std::vector<float>& image) {
-  const auto n = vel.size();
-  std::vector<float> rec_prev(n, 0.0f), rec_cur(n, 0.0f), rec_nxt(n, 0.0f);
+void receiver_backpropagation_and_imaging(const RtmConfig& cfg, const Volume3D& vel, rtm_internal::Wavefields& rec,
+                                          std::size_t sy, std::size_t sz, const std::vector<std::size_t>& rx,
+                                          const std::vector<float>& rec_data, ImagingPass& imaging,
+                                          std::size_t first_step,
+                                          const std::function<void(std::size_t)>& after_step,
+                                          RunProfile& profile) {
+  const double points = static_cast<double>(vel.size());
+  const double step_bytes = points * rtm_internal::step_bytes_per_point(cfg);
 
-  for (std::size_t rit = 0; rit < cfg.nt; ++rit) {
+  for (std::size_t rit = first_step; rit < cfg.nt; ++rit) {
     const std::size_t it = cfg.nt - 1 - rit;
-    rtm_internal::step_fd3d(vel, damp, cfg.dt, model.dx, cfg.dy, model.dz, rec_prev, rec_cur, rec_nxt);
+    {
+      const auto scope = profile.phase("backward_steps", points, step_bytes);
+      rec.step();
+      rec.inject_receivers(vel, sy, sz, rx, rec_data, it);
+    }
+    if (imaging.needs(it)) imaging.receiver(it, current_fp32(cfg, rec, profile), profile);
+    after_step(rit + 1);
+  }
+  imaging.finish(profile);
+}
 
-    rtm_internal::inject_receivers(vel, sy, sz, rx, rec_data, it, rec_nxt);
+using rtm_internal::ShotSetup;
 
-    const auto* src = src_snaps.data() + it * n;
-    rtm_internal::accumulate_cross_correlation_image(src, rec_nxt, image);
+// Damping, wavelet and acquisition geometry on s.vel.
+void finish_shot_setup(ShotSetup& s, const RtmConfig& cfg, RunProfile& prof) {
+  {
+    const double points = static_cast<double>(s.vel.size());
+    const auto scope = prof.phase("damp", points, points * sizeof(float));
+    s.damp = rtm_internal::make_damp(s.vel.nx(), s.vel.ny(), s.vel.nz(), cfg.pml);
+  }
+  s.wavelet = ricker_wavelet(cfg.nt, cfg.dt, cfg.f0);
+  s.sx = cfg.source_ix > 0 ? cfg.source_ix : s.vel.nx() / 2;
+  s.sy = s.vel.ny() / 2;
+  s.sz = 2;
+  s.rx = rtm_internal::make_receiver_positions(s.vel, cfg.receiver_stride);
+}
 
-    rec_prev.swap(rec_cur);
-    rec_cur.swap(rec_nxt);
+ShotSetup prepare_shot(const GridModel2D& model, const RtmConfig& cfg, RunProfile& prof) {
+  ShotSetup s;
+  s.depths = propagation_depth_grid(model, cfg).z;
+  const double points = static_cast<double>(model.nx * cfg.ny * s.depths.size());
+  {
+    const auto scope = prof.phase("velocity_volume", points, points * sizeof(float));
+    if (cfg.max_dz_ratio > 1.0f) {
+      GridModel2D stretched{.nx = model.nx, .nz = s.depths.size(), .dx = model.dx, .dz = model.dz, .values = {}};
+      stretched.values = resample_depth(model.values, model.nx, uniform_depths(model.nz, model.dz), s.depths);
+      s.vel = rtm_internal::make_velocity_volume(stretched, cfg);
+      s.depth_stencil = std::make_unique<rtm_internal::DepthStencil>(rtm_internal::make_depth_stencil(s.depths));
+    } else {
+      s.vel = rtm_internal::make_velocity_volume(model, cfg);
+    }
   }
+  finish_shot_setup(s, cfg, prof);
+  return s;
+}
+
+// A shot on a velocity volume cut from a 3D model, on its uniform depth grid.
+ShotSetup prepare_shot(Volume3D vel, float dz, const RtmConfig& cfg, RunProfile& prof) {
+  ShotSetup s;
+  s.vel = std::move(vel);
+  s.depths = uniform_depths(s.vel.nz(), dz);
+  finish_shot_setup(s, cfg, prof);
+  return s;
 }
 
+// Forward modelling keeps nothing of the source wavefield.
+class NoImagingPass final : public ImagingPass {
+ public:
+  void source(std::size_t, const std::vector<float>&, RunProfile&) override {}
+  void receiver(std::size_t, const std::vector<float>&, RunProfile&) override {}
+  bool needs(std::size_t) const override { return false; }
+};
+
 }  // namespace
 
 std::vector<float> ricker_wavelet(std::size_t nt, float dt, float f0) {
@@ -83,32 +319,191 @@ std::vector<float> ricker_wavelet(std::size_t nt, float dt, float f0) {
   return w;
 }
 
-MigrationResult run_single_shot_rtm(const GridModel2D& model, const RtmConfig& cfg) {
+float ricker_max_frequency(float f0) { return 2.5f * f0; }
+
+std::vector<float> imaging_frequencies(const RtmConfig& cfg) {
+  const float nyquist = 0.5f / cfg.dt;
+  const float fmax = std::min(nyquist, cfg.freq_max > 0.0f ? cfg.freq_max : ricker_max_frequency(cfg.f0));
+  const float fmin = std::min(cfg.freq_min, fmax);
+  std::size_t nf = cfg.nfreq;
+  if (nf == 0) {
+    // DFT bin spacing of the record: coarser sampling wraps the image in time.
+    const double record = static_cast<double>(cfg.nt) * cfg.dt;
+    nf = static_cast<std::size_t>(std::ceil(static_cast<double>(fmax - fmin) * record - 1e-6)) + 1;
+  }
+  std::vector<float> f(nf, fmin);
+  for (std::size_t k = 1; k < nf; ++k) {
+    f[k] = fmin + (fmax - fmin) * static_cast<float>(k) / static_cast<float>(nf - 1);
+  }
+  return f;
+}
+
+namespace rtm_internal {
+
+ShotSetup prepare_rtm_shot(const GridModel2D& model, const RtmConfig& cfg, RunProfile& prof) {
   validate_cfg(model, cfg);
+  return prepare_shot(model, cfg, prof);
+}
 
-  const Volume3D vel = rtm_internal::make_velocity_volume(model, cfg);
+MigrationResult migrate_prepared_shot(const GridModel2D& model, const RtmConfig& cfg, const ShotSetup& shot,
+                                      RunProfile& prof) {
+  const double points = static_cast<double>(shot.vel.size());
+  const auto& vel = shot.vel;
+  const auto& damp = shot.damp;
+  const auto& wavelet = shot.wavelet;
+  const auto& rx = shot.rx;
+  const std::size_t sx = shot.sx, sy = shot.sy, sz = shot.sz;
   const auto n = vel.size();
 
-  const auto damp = rtm_internal::make_damp(vel.nx(), vel.ny(), vel.nz(), cfg.pml);
-  const auto wavelet = ricker_wavelet(cfg.nt, cfg.dt, cfg.f0);
+  MigrationResult out;
+  out.nx = vel.nx();
+  out.nz = model.nz;
+  if (cfg.ranks > 1) {
+    const auto scope = prof.phase("decomposed_shot", 2.0 * points * static_cast<double>(cfg.nt));
+    out.inline_xz = rtm_internal::run_slab_decomposed_shot(model, cfg, vel, damp, wavelet, sx, sy, sz, rx);
+    return out;
+  }
 
-  const std::size_t sx = vel.nx() / 2;
-  const std::size_t sy = vel.ny() / 2;
-  const std::size_t sz = 2;
+  rtm_internal::WorkerPool pool(cfg.threads);
+  const auto prop = rtm_internal::make_propagator(cfg, vel, damp, model.dx, model.dz, pool, shot.depth_stencil.get());
 
-  const auto rx = rtm_internal::make_receiver_positions(vel, cfg.receiver_stride);
-  std::vector<float> src_snaps(cfg.nt * n, 0.0f);
+  std::vector<float> image(n, 0.0f);
   std::vector<float> rec_data(cfg.nt * rx.size(), 0.0f);
+  // Random-boundary strategy: the source's own grid, outliving the store that steps on it.
+  Volume3D random_vel;
+  std::vector<float> random_damp;
+  std::unique_ptr<rtm_internal::Propagator> random_prop;
+  std::unique_ptr<rtm_internal::SnapshotStore> src_snaps;
+  std::unique_ptr<ImagingPass> imaging;
+  if (cfg.imaging == ImagingCondition::kFrequencyDomain) {
+    imaging = std::make_unique<FrequencyDomainPass>(cfg, n, pool, image);
+  } else {
+    RtmConfig store_cfg = cfg;
+    if (store_cfg.snapshot_strategy == SnapshotStrategy::kAuto) {
+      store_cfg.snapshot_strategy = select_snapshot_strategy(model, cfg).chosen;
+    }
+    const std::size_t src_index = vel.index(sx, sy, sz);
+    rtm_internal::ReversibleSource reversible;
+    if (store_cfg.snapshot_strategy == SnapshotStrategy::kRandomBoundary) {
+      const auto scope = prof.phase("random_boundary", points, points * sizeof(float));
+      random_vel = rtm_internal::make_random_boundary_velocity(vel, cfg.pml);
+      random_damp.assign(random_vel.size(), 1.0f);
+      random_prop = rtm_internal::make_propagator(cfg, random_vel, random_damp, model.dx, model.dz, pool);
+      const std::size_t offset = random_vel.size() - vel.size();
+      reversible = {.n = random_vel.size(), .offset = offset, .src_index = offset + src_index, .wavelet = &wavelet,
+                    .step = [&](const std::vector<float>& prev, const std::vector<float>& cur,
+                                std::vector<float>& nxt) { random_prop->step(prev, cur, nxt); }};
+    }
+    src_snaps = rtm_internal::make_snapshot_store(
+        store_cfg, n,
+        // By value: src_index goes out of scope before the store replays.
+        [&prop, &wavelet, src_index](std::size_t it, const std::vector<float>& prev, const std::vector<float>& cur,
+                                     std::vector<float>& nxt) {
+          prop->step(prev, cur, nxt);
+          nxt[src_index] += wavelet[it];
+        },
+        std::move(reversible));
+    imaging = std::make_unique<CrossCorrelationPass>(*src_snaps, image);
+  }
 
-  forward_source_propagation(model, cfg, vel, damp, wavelet, sx, sy, sz, rx, src_snaps, rec_data);
+  // Leapfrog state of whichever phase is running; the checkpoint covers it, the recorded data and
+  // the imaging pass's sums, which is everything the remaining steps depend on.
+  const auto fields = rtm_internal::make_wavefields(cfg, *prop, vel, damp, model.dx, model.dz, pool);
+  std::vector<std::vector<float>*> state = fields->state();
+  state.push_back(&rec_data);
+  for (auto* a : imaging->state()) state.push_back(a);
+  const rtm_internal::ShotCheckpoint checkpoint(cfg.state_checkpoint_file, cfg.state_checkpoint_steps,
+                                                rtm_internal::shot_fingerprint(model, cfg));
+  rtm_internal::ShotProgress progress;
+  if (checkpoint.enabled()) {
+    const auto scope = prof.phase("checkpoint");
+    checkpoint.load(progress, state);
+  }
+  const auto after_step = [&](std::size_t steps) {
+    if (!checkpoint.due(steps)) return;
+    progress.steps = steps;
+    double bytes = 0.0;
+    for (const auto* a : state) bytes += static_cast<double>(a->size() * sizeof(float));
+    const auto scope = prof.phase("checkpoint", 0.0, bytes);
+    checkpoint.save(progress, {state.begin(), state.end()});
+  };
 
-  std::vector<float> image(n, 0.0f);
-  receiver_backpropagation_and_imaging(model, cfg, vel, damp, sy, sz, rx, src_snaps, rec_data, image);
+  if (progress.phase == rtm_internal::ShotProgress::Phase::kForward) {
+    forward_source_propagation(cfg, vel, *fields, wavelet, sx, sy, sz, rx, *imaging, rec_data, progress.steps,
+                               after_step, prof);
+    progress = {rtm_internal::ShotProgress::Phase::kBackward, 0};
+    fields->reset();
+  }
+  receiver_backpropagation_and_imaging(cfg, vel, *fields, sy, sz, rx, rec_data, *imaging, progress.steps, after_step,
+                                       prof);
+  checkpoint.remove();
 
-  MigrationResult out;
-  out.nx = vel.nx();
-  out.nz = vel.nz();
-  out.inline_xz = rtm_internal::extract_inline_xz(vel, image);
+  out.inline_xz = shot.to_model_rows(model, rtm_internal::extract_inline_xz(vel, image));
+  return out;
+}
+
+}  // namespace rtm_internal
+
+MigrationResult run_single_shot_rtm(const GridModel2D& model, const RtmConfig& cfg, RunProfile* profile) {
+  RunProfile local_profile;
+  RunProfile& prof = profile ? *profile : local_profile;
+  return rtm_internal::migrate_prepared_shot(model, cfg, rtm_internal::prepare_rtm_shot(model, cfg, prof), prof);
+}
+
+namespace rtm_internal {
+
+ShotSetup prepare_rtm_shot(Volume3D vel, float dx, float dz, const RtmConfig& cfg, RunProfile& prof) {
+  if (vel.ny() != cfg.ny) {
+    throw std::runtime_error("velocity volume has ny=" + std::to_string(vel.ny()) + ", cfg.ny=" + std::to_string(cfg.ny));
+  }
+  if (cfg.ranks > 1 || cfg.max_dz_ratio > 1.0f || cfg.state_checkpoint_steps > 0) {
+    throw std::runtime_error("3D model shots support only one process, the uniform depth grid and no state checkpoints");
+  }
+  const float vmax = vel.size() == 0 ? 0.0f : *std::max_element(vel.raw().begin(), vel.raw().end());
+  validate_grid(vel.nx(), vel.nz(), dx, dz, vmax, cfg);
+  return prepare_shot(std::move(vel), dz, cfg, prof);
+}
+
+}  // namespace rtm_internal
+
+MigrationResult run_single_shot_rtm(Volume3D vel, float dx, float dz, const RtmConfig& cfg, RunProfile* profile) {
+  RunProfile local_profile;
+  RunProfile& prof = profile ? *profile : local_profile;
+  const GridModel2D grid{.nx = vel.nx(), .nz = vel.nz(), .dx = dx, .dz = dz, .values = {}};
+  return rtm_internal::migrate_prepared_shot(grid, cfg, rtm_internal::prepare_rtm_shot(std::move(vel), dx, dz, cfg, prof),
+                                             prof);
+}
+
+ShotGather run_forward_modeling(const GridModel2D& model, const RtmConfig& cfg, RunProfile* profile) {
+  validate_cfg(model, cfg);
+  if (cfg.ranks > 1) throw std::runtime_error("forward modeling supports only single-process shots");
+  RunProfile local_profile;
+  RunProfile& prof = profile ? *profile : local_profile;
+
+  const auto shot = prepare_shot(model, cfg, prof);
+  rtm_internal::WorkerPool pool(cfg.threads);
+  const auto prop =
+      rtm_internal::make_propagator(cfg, shot.vel, shot.damp, model.dx, model.dz, pool, shot.depth_stencil.get());
+  const auto fields = rtm_internal::make_wavefields(cfg, *prop, shot.vel, shot.damp, model.dx, model.dz, pool);
+
+  NoImagingPass imaging;
+  std::vector<float> rec_data(cfg.nt * shot.rx.size(), 0.0f);
+  forward_source_propagation(cfg, shot.vel, *fields, shot.wavelet, shot.sx, shot.sy, shot.sz, shot.rx, imaging,
+                             rec_data, 0, [](std::size_t) {}, prof);
+
+  ShotGather out;
+  out.shot_x = static_cast<float>(shot.sx) * model.dx;
+  out.shot_z = shot.depths[shot.sz];
+  out.receiver_z = out.shot_z;
+  out.nt = cfg.nt;
+  out.dt = cfg.dt;
+  const std::size_t nrec = shot.rx.size();
+  out.receiver_x.resize(nrec);
+  out.traces.resize(nrec * cfg.nt);
+  for (std::size_t ir = 0; ir < nrec; ++ir) {
+    out.receiver_x[ir] = static_cast<float>(shot.rx[ir]) * model.dx;
+    for (std::size_t it = 0; it < cfg.nt; ++it) out.traces[ir * cfg.nt + it] = rec_data[it * nrec + ir];
+  }
   return out;
 }
 
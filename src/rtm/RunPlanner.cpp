@@ -0,0 +1,128 @@
+#include "rtm3d/rtm/RunPlanner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "Boundary.hpp"
+#include "Parallel.hpp"
+#include "Propagation.hpp"
+#include "rtm3d/core/Volume3D.hpp"
+
+namespace rtm3d {
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+float default_ppw(PropagatorKind kind) { return kind == PropagatorKind::kPseudoSpectral ? 3.0f : 10.0f; }
+
+// Point updates/second of the chosen propagator, after one warm-up step. Timed on a block of at
+// most kCalibrationEdge points per axis with the planned spacings, so planning a run that would not
+// fit in memory does not allocate it; the rate per point carries over to the full grid.
+double calibrate_points_per_second(const RunPlan& plan, const RtmConfig& cfg) {
+  constexpr std::size_t kSteps = 3;
+  constexpr std::size_t kCalibrationEdge = 64;
+  const std::size_t nx = std::min(plan.nx, kCalibrationEdge);
+  const std::size_t ny = std::min(plan.ny, kCalibrationEdge);
+  const std::size_t nz = std::min(plan.nz, kCalibrationEdge);
+  const Volume3D vel(nx, ny, nz, plan.vmax);
+  const std::size_t pml = std::max<std::size_t>(1, std::min(cfg.pml, kCalibrationEdge / 4));
+  const auto damp = rtm_internal::make_damp(nx, ny, nz, pml);
+  RtmConfig c = cfg;
+  c.dt = plan.dt;
+  c.dy = plan.dy;
+  rtm_internal::WorkerPool pool(cfg.threads);
+  const auto prop = rtm_internal::make_propagator(c, vel, damp, plan.dx, plan.dz, pool);
+
+  std::vector<float> prev(vel.size(), 0.0f), cur(vel.size(), 0.0f), nxt(vel.size(), 0.0f);
+  cur[vel.index(nx / 2, ny / 2, nz / 2)] = 1.0f;
+  prop->step(prev, cur, nxt);
+  const auto t0 = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kSteps; ++i) prop->step(prev, cur, nxt);
+  const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return s > 0.0 ? static_cast<double>(kSteps * vel.size()) / s : 0.0;
+}
+
+}  // namespace
+
+float max_stable_dt(PropagatorKind kind, float vmax, float dx, float dy, float dz) {
+  if (vmax <= 0.0f || dx <= 0.0f || dy <= 0.0f || dz <= 0.0f) throw std::runtime_error("invalid stability arguments");
+  const float fd = 1.0f / (vmax * std::sqrt(1.0f / (dx * dx) + 1.0f / (dy * dy) + 1.0f / (dz * dz)));
+  return kind == PropagatorKind::kPseudoSpectral ? fd * 2.0f / kPi : fd;
+}
+
+RunPlan plan_run(const GridModel2D& raw_model, const RtmConfig& cfg, const PlanOptions& opts) {
+  if (raw_model.values.empty() || raw_model.dx <= 0.0f || raw_model.dz <= 0.0f) throw std::runtime_error("invalid model for planning");
+  if (cfg.f0 <= 0.0f || cfg.ny < 2 || cfg.dy <= 0.0f) throw std::runtime_error("invalid RTM config for planning");
+  if (opts.cfl_safety <= 0.0f || opts.cfl_safety > 1.0f) throw std::runtime_error("cfl_safety must be in (0, 1]");
+
+  RunPlan p;
+  const auto [lo, hi] = std::minmax_element(raw_model.values.begin(), raw_model.values.end());
+  p.vmin = *lo;
+  p.vmax = *hi;
+  if (p.vmin <= 0.0f) throw std::runtime_error("model velocities must be > 0 for planning");
+
+  p.fmax = ricker_max_frequency(cfg.f0);
+  p.points_per_wavelength = opts.points_per_wavelength > 0.0f ? opts.points_per_wavelength : default_ppw(cfg.propagator);
+  p.max_spacing = p.vmin / (p.fmax * p.points_per_wavelength);
+
+  p.decim_x = std::max<std::size_t>(1, static_cast<std::size_t>(p.max_spacing / raw_model.dx));
+  p.decim_z = std::max<std::size_t>(1, static_cast<std::size_t>(p.max_spacing / raw_model.dz));
+  p.nx = (raw_model.nx + p.decim_x - 1) / p.decim_x;
+  p.nz = (raw_model.nz + p.decim_z - 1) / p.decim_z;
+  p.dx = raw_model.dx * static_cast<float>(p.decim_x);
+  p.dz = raw_model.dz * static_cast<float>(p.decim_z);
+  p.meets_ppw = p.dx <= p.max_spacing && p.dz <= p.max_spacing;
+
+  // y is synthetic extrusion: keep its extent and pick the coarsest spacing meeting the target,
+  // but no finer than x/z actually achieve.
+  const float extent_y = static_cast<float>(cfg.ny - 1) * cfg.dy;
+  const float target_y = std::max(p.max_spacing, std::max(p.dx, p.dz));
+  p.ny = std::max<std::size_t>(4, static_cast<std::size_t>(std::ceil(extent_y / target_y)) + 1);
+  p.dy = extent_y / static_cast<float>(p.ny - 1);
+
+  p.dt_limit = max_stable_dt(cfg.propagator, p.vmax, p.dx, p.dy, p.dz);
+  p.dt = std::min(opts.cfl_safety * p.dt_limit, 0.5f / p.fmax);
+  const float record = opts.record_length > 0.0f ? opts.record_length : static_cast<float>(cfg.nt) * cfg.dt;
+  p.nt = std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(record / p.dt)));
+
+  const double points = static_cast<double>(p.nx) * static_cast<double>(p.ny) * static_cast<double>(p.nz);
+  p.point_updates = 2.0 * points * static_cast<double>(p.nt);
+  // Full snapshots + six live wavefields + velocity, damping and image volumes; see MemoryBudget.hpp
+  // for the cheaper snapshot strategies.
+  p.memory_bytes = static_cast<std::size_t>(points * sizeof(float) * (static_cast<double>(p.nt) + 9.0));
+  if (opts.calibrate) p.points_per_second = calibrate_points_per_second(p, cfg);
+  return p;
+}
+
+void apply_plan(const RunPlan& plan, GridLoadOptions& load, RtmConfig& cfg) {
+  load.decim_x = plan.decim_x;
+  load.decim_z = plan.decim_z;
+  load.crop_x = 0;
+  load.crop_z = 0;
+  cfg.ny = plan.ny;
+  cfg.dy = plan.dy;
+  cfg.dt = plan.dt;
+  cfg.nt = plan.nt;
+}
+
+std::string format_plan(const RunPlan& p) {
+  std::ostringstream s;
+  s << "plan velocity=[" << p.vmin << ", " << p.vmax << "] m/s fmax=" << p.fmax << " Hz ppw="
+    << p.points_per_wavelength << " max_spacing=" << p.max_spacing << " m\n"
+    << "plan decim_x=" << p.decim_x << " decim_z=" << p.decim_z << " grid=" << p.nx << "x" << p.ny << "x"
+    << p.nz << " dx=" << p.dx << " dy=" << p.dy << " dz=" << p.dz << "\n";
+  if (!p.meets_ppw) s << "plan warning: native model sampling is coarser than max_spacing\n";
+  s << "plan dt=" << p.dt << " (stability limit " << p.dt_limit << ") nt=" << p.nt
+    << " record=" << static_cast<float>(p.nt) * p.dt << " s\n"
+    << "plan cost=" << p.point_updates / 1e9 << " Gpoint-updates";
+  if (p.points_per_second > 0.0) {
+    s << " (~" << p.point_updates / p.points_per_second << " s at " << p.points_per_second / 1e6 << " Mpoints/s)";
+  }
+  s << " memory=" << static_cast<double>(p.memory_bytes) / (1024.0 * 1024.0) << " MiB\n";
+  return s.str();
+}
+
+}  // namespace rtm3d
@@ -0,0 +1,172 @@
+#include "rtm3d/rtm/RunProfile.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "rtm3d/rtm/DepthGrid.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/Precision.hpp"
+
+namespace rtm3d {
+namespace {
+
+int open_counter(std::uint64_t config) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // Calling thread only: counts inherited by the persistent kernel threads would reach read()
+  // only once those threads exit, long after the phase they belong to.
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+std::uint64_t read_counter(int fd) {
+  std::uint64_t v = 0;
+  return read(fd, &v, sizeof(v)) == static_cast<ssize_t>(sizeof(v)) ? v : 0;
+}
+
+double per_second(double amount, double seconds) { return seconds > 0.0 ? amount / seconds : 0.0; }
+
+}  // namespace
+
+RunProfile::RunProfile(bool hw_counters) {
+  if (!hw_counters) return;
+  const std::uint64_t configs[3] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+  for (int i = 0; i < 3; ++i) {
+    fds_[i] = open_counter(configs[i]);
+    if (fds_[i] < 0) {
+      // perf_event_paranoid, containers and VMs commonly refuse; report timings only.
+      for (int j = 0; j < i; ++j) close(fds_[j]);
+      for (int& fd : fds_) fd = -1;
+      return;
+    }
+  }
+}
+
+RunProfile::~RunProfile() {
+  for (int fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+HwCounts RunProfile::read_counters() const {
+  if (!hw_counters_available() || std::this_thread::get_id() != owner_) return {};
+  return {read_counter(fds_[0]), read_counter(fds_[1]), read_counter(fds_[2])};
+}
+
+RunProfile::Scope RunProfile::phase(const std::string& name, double grid_points, double bytes) {
+  const std::lock_guard<std::mutex> lock(mu_);
+  std::size_t i = 0;
+  while (i < phases_.size() && phases_[i].name != name) ++i;
+  if (i == phases_.size()) {
+    phases_.emplace_back();
+    phases_.back().name = name;
+  }
+  return Scope(*this, i, grid_points, bytes);
+}
+
+double RunProfile::total_seconds() const {
+  double s = 0.0;
+  for (const auto& p : phases_) s += p.seconds;
+  return s;
+}
+
+RunProfile::Scope::Scope(RunProfile& profile, std::size_t phase, double grid_points, double bytes)
+    : profile_(profile), phase_(phase), grid_points_(grid_points), bytes_(bytes),
+      start_(std::chrono::steady_clock::now()), hw_start_(profile.read_counters()) {}
+
+RunProfile::Scope::~Scope() {
+  const HwCounts hw = profile_.read_counters();
+  const std::lock_guard<std::mutex> lock(profile_.mu_);
+  auto& p = profile_.phases_[phase_];
+  p.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  p.calls += 1;
+  p.grid_points += grid_points_;
+  p.bytes += bytes_;
+  p.hw.cycles += hw.cycles - hw_start_.cycles;
+  p.hw.instructions += hw.instructions - hw_start_.instructions;
+  p.hw.llc_misses += hw.llc_misses - hw_start_.llc_misses;
+}
+
+void write_run_report_json(const std::string& path, const RunProfile& profile, const GridModel2D& model,
+                           const RtmConfig& cfg) {
+  std::ofstream f(path);
+  if (!f) throw std::runtime_error("cannot write run report: " + path);
+
+  char host[256] = {};
+  gethostname(host, sizeof(host) - 1);
+  const bool hw = profile.hw_counters_available();
+
+  f << std::setprecision(9) << "{\n"
+    << "  \"host\": \"" << host << "\",\n"
+    << "  \"grid\": {\"nx\": " << model.nx << ", \"ny\": " << cfg.ny << ", \"nz\": " << model.nz
+    << ", \"nt\": " << cfg.nt << ", \"dx\": " << model.dx << ", \"dy\": " << cfg.dy << ", \"dz\": " << model.dz
+    << ", \"dt\": " << cfg.dt << ", \"depth_samples\": " << propagation_depth_grid(model, cfg).z.size() << "},\n"
+    << "  \"propagator\": \""
+    << (cfg.propagator == PropagatorKind::kPseudoSpectral ? "pseudo_spectral" : "fd") << "\",\n"
+    << "  \"imaging\": \""
+    << (cfg.imaging == ImagingCondition::kFrequencyDomain ? "frequency" : "cross_correlation") << "\",\n"
+    << "  \"precision\": \"" << wavefield_precision_name(cfg.precision) << "\",\n"
+    << "  \"snapshot_strategy\": \"" << snapshot_strategy_name(cfg.snapshot_strategy) << "\",\n"
+    << "  \"threads\": " << cfg.threads << ",\n"
+    << "  \"ranks\": " << cfg.ranks << ",\n"
+    << "  \"hw_counters\": " << (hw ? "true" : "false") << ",\n"
+    << "  \"total_seconds\": " << profile.total_seconds() << ",\n"
+    << "  \"phases\": [\n";
+  const auto& phases = profile.phases();
+  for (std::size_t i = 0; i < phases.size(); ++i) {
+    const auto& p = phases[i];
+    f << "    {\"name\": \"" << p.name << "\", \"calls\": " << p.calls << ", \"seconds\": " << p.seconds
+      << ", \"grid_points_per_second\": " << per_second(p.grid_points, p.seconds)
+      << ", \"effective_gb_per_second\": " << per_second(p.bytes, p.seconds) * 1e-9;
+    if (hw) {
+      f << ", \"cycles\": " << p.hw.cycles << ", \"instructions\": " << p.hw.instructions
+        << ", \"llc_misses\": " << p.hw.llc_misses;
+    }
+    f << "}" << (i + 1 < phases.size() ? "," : "") << "\n";
+  }
+  f << "  ],\n"
+    << "  \"stages\": [\n";
+  const auto& stages = profile.stages();
+  for (std::size_t i = 0; i < stages.size(); ++i) {
+    const auto& st = stages[i];
+    f << "    {\"name\": \"" << st.name << "\", \"items\": " << st.items << ", \"busy_seconds\": " << st.busy_seconds
+      << ", \"input_wait_seconds\": " << st.input_wait_seconds
+      << ", \"output_wait_seconds\": " << st.output_wait_seconds << ", \"wall_seconds\": " << st.wall_seconds
+      << ", \"utilization\": " << st.utilization() << "}" << (i + 1 < stages.size() ? "," : "") << "\n";
+  }
+  f << "  ]\n}\n";
+}
+
+std::string format_run_profile(const RunProfile& profile) {
+  std::ostringstream s;
+  s << std::fixed << std::setprecision(3);
+  for (const auto& p : profile.phases()) {
+    s << "phase " << std::left << std::setw(16) << p.name << std::right << std::setw(10) << p.seconds << " s";
+    if (p.grid_points > 0.0) s << "  " << per_second(p.grid_points, p.seconds) * 1e-6 << " Mpts/s";
+    if (p.bytes > 0.0) s << "  " << per_second(p.bytes, p.seconds) * 1e-9 << " GB/s";
+    if (profile.hw_counters_available() && p.hw.cycles > 0) {
+      s << "  ipc=" << static_cast<double>(p.hw.instructions) / static_cast<double>(p.hw.cycles)
+        << " llc_misses=" << p.hw.llc_misses;
+    }
+    s << "\n";
+  }
+  for (const auto& st : profile.stages()) {
+    s << "stage " << std::left << std::setw(16) << st.name << std::right << std::setw(10) << st.busy_seconds
+      << " s busy  " << std::setw(5) << 100.0 * st.utilization() << "% util  items=" << st.items
+      << "  wait in/out " << st.input_wait_seconds << "/" << st.output_wait_seconds << " s\n";
+  }
+  return s.str();
+}
+
+}  // namespace rtm3d
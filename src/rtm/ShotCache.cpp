@@ -0,0 +1,170 @@
+#include "ShotCache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "DurableFile.hpp"
+#include "ShotCheckpoint.hpp"
+
+namespace rtm3d {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr char kImageMagic[8] = {'R', 'T', 'M', '3', 'D', 'C', 'I', '1'};
+constexpr const char* kImageExt = ".img";
+
+struct ImageHeader {
+  char magic[8];
+  std::uint64_t nx;
+  std::uint64_t nz;
+};
+
+}  // namespace
+
+namespace rtm_internal {
+
+std::string shot_cache_key(const GridModel2D& window, const RtmConfig& cfg) {
+  std::uint64_t h = shot_fingerprint(window, cfg);
+  const std::uint64_t ranks = cfg.ranks;
+  h = snapshot_fingerprint(window, cfg, fnv1a(&ranks, sizeof(ranks), h));
+  std::ostringstream s;
+  s << std::hex << std::setw(16) << std::setfill('0') << h;
+  return s.str();
+}
+
+CachedImage::~CachedImage() {
+  if (map_) ::munmap(map_, map_bytes_);
+}
+
+CachedImage::CachedImage(CachedImage&& other) noexcept { *this = std::move(other); }
+
+CachedImage& CachedImage::operator=(CachedImage&& other) noexcept {
+  if (this != &other) {
+    if (map_) ::munmap(map_, map_bytes_);
+    data_ = std::exchange(other.data_, nullptr);
+    nx_ = std::exchange(other.nx_, 0);
+    nz_ = std::exchange(other.nz_, 0);
+    map_ = std::exchange(other.map_, nullptr);
+    map_bytes_ = std::exchange(other.map_bytes_, 0);
+  }
+  return *this;
+}
+
+ShotCache::ShotCache(std::string dir, std::size_t max_bytes) : dir_(std::move(dir)), max_bytes_(max_bytes) {
+  fs::create_directories(dir_);
+}
+
+std::string ShotCache::path(const std::string& key) const { return dir_ + "/" + key + kImageExt; }
+
+bool ShotCache::find(const std::string& key, std::optional<CachedImage>& out) {
+  const std::string p = path(key);
+  const int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    ++misses_;
+    return false;
+  }
+  struct stat st {};
+  void* map = MAP_FAILED;
+  const bool sized = ::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(ImageHeader);
+  if (sized) map = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map != MAP_FAILED) {
+    const auto bytes = static_cast<std::size_t>(st.st_size);
+    ImageHeader h{};
+    std::memcpy(&h, map, sizeof(h));
+    if (std::memcmp(h.magic, kImageMagic, sizeof(kImageMagic)) == 0 &&
+        bytes == sizeof(h) + h.nx * h.nz * sizeof(float)) {
+      ::madvise(map, bytes, MADV_SEQUENTIAL);
+      const auto* data = reinterpret_cast<const float*>(static_cast<const char*>(map) + sizeof(h));
+      out.emplace(data, h.nx, h.nz, map, bytes);
+      ::utimensat(AT_FDCWD, p.c_str(), nullptr, 0);  // most recently used
+      ++hits_;
+      return true;
+    }
+    ::munmap(map, bytes);
+  }
+  std::error_code ec;
+  fs::remove(p, ec);
+  ++misses_;
+  return false;
+}
+
+void ShotCache::put(const std::string& key, const MigrationResult& image) {
+  ImageHeader h{};
+  std::memcpy(h.magic, kImageMagic, sizeof(kImageMagic));
+  h.nx = image.nx;
+  h.nz = image.nz;
+  try {
+    DurableFileWriter w(path(key));
+    w.write(&h, sizeof(h));
+    w.write(image.inline_xz.data(), image.inline_xz.size() * sizeof(float));
+    w.commit();
+  } catch (const std::exception& e) {
+    if (failed_++ == 0) error_ = e.what();
+  }
+}
+
+ShotCacheStats ShotCache::trim() {
+  struct Entry {
+    fs::path path;
+    std::size_t bytes;
+    fs::file_time_type used;
+  };
+  std::vector<Entry> entries;
+  std::error_code ec;
+  for (const auto& e : fs::directory_iterator(dir_)) {
+    if (!e.is_regular_file(ec) || e.path().extension() != kImageExt) continue;
+    const auto bytes = e.file_size(ec);
+    const auto used = e.last_write_time(ec);
+    if (!ec) entries.push_back({e.path(), static_cast<std::size_t>(bytes), used});
+  }
+  ShotCacheStats stats{
+      .hits = hits_, .misses = misses_, .failed = failed_, .evicted = 0, .entries = entries.size(), .bytes = 0};
+  stats.error = error_;
+  for (const auto& e : entries) stats.bytes += e.bytes;
+  if (max_bytes_ == 0 || stats.bytes <= max_bytes_) return stats;
+
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+  for (const auto& e : entries) {
+    if (stats.bytes <= max_bytes_) break;
+    if (fs::remove(e.path, ec)) {
+      stats.bytes -= e.bytes;
+      --stats.entries;
+      ++stats.evicted;
+    }
+  }
+  return stats;
+}
+
+}  // namespace rtm_internal
+
+void write_shot_cache_stats_json(const std::string& path, const ShotCacheStats& stats) {
+  std::ofstream f(path);
+  if (!f) throw std::runtime_error("cannot write cache stats: " + path);
+  const std::size_t lookups = stats.hits + stats.misses;
+  f << "{\n"
+    << "  \"hits\": " << stats.hits << ",\n"
+    << "  \"misses\": " << stats.misses << ",\n"
+    << "  \"failed\": " << stats.failed << ",\n"
+    << "  \"hit_rate\": " << (lookups ? static_cast<double>(stats.hits) / static_cast<double>(lookups) : 0.0) << ",\n"
+    << "  \"evicted\": " << stats.evicted << ",\n"
+    << "  \"entries\": " << stats.entries << ",\n"
+    << "  \"bytes\": " << stats.bytes << "\n"
+    << "}\n";
+}
+
+}  // namespace rtm3d
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// Hex content key of a shot's image: the shot fingerprint of the model window it is migrated on
+// (grid, velocities, source column, time axis, wavelet, receivers, imaging) plus, when the snapshot
+// strategy (kAuto resolved) is lossy, that strategy and the subsampled stride. Exact strategies
+// share the full-snapshot entries. The recorded data are modelled from the same window and
+// configuration, so they are covered too. The shot's position in the survey is not: shots with
+// identical windows share an entry.
+std::string shot_cache_key(const GridModel2D& window, const RtmConfig& cfg);
+
+// A cached image mapped read-only, unmapped when destroyed.
+class CachedImage {
+ public:
+  CachedImage(const float* data, std::size_t nx, std::size_t nz, void* map, std::size_t map_bytes)
+      : data_(data), nx_(nx), nz_(nz), map_(map), map_bytes_(map_bytes) {}
+  ~CachedImage();
+  CachedImage(CachedImage&& other) noexcept;
+  CachedImage& operator=(CachedImage&& other) noexcept;
+  CachedImage(const CachedImage&) = delete;
+  CachedImage& operator=(const CachedImage&) = delete;
+
+  const float* data() const { return data_; }
+  std::size_t nx() const { return nx_; }
+  std::size_t nz() const { return nz_; }
+
+ private:
+  const float* data_ = nullptr;
+  std::size_t nx_ = 0, nz_ = 0;
+  void* map_ = nullptr;
+  std::size_t map_bytes_ = 0;
+};
+
+// Directory of <key>.img files, one per shot image (header + nx * nz floats), written atomically.
+// A hit refreshes the entry's modification time, which orders eviction. find() and put() may run
+// on different threads; stats() is read once both are done.
+class ShotCache {
+ public:
+  ShotCache(std::string dir, std::size_t max_bytes);
+
+  // The mapped entry, or false when there is none (a damaged entry is removed and counts as a miss).
+  bool find(const std::string& key, std::optional<CachedImage>& out);
+  // Best effort: a failed write (disk full, permissions) is counted and the first error kept for
+  // stats(), and the survey goes on without the entry.
+  void put(const std::string& key, const MigrationResult& image);
+  // Removes least recently used entries until the directory holds at most max_bytes (0 = no cap)
+  // and returns the run's counts with the footprint left.
+  ShotCacheStats trim();
+
+ private:
+  std::string path(const std::string& key) const;
+
+  std::string dir_;
+  std::size_t max_bytes_;
+  std::size_t hits_ = 0, misses_ = 0, failed_ = 0;
+  std::string error_;
+};
+
+}  // namespace rtm3d::rtm_internal
@@ -0,0 +1,125 @@
+#include "ShotCheckpoint.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "DurableFile.hpp"
+#include "SnapshotStore.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+constexpr char kMagic[8] = {'R', 'T', 'M', '3', 'D', 'S', 'T', '1'};
+
+struct Header {
+  char magic[8];
+  std::uint64_t fingerprint;
+  std::uint32_t phase;
+  std::uint32_t arrays;
+  std::uint64_t steps;
+};
+
+template <typename T>
+std::uint64_t hash_value(const T& v, std::uint64_t h) {
+  return fnv1a(&v, sizeof(v), h);
+}
+
+}  // namespace
+
+std::uint64_t shot_fingerprint(const GridModel2D& model, const RtmConfig& cfg) {
+  std::uint64_t h = kFnvOffsetBasis;
+  for (const std::uint64_t v : {std::uint64_t{model.nx}, std::uint64_t{model.nz}, std::uint64_t{cfg.ny},
+                                std::uint64_t{cfg.nt}, std::uint64_t{cfg.pml}, std::uint64_t{cfg.receiver_stride},
+                                std::uint64_t{cfg.source_ix}, std::uint64_t{cfg.nfreq},
+                                static_cast<std::uint64_t>(cfg.propagator),
+                                static_cast<std::uint64_t>(cfg.imaging),
+                                static_cast<std::uint64_t>(cfg.precision)}) {
+    h = hash_value(v, h);
+  }
+  for (const float v : {model.dx, model.dz, cfg.dy, cfg.dt, cfg.f0, cfg.freq_min, cfg.freq_max, cfg.max_dz_ratio}) {
+    h = hash_value(v, h);
+  }
+  return fnv1a(model.values.data(), model.values.size() * sizeof(float), h);
+}
+
+std::uint64_t snapshot_fingerprint(const GridModel2D& model, const RtmConfig& cfg, std::uint64_t hash) {
+  if (cfg.imaging != ImagingCondition::kCrossCorrelation) return hash;
+  const SnapshotStrategy s = cfg.snapshot_strategy == SnapshotStrategy::kAuto
+                                 ? select_snapshot_strategy(model, cfg).chosen
+                                 : cfg.snapshot_strategy;
+  const auto estimates = estimate_snapshot_strategies(model, cfg);
+  const auto e = std::find_if(estimates.begin(), estimates.end(), [&](const auto& x) { return x.strategy == s; });
+  if (e == estimates.end() || e->exact) return hash;
+  hash = hash_value(static_cast<std::uint64_t>(s), hash);
+  if (s == SnapshotStrategy::kSubsampled) hash = hash_value(std::uint64_t{effective_snapshot_stride(cfg)}, hash);
+  return hash;
+}
+
+ShotCheckpoint::ShotCheckpoint(std::string path, std::size_t interval, std::uint64_t fingerprint)
+    : path_(std::move(path)), interval_(interval), fingerprint_(fingerprint) {}
+
+void ShotCheckpoint::save(const ShotProgress& progress, const std::vector<const std::vector<float>*>& arrays) const {
+  Header h{};
+  std::memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.fingerprint = fingerprint_;
+  h.phase = static_cast<std::uint32_t>(progress.phase);
+  h.arrays = static_cast<std::uint32_t>(arrays.size());
+  h.steps = progress.steps;
+
+  DurableFileWriter w(path_);
+  w.write(&h, sizeof(h));
+  for (const auto* a : arrays) {
+    const std::uint64_t n = a->size();
+    w.write(&n, sizeof(n));
+    w.write(a->data(), a->size() * sizeof(float));
+  }
+  w.commit();
+}
+
+bool ShotCheckpoint::load(ShotProgress& progress, const std::vector<std::vector<float>*>& arrays) const {
+  if (!enabled()) return false;
+  std::ifstream f(path_, std::ios::binary);
+  if (!f) return false;
+
+  Header h{};
+  if (!f.read(reinterpret_cast<char*>(&h), sizeof(h))) return false;
+  if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.fingerprint != fingerprint_ ||
+      h.arrays != arrays.size() || h.phase > static_cast<std::uint32_t>(ShotProgress::Phase::kBackward)) {
+    return false;
+  }
+  // Validate every size, and the file length, before touching the caller's arrays.
+  std::vector<std::streamoff> offsets;
+  std::uintmax_t expected = sizeof(h);
+  for (const auto* a : arrays) {
+    std::uint64_t n = 0;
+    if (!f.read(reinterpret_cast<char*>(&n), sizeof(n)) || n != a->size()) return false;
+    offsets.push_back(f.tellg());
+    f.seekg(static_cast<std::streamoff>(n * sizeof(float)), std::ios::cur);
+    expected += sizeof(n) + n * sizeof(float);
+  }
+  std::error_code ec;
+  if (!f || std::filesystem::file_size(path_, ec) != expected || ec) return false;
+
+  for (std::size_t i = 0; i < arrays.size(); ++i) {
+    f.seekg(offsets[i]);
+    if (!f.read(reinterpret_cast<char*>(arrays[i]->data()),
+                static_cast<std::streamsize>(arrays[i]->size() * sizeof(float)))) {
+      throw std::runtime_error("cannot read shot checkpoint: " + path_);
+    }
+  }
+  progress.phase = static_cast<ShotProgress::Phase>(h.phase);
+  progress.steps = h.steps;
+  return true;
+}
+
+void ShotCheckpoint::remove() const {
+  if (!enabled()) return;
+  std::error_code ec;
+  std::filesystem::remove(path_, ec);
+}
+
+}  // namespace rtm3d::rtm_internal
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// Identifies everything that determines a shot's image: model, grid, time axis, wavelet,
+// geometry, imaging condition and wavefield precision. Thread counts and kernel tuning are
+// excluded because every setting produces bit-identical fields.
+std::uint64_t shot_fingerprint(const GridModel2D& model, const RtmConfig& cfg);
+
+// Chains into `hash` what the snapshot strategy changes in a cross-correlation image: nothing for
+// the exact strategies, which all give the full-snapshot image, and the strategy (kAuto resolved
+// against `model`) with its subsampling stride for the lossy ones.
+std::uint64_t snapshot_fingerprint(const GridModel2D& model, const RtmConfig& cfg, std::uint64_t hash);
+
+// Where a shot stands at a step boundary: `steps` time steps of `phase` taken.
+struct ShotProgress {
+  enum class Phase : std::uint32_t { kForward = 0, kBackward = 1 };
+  Phase phase = Phase::kForward;
+  std::size_t steps = 0;
+};
+
+// Wavefield state of one shot at step boundaries (RtmConfig::state_checkpoint_file). The arrays
+// saved and restored are the caller's, in a fixed order; a file whose fingerprint or array sizes
+// do not match is ignored.
+class ShotCheckpoint {
+ public:
+  ShotCheckpoint(std::string path, std::size_t interval, std::uint64_t fingerprint);
+
+  bool enabled() const { return !path_.empty() && interval_ > 0; }
+  bool due(std::size_t steps) const { return enabled() && steps % interval_ == 0; }
+
+  void save(const ShotProgress& progress, const std::vector<const std::vector<float>*>& arrays) const;
+  // Returns false, leaving everything untouched, when there is no usable checkpoint.
+  bool load(ShotProgress& progress, const std::vector<std::vector<float>*>& arrays) const;
+  void remove() const;
+
+ private:
+  std::string path_;
+  std::size_t interval_;
+  std::uint64_t fingerprint_;
+};
+
+}  // namespace rtm3d::rtm_internal
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Propagation.hpp"
+#include "rtm3d/core/Volume3D.hpp"
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/DepthGrid.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/RunProfile.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// Velocity volume, boundary damping, wavelet and acquisition geometry of one shot.
+struct ShotSetup {
+  Volume3D vel;
+  std::vector<float> damp;
+  std::vector<float> wavelet;
+  std::size_t sx{}, sy{}, sz{};
+  std::vector<std::size_t> rx;
+  std::vector<float> depths;                  // [m] of the vel z-planes
+  std::unique_ptr<DepthStencil> depth_stencil;  // null on the uniform model grid
+
+  // z-planes of an image on `vel`, on the model's uniform rows.
+  std::vector<float> to_model_rows(const GridModel2D& model, std::vector<float> inline_xz) const {
+    if (!depth_stencil) return inline_xz;
+    return resample_depth(inline_xz, vel.nx(), depths, uniform_depths(model.nz, model.dz));
+  }
+};
+
+// run_single_shot_rtm in two parts, so a survey can set up the next shot while one migrates.
+// prepare_rtm_shot validates the configuration and builds the setup; migrate_prepared_shot runs
+// the shot, with `model` giving the grid spacing and the image rows (for a volume, a GridModel2D
+// of its nx, nz and spacings without values).
+ShotSetup prepare_rtm_shot(const GridModel2D& model, const RtmConfig& cfg, RunProfile& prof);
+ShotSetup prepare_rtm_shot(Volume3D vel, float dx, float dz, const RtmConfig& cfg, RunProfile& prof);
+MigrationResult migrate_prepared_shot(const GridModel2D& model, const RtmConfig& cfg, const ShotSetup& shot,
+                                      RunProfile& prof);
+
+}  // namespace rtm3d::rtm_internal
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rtm3d/rtm/Survey.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// Hex fingerprint of a whole survey: the shot fingerprint with the source column cleared, the
+// snapshot fingerprint, the shot columns and the aperture. Checkpoint ledgers and job directories
+// are keyed by it.
+std::string survey_fingerprint(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& opts,
+                               const std::vector<std::size_t>& columns);
+
+// Columns [x0, x1) migrated for a shot at column sx (the whole model when aperture <= 0).
+std::pair<std::size_t, std::size_t> shot_window(const GridModel2D& model, std::size_t sx, float aperture);
+
+GridModel2D crop_columns(const GridModel2D& model, std::size_t x0, std::size_t x1);
+
+// Adds a window image whose first column is stack column x0.
+void add_window(MigrationResult& stack, const MigrationResult& image, std::size_t x0);
+// The same for an nx x nz image held elsewhere, e.g. a mapped cache entry.
+void add_window(MigrationResult& stack, const float* image, std::size_t nx, std::size_t nz, std::size_t x0);
+
+}  // namespace rtm3d::rtm_internal
@@ -0,0 +1,240 @@
+#include "SnapshotStore.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+class FullStore final : public SnapshotStore {
+ public:
+  FullStore(std::size_t nt, std::size_t n) : n_(n), snaps_(nt * n, 0.0f) {}
+
+  void store(std::size_t it, const std::vector<float>& field) override {
+    std::copy(field.begin(), field.end(), snaps_.begin() + static_cast<std::ptrdiff_t>(it * n_));
+  }
+  const float* load(std::size_t it) override { return snaps_.data() + it * n_; }
+
+ private:
+  std::size_t n_;
+  std::vector<float> snaps_;
+};
+
+// Keeps every stride-th step; the cross-correlation sum is then a decimated time integral.
+class SubsampledStore final : public SnapshotStore {
+ public:
+  SubsampledStore(std::size_t nt, std::size_t n, std::size_t stride)
+      : n_(n), stride_(stride), snaps_(((nt + stride - 1) / stride) * n, 0.0f) {}
+
+  void store(std::size_t it, const std::vector<float>& field) override {
+    if (it % stride_ != 0) return;
+    std::copy(field.begin(), field.end(), snaps_.begin() + static_cast<std::ptrdiff_t>((it / stride_) * n_));
+  }
+  const float* load(std::size_t it) override {
+    return it % stride_ == 0 ? snaps_.data() + (it / stride_) * n_ : nullptr;
+  }
+  float weight() const override { return static_cast<float>(stride_); }
+
+ private:
+  std::size_t n_;
+  std::size_t stride_;
+  std::vector<float> snaps_;
+};
+
+// int16 with one max-abs scale per snapshot: half the bytes, ~1e-5 relative quantisation error.
+class CompressedStore final : public SnapshotStore {
+ public:
+  CompressedStore(std::size_t nt, std::size_t n) : n_(n), q_(nt * n, 0), scale_(nt, 0.0f), out_(n, 0.0f) {}
+
+  void store(std::size_t it, const std::vector<float>& field) override {
+    float max_abs = 0.0f;
+    for (float v : field) max_abs = std::max(max_abs, std::abs(v));
+    const float scale = max_abs > 0.0f ? max_abs / 32767.0f : 1.0f;
+    const float inv = 1.0f / scale;
+    std::int16_t* dst = q_.data() + it * n_;
+    for (std::size_t i = 0; i < n_; ++i) dst[i] = static_cast<std::int16_t>(std::lround(field[i] * inv));
+    scale_[it] = scale;
+  }
+  const float* load(std::size_t it) override {
+    const std::int16_t* src = q_.data() + it * n_;
+    const float scale = scale_[it];
+    for (std::size_t i = 0; i < n_; ++i) out_[i] = static_cast<float>(src[i]) * scale;
+    return out_.data();
+  }
+
+ private:
+  std::size_t n_;
+  std::vector<std::int16_t> q_;
+  std::vector<float> scale_;
+  std::vector<float> out_;
+};
+
+// Keeps (prev, cur) at the start of every interval-step segment and replays one segment at a time
+// during the backward pass: ~nt/k * 2n + k * n floats for one extra forward propagation.
+class CheckpointStore final : public SnapshotStore {
+ public:
+  CheckpointStore(std::size_t nt, std::size_t n, std::size_t interval, ForwardReplay replay)
+      : nt_(nt), n_(n), k_(interval), replay_(std::move(replay)),
+        checkpoints_(((nt + interval - 1) / interval) * 2 * n, 0.0f), segment_(interval * n, 0.0f),
+        prev_(n), cur_(n), nxt_(n) {}
+
+  void store(std::size_t it, const std::vector<float>& field) override {
+    // Segment s starts at step s*k and needs the fields of steps s*k-2 (prev) and s*k-1 (cur).
+    if ((it + 2) % k_ == 0 && it + 2 < nt_) save(it + 2, 0, field);
+    if ((it + 1) % k_ == 0 && it + 1 < nt_) save(it + 1, 1, field);
+  }
+
+  const float* load(std::size_t it) override {
+    const std::size_t seg = it / k_;
+    if (seg != cached_segment_) replay_segment(seg);
+    return segment_.data() + (it - seg * k_) * n_;
+  }
+
+ private:
+  void save(std::size_t start, std::size_t slot, const std::vector<float>& field) {
+    std::copy(field.begin(), field.end(),
+              checkpoints_.begin() + static_cast<std::ptrdiff_t>(((start / k_) * 2 + slot) * n_));
+  }
+
+  void replay_segment(std::size_t seg) {
+    const auto base = checkpoints_.begin() + static_cast<std::ptrdiff_t>(seg * 2 * n_);
+    std::copy(base, base + static_cast<std::ptrdiff_t>(n_), prev_.begin());
+    std::copy(base + static_cast<std::ptrdiff_t>(n_), base + static_cast<std::ptrdiff_t>(2 * n_), cur_.begin());
+    const std::size_t end = std::min(nt_, (seg + 1) * k_);
+    for (std::size_t it = seg * k_; it < end; ++it) {
+      replay_(it, prev_, cur_, nxt_);
+      std::copy(nxt_.begin(), nxt_.end(), segment_.begin() + static_cast<std::ptrdiff_t>((it - seg * k_) * n_));
+      prev_.swap(cur_);
+      cur_.swap(nxt_);
+    }
+    cached_segment_ = seg;
+  }
+
+  std::size_t nt_, n_, k_;
+  ForwardReplay replay_;
+  std::vector<float> checkpoints_;
+  std::vector<float> segment_;
+  std::vector<float> prev_, cur_, nxt_;
+  std::size_t cached_segment_ = static_cast<std::size_t>(-1);
+};
+
+// Streams snapshots to an unlinked temporary file and reads them back in reverse.
+class SpillStore final : public SnapshotStore {
+ public:
+  SpillStore(std::size_t n, const std::string& dir) : n_(n), buf_(n, 0.0f) {
+    const std::string base = dir.empty() ? std::filesystem::temp_directory_path().string() : dir;
+    std::string templ = base + "/rtm3d_snapshots_XXXXXX";
+    fd_ = mkstemp(templ.data());
+    if (fd_ < 0) throw std::runtime_error("cannot create spill file in " + base + ": " + std::strerror(errno));
+    unlink(templ.c_str());
+  }
+  ~SpillStore() override { close(fd_); }
+
+  void store(std::size_t it, const std::vector<float>& field) override {
+    const auto* p = reinterpret_cast<const char*>(field.data());
+    transfer(it, [&](std::size_t done, std::size_t left, off_t off) { return pwrite(fd_, p + done, left, off); });
+  }
+  const float* load(std::size_t it) override {
+    auto* p = reinterpret_cast<char*>(buf_.data());
+    transfer(it, [&](std::size_t done, std::size_t left, off_t off) { return pread(fd_, p + done, left, off); });
+    return buf_.data();
+  }
+
+ private:
+  template <typename Op>
+  void transfer(std::size_t it, Op&& op) const {
+    const std::size_t bytes = n_ * sizeof(float);
+    std::size_t done = 0;
+    while (done < bytes) {
+      const ssize_t r = op(done, bytes - done, static_cast<off_t>(it * bytes + done));
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) throw std::runtime_error(std::string("snapshot spill I/O failed: ") + std::strerror(errno));
+      done += static_cast<std::size_t>(r);
+    }
+  }
+
+  std::size_t n_;
+  int fd_ = -1;
+  std::vector<float> buf_;
+};
+
+// Keeps no snapshots: propagates its own copy of the source on the random-boundary grid during the
+// forward pass and steps it back from the last two fields during the backward pass.
+class RandomBoundaryStore final : public SnapshotStore {
+ public:
+  explicit RandomBoundaryStore(ReversibleSource src)
+      : src_(std::move(src)), prev_(src_.n, 0.0f), cur_(src_.n, 0.0f), nxt_(src_.n, 0.0f) {}
+
+  void store(std::size_t it, const std::vector<float>&) override {
+    src_.step(prev_, cur_, nxt_);
+    nxt_[src_.src_index] += (*src_.wavelet)[it];
+    prev_.swap(cur_);
+    cur_.swap(nxt_);
+    step_ = it;
+  }
+
+  const float* load(std::size_t it) override {
+    // cur_ holds step step_ and prev_ step step_ - 1; undo the injection of step_ and step back.
+    for (; step_ > it; --step_) {
+      cur_[src_.src_index] -= (*src_.wavelet)[step_];
+      src_.step(cur_, prev_, nxt_);
+      cur_.swap(prev_);
+      prev_.swap(nxt_);
+    }
+    return cur_.data() + src_.offset;
+  }
+
+ private:
+  ReversibleSource src_;
+  std::vector<float> prev_, cur_, nxt_;
+  std::size_t step_ = 0;
+};
+
+}  // namespace
+
+std::size_t effective_snapshot_stride(const RtmConfig& cfg) {
+  if (cfg.snapshot_stride > 0) return cfg.snapshot_stride;
+  // The product of two fields band-limited to fmax is band-limited to 2 fmax, so summing it at a
+  // sampling rate above 2 fmax integrates it without aliasing into zero frequency.
+  const float nyquist_stride = 1.0f / (2.0f * ricker_max_frequency(cfg.f0) * cfg.dt);
+  return std::max<std::size_t>(1, static_cast<std::size_t>(nyquist_stride));
+}
+
+std::size_t effective_checkpoint_interval(const RtmConfig& cfg) {
+  if (cfg.checkpoint_interval > 0) return cfg.checkpoint_interval;
+  return std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(cfg.nt)))));
+}
+
+std::unique_ptr<SnapshotStore> make_snapshot_store(const RtmConfig& cfg, std::size_t n,
+                                                   ForwardReplay replay, ReversibleSource reversible) {
+  switch (cfg.snapshot_strategy) {
+    case SnapshotStrategy::kFull:
+      return std::make_unique<FullStore>(cfg.nt, n);
+    case SnapshotStrategy::kSubsampled:
+      return std::make_unique<SubsampledStore>(cfg.nt, n, effective_snapshot_stride(cfg));
+    case SnapshotStrategy::kCompressed:
+      return std::make_unique<CompressedStore>(cfg.nt, n);
+    case SnapshotStrategy::kCheckpointed:
+      return std::make_unique<CheckpointStore>(cfg.nt, n, effective_checkpoint_interval(cfg), std::move(replay));
+    case SnapshotStrategy::kSpill:
+      return std::make_unique<SpillStore>(n, cfg.spill_dir);
+    case SnapshotStrategy::kRandomBoundary:
+      if (!reversible.step || !reversible.wavelet || reversible.offset + n > reversible.n) {
+        throw std::runtime_error("random-boundary snapshots need the reversible source grid");
+      }
+      return std::make_unique<RandomBoundaryStore>(std::move(reversible));
+    case SnapshotStrategy::kAuto:
+      break;
+  }
+  throw std::runtime_error("snapshot strategy must be resolved before building a store");
+}
+
+}  // namespace rtm3d::rtm_internal
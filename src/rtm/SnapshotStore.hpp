@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// Holds the forward source wavefield for the imaging pass. store() is called once per forward
+// step with the post-injection field; load() is called with strictly decreasing `it` during
+// backpropagation and returns nullptr for steps the strategy does not image at.
+class SnapshotStore {
+ public:
+  virtual ~SnapshotStore() = default;
+
+  virtual void store(std::size_t it, const std::vector<float>& field) = 0;
+  virtual const float* load(std::size_t it) = 0;
+  // Weight of each imaged step, so sparser strategies keep the image amplitude comparable.
+  virtual float weight() const { return 1.0f; }
+};
+
+// Recomputes forward step `it` from the two previous fields, including source injection.
+using ForwardReplay = std::function<void(std::size_t it, const std::vector<float>& prev,
+                                         const std::vector<float>& cur, std::vector<float>& nxt)>;
+
+// The source propagated on its own undamped grid with a random-velocity shell (see
+// make_random_boundary_velocity), where leapfrog runs backwards: prev = step(nxt - injection, cur).
+struct ReversibleSource {
+  std::size_t n = 0;          // points of that grid
+  std::size_t offset = 0;     // its index of the imaging grid's first point
+  std::size_t src_index = 0;  // source point on that grid
+  const std::vector<float>* wavelet = nullptr;
+  std::function<void(const std::vector<float>& prev, const std::vector<float>& cur, std::vector<float>& nxt)> step;
+};
+
+// Builds the store for cfg.snapshot_strategy (which must not be kAuto). `replay` is only used by
+// the checkpointed strategy and `reversible` only by the random-boundary one.
+std::unique_ptr<SnapshotStore> make_snapshot_store(const RtmConfig& cfg, std::size_t n,
+                                                   ForwardReplay replay, ReversibleSource reversible = {});
+
+// Resolved knobs shared with the memory estimator.
+std::size_t effective_snapshot_stride(const RtmConfig& cfg);
+std::size_t effective_checkpoint_interval(const RtmConfig& cfg);
+
+}  // namespace rtm3d::rtm_internal
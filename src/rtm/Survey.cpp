@@ -0,0 +1,419 @@
+#include "rtm3d/rtm/Survey.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "DurableFile.hpp"
+#include "Parallel.hpp"
+#include "Pipeline.hpp"
+#include "ShotCache.hpp"
+#include "ShotCheckpoint.hpp"
+#include "ShotSetup.hpp"
+#include "ShotWindows.hpp"
+#include "Wavefields.hpp"
+#include "rtm3d/io/GridModel3D.hpp"
+#include "rtm3d/rtm/DepthGrid.hpp"
+#include "rtm3d/rtm/RunProfile.hpp"
+
+namespace rtm3d {
+namespace {
+
+constexpr const char* kLedgerFile = "ledger.json";
+
+struct LedgerEntry {
+  std::size_t shot{};
+  float source_x{};
+  double seconds{};
+};
+
+// The ledger is the commit point of a checkpoint: it names the stack file holding exactly the
+// shots it lists, so it is replaced only after that stack file is durable.
+struct Ledger {
+  std::string fingerprint;
+  std::string stack_file;
+  std::vector<LedgerEntry> completed;
+};
+
+void validate_survey(const GridModel2D& model, const SurveyOptions& opts) {
+  if (opts.shots == 0) throw std::runtime_error("survey needs at least one shot");
+  if (opts.checkpoint_every == 0) throw std::runtime_error("checkpoint_every must be > 0");
+  if (opts.queue_depth == 0) throw std::runtime_error("queue_depth must be > 0");
+  if (opts.aperture < 0.0f) throw std::runtime_error("aperture must be >= 0");
+  const float x_max = static_cast<float>(model.nx - 1) * model.dx;
+  if (opts.first_shot_x < 0.0f || opts.last_shot_x < 0.0f || opts.first_shot_x > x_max ||
+      opts.last_shot_x > x_max) {
+    throw std::runtime_error("shot positions must lie in [0, " + std::to_string(x_max) + "] m");
+  }
+}
+
+bool read_ledger(const std::string& path, Ledger& ledger) {
+  std::ifstream f(path);
+  if (!f) return false;
+  const std::string s((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  std::smatch m;
+  if (!std::regex_search(s, m, std::regex("\"fingerprint\"\\s*:\\s*\"([0-9a-f]+)\""))) {
+    throw std::runtime_error("corrupt survey ledger: " + path);
+  }
+  ledger.fingerprint = m[1].str();
+  if (!std::regex_search(s, m, std::regex("\"stack_file\"\\s*:\\s*\"([^\"]*)\""))) {
+    throw std::runtime_error("corrupt survey ledger: " + path);
+  }
+  ledger.stack_file = m[1].str();
+  const std::regex entry(
+      "\\{\\s*\"shot\"\\s*:\\s*([0-9]+)\\s*,\\s*\"source_x\"\\s*:\\s*([-+0-9eE.]+)\\s*,"
+      "\\s*\"seconds\"\\s*:\\s*([-+0-9eE.]+)\\s*\\}");
+  for (auto it = std::sregex_iterator(s.begin(), s.end(), entry); it != std::sregex_iterator(); ++it) {
+    ledger.completed.push_back({std::stoul((*it)[1].str()), std::stof((*it)[2].str()), std::stod((*it)[3].str())});
+  }
+  return true;
+}
+
+void write_checkpoint(const std::string& dir, Ledger& ledger, const MigrationResult& stack, std::size_t shots) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "stack_%06zu.bin", ledger.completed.size());
+  const std::string previous = ledger.stack_file;
+  ledger.stack_file = name;
+  {
+    rtm_internal::DurableFileWriter w(dir + "/" + ledger.stack_file);
+    w.write(stack.inline_xz.data(), stack.inline_xz.size() * sizeof(float));
+    w.commit();
+  }
+
+  std::ostringstream s;
+  s << "{\n"
+    << "  \"fingerprint\": \"" << ledger.fingerprint << "\",\n"
+    << "  \"nx\": " << stack.nx << ",\n"
+    << "  \"nz\": " << stack.nz << ",\n"
+    << "  \"shots\": " << shots << ",\n"
+    << "  \"stack_file\": \"" << ledger.stack_file << "\",\n"
+    << "  \"completed\": [\n";
+  for (std::size_t i = 0; i < ledger.completed.size(); ++i) {
+    const auto& e = ledger.completed[i];
+    s << "    {\"shot\": " << e.shot << ", \"source_x\": " << e.source_x << ", \"seconds\": " << e.seconds << "}"
+      << (i + 1 < ledger.completed.size() ? "," : "") << "\n";
+  }
+  s << "  ]\n}\n";
+  rtm_internal::write_file_durably(dir + "/" + kLedgerFile, s.str());
+
+  if (!previous.empty() && previous != ledger.stack_file) {
+    std::error_code ec;
+    std::filesystem::remove(dir + "/" + previous, ec);
+  }
+}
+
+void read_stack(const std::string& path, MigrationResult& stack) {
+  std::ifstream f(path, std::ios::binary);
+  const auto bytes = static_cast<std::streamsize>(stack.inline_xz.size() * sizeof(float));
+  std::error_code ec;
+  if (!f || std::filesystem::file_size(path, ec) != static_cast<std::uintmax_t>(bytes) ||
+      !f.read(reinterpret_cast<char*>(stack.inline_xz.data()), bytes)) {
+    throw std::runtime_error("cannot read checkpointed stack: " + path);
+  }
+}
+
+void remove_shot_states(const std::string& dir) {
+  const std::regex state("shot_[0-9]+\\.state");
+  for (const auto& e : std::filesystem::directory_iterator(dir)) {
+    if (std::regex_match(e.path().filename().string(), state)) std::filesystem::remove(e.path());
+  }
+}
+
+}  // namespace
+
+namespace rtm_internal {
+
+std::string survey_fingerprint(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& opts,
+                               const std::vector<std::size_t>& columns) {
+  RtmConfig shot_cfg = cfg;
+  shot_cfg.source_ix = 0;
+  std::uint64_t h = rtm_internal::shot_fingerprint(model, shot_cfg);
+  h = rtm_internal::snapshot_fingerprint(model, shot_cfg, h);
+  h = rtm_internal::fnv1a(columns.data(), columns.size() * sizeof(std::size_t), h);
+  h = rtm_internal::fnv1a(&opts.aperture, sizeof(opts.aperture), h);
+  std::ostringstream s;
+  s << std::hex << std::setw(16) << std::setfill('0') << h;
+  return s.str();
+}
+
+// Columns [x0, x1) migrated for a shot at column sx: the aperture window, at least 9 columns wide
+// and shifted inside the model at its edges.
+std::pair<std::size_t, std::size_t> shot_window(const GridModel2D& model, std::size_t sx, float aperture) {
+  if (aperture <= 0.0f) return {0, model.nx};
+  const auto half = std::max<std::size_t>(4, static_cast<std::size_t>(std::ceil(aperture / model.dx)));
+  const std::size_t width = std::min(model.nx, 2 * half + 1);
+  const std::size_t x0 = std::min(sx > half ? sx - half : 0, model.nx - width);
+  return {x0, x0 + width};
+}
+
+GridModel2D crop_columns(const GridModel2D& model, std::size_t x0, std::size_t x1) {
+  GridModel2D out{.nx = x1 - x0, .nz = model.nz, .dx = model.dx, .dz = model.dz, .values = {}};
+  out.values.resize(out.nx * out.nz);
+  for (std::size_t iz = 0; iz < model.nz; ++iz) {
+    std::copy_n(model.values.begin() + static_cast<std::ptrdiff_t>(iz * model.nx + x0), out.nx,
+                out.values.begin() + static_cast<std::ptrdiff_t>(iz * out.nx));
+  }
+  return out;
+}
+
+void add_window(MigrationResult& stack, const MigrationResult& image, std::size_t x0) {
+  add_window(stack, image.inline_xz.data(), image.nx, image.nz, x0);
+}
+
+void add_window(MigrationResult& stack, const float* image, std::size_t nx, std::size_t nz, std::size_t x0) {
+  if (x0 + nx > stack.nx || nz != stack.nz) throw std::runtime_error("shot image does not fit the stack");
+  for (std::size_t iz = 0; iz < nz; ++iz) {
+    for (std::size_t ix = 0; ix < nx; ++ix) stack.inline_xz[iz * stack.nx + x0 + ix] += image[iz * nx + ix];
+  }
+}
+
+}  // namespace rtm_internal
+
+std::vector<std::size_t> survey_shot_columns(const GridModel2D& model, const SurveyOptions& opts) {
+  validate_survey(model, opts);
+  std::vector<std::size_t> cols(opts.shots);
+  const bool spread = opts.first_shot_x == 0.0f && opts.last_shot_x == 0.0f;
+  for (std::size_t k = 0; k < opts.shots; ++k) {
+    std::size_t ix = 0;
+    if (spread) {
+      ix = (2 * k + 1) * model.nx / (2 * opts.shots);
+    } else {
+      const float t = opts.shots > 1 ? static_cast<float>(k) / static_cast<float>(opts.shots - 1) : 0.0f;
+      const float x = opts.first_shot_x + t * (opts.last_shot_x - opts.first_shot_x);
+      ix = static_cast<std::size_t>(std::lround(x / model.dx));
+    }
+    cols[k] = std::clamp<std::size_t>(ix, 1, model.nx - 2);  // columns 0 and nx-1 are the fixed boundary
+  }
+  return cols;
+}
+
+SurveyResult run_survey(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& opts,
+                        RunProfile* profile) {
+  const auto columns = survey_shot_columns(model, opts);
+  RunProfile local_profile;
+  RunProfile& prof = profile ? *profile : local_profile;
+
+  SurveyResult out;
+  out.shots = columns.size();
+  out.stack.nx = model.nx;
+  out.stack.nz = model.nz;
+  out.stack.inline_xz.assign(model.nx * model.nz, 0.0f);
+
+  const std::string& dir = opts.checkpoint_dir;
+  Ledger ledger;
+  std::vector<bool> done(columns.size(), false);
+  if (!dir.empty()) {
+    const auto scope = prof.phase("checkpoint");
+    std::filesystem::create_directories(dir);
+    const std::string fingerprint = rtm_internal::survey_fingerprint(model, cfg, opts, columns);
+    if (read_ledger(dir + "/" + kLedgerFile, ledger)) {
+      if (!opts.resume) {
+        throw std::runtime_error("checkpoint directory " + dir + " already holds a survey; pass --resume or clear it");
+      }
+      if (ledger.fingerprint != fingerprint) {
+        throw std::runtime_error("checkpoint in " + dir + " was written for a different model, configuration or survey");
+      }
+      read_stack(dir + "/" + ledger.stack_file, out.stack);
+      for (const auto& e : ledger.completed) {
+        if (e.shot >= done.size()) throw std::runtime_error("corrupt survey ledger in " + dir);
+        done[e.shot] = true;
+      }
+      out.resumed = ledger.completed.size();
+    } else {
+      ledger.fingerprint = fingerprint;
+    }
+    if (!opts.resume) remove_shot_states(dir);
+  }
+  std::optional<rtm_internal::ShotCache> cache;
+  if (!opts.cache_dir.empty()) cache.emplace(opts.cache_dir, opts.cache_max_bytes);
+
+  // Three stages joined by bounded queues: prepare cuts each shot's sub-model and builds its
+  // velocity volume, damping, wavelet and geometry, migrate runs the shots one after another on
+  // this thread (which owns `prof`'s counters and the kernel threads), and stack adds the images
+  // and writes checkpoints. Shots stay in order, so the stack is bit-identical to a sequential loop.
+  struct ShotJob {
+    std::size_t k{}, sx{}, x0{};
+    std::optional<GridModel2D> window;  // empty: the whole model
+    RtmConfig cfg;
+    std::string key;                                 // cache key; empty without a cache
+    std::optional<rtm_internal::CachedImage> cached;  // cache hit: nothing to migrate
+    std::optional<rtm_internal::ShotSetup> setup;     // unless cached
+  };
+  struct ShotImage {
+    std::size_t k{}, sx{}, x0{};
+    MigrationResult image;
+    double seconds{};
+    std::string key;
+    std::optional<rtm_internal::CachedImage> cached;
+  };
+  const auto prepare_shot = [&](std::size_t k) {
+    ShotJob j;
+    j.k = k;
+    j.sx = columns[k];
+    const auto [x0, x1] = rtm_internal::shot_window(model, j.sx, opts.aperture);
+    j.x0 = x0;
+    if (x0 != 0 || x1 != model.nx) j.window = rtm_internal::crop_columns(model, x0, x1);
+    j.cfg = cfg;
+    j.cfg.source_ix = j.sx - x0;
+    if (!dir.empty() && cfg.state_checkpoint_steps > 0) {
+      char name[32];
+      std::snprintf(name, sizeof(name), "shot_%06zu.state", k);
+      j.cfg.state_checkpoint_file = dir + "/" + name;
+    }
+    if (cache) {
+      j.key = rtm_internal::shot_cache_key(j.window ? *j.window : model, j.cfg);
+      cache->find(j.key, j.cached);
+    }
+    if (!j.cached) j.setup = rtm_internal::prepare_rtm_shot(j.window ? *j.window : model, j.cfg, prof);
+    return j;
+  };
+  const auto migrate_shot = [&](ShotJob& job) {
+    ShotImage r{job.k, job.sx, job.x0, {}, 0.0, std::move(job.key), std::move(job.cached)};
+    if (r.cached) return r;
+    const auto t0 = std::chrono::steady_clock::now();
+    r.image = rtm_internal::migrate_prepared_shot(job.window ? *job.window : model, job.cfg, *job.setup, prof);
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return r;
+  };
+  std::size_t since_checkpoint = 0;
+  const auto stack_shot = [&](const ShotImage& item) {
+    if (item.cached) {
+      rtm_internal::add_window(out.stack, item.cached->data(), item.cached->nx(), item.cached->nz(), item.x0);
+    } else {
+      rtm_internal::add_window(out.stack, item.image, item.x0);
+      if (cache) cache->put(item.key, item.image);
+    }
+    if (dir.empty()) return;
+    ledger.completed.push_back({item.k, static_cast<float>(item.sx) * model.dx, item.seconds});
+    if (++since_checkpoint >= opts.checkpoint_every) {
+      const auto scope = prof.phase("checkpoint", 0.0, static_cast<double>(out.stack.inline_xz.size() * sizeof(float)));
+      write_checkpoint(dir, ledger, out.stack, columns.size());
+      since_checkpoint = 0;
+    }
+  };
+
+  const auto t_start = std::chrono::steady_clock::now();
+  rtm_internal::StageClock prepare_clock("prepare"), migrate_clock("migrate"), stack_clock("stack");
+  // Slab ranks are forked from the migrating thread; keep the process single-threaded while they are.
+  rtm_internal::run_stages(columns.size(), done, opts.queue_depth, cfg.ranks == 1, prepare_shot, migrate_shot,
+                           stack_shot, prepare_clock, migrate_clock, stack_clock);
+  if (since_checkpoint > 0) {
+    const auto scope = prof.phase("checkpoint", 0.0, static_cast<double>(out.stack.inline_xz.size() * sizeof(float)));
+    write_checkpoint(dir, ledger, out.stack, columns.size());
+  }
+  if (cache) {
+    const auto scope = prof.phase("cache");
+    out.cache = cache->trim();
+  }
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+  prof.add_stage(prepare_clock.finish(seconds));
+  prof.add_stage(migrate_clock.finish(seconds));
+  prof.add_stage(stack_clock.finish(seconds));
+  return out;
+}
+
+SurveyResult run_survey(const GridModel3D& model, const RtmConfig& cfg, const SurveyOptions& opts,
+                        RunProfile* profile) {
+  if (!opts.checkpoint_dir.empty()) throw std::runtime_error("3D model surveys do not checkpoint");
+  if (!opts.cache_dir.empty()) throw std::runtime_error("3D model surveys do not cache shot images");
+  const std::size_t line = model.ny() / 2;
+  const auto section = model.inline_section(line);
+  const auto columns = survey_shot_columns(section, opts);
+  RunProfile local_profile;
+  RunProfile& prof = profile ? *profile : local_profile;
+
+  // Every window spans cfg.ny model rows centred on the line, so its middle plane is the line.
+  RtmConfig shot_cfg = cfg;
+  shot_cfg.ny = std::min(cfg.ny, model.ny());
+  shot_cfg.dy = model.dy();
+  const std::size_t y0 = line - shot_cfg.ny / 2;
+
+  SurveyResult out;
+  out.shots = columns.size();
+  out.stack.nx = model.nx();
+  out.stack.nz = model.nz();
+  out.stack.inline_xz.assign(model.nx() * model.nz(), 0.0f);
+
+  struct ShotWindow {
+    std::size_t x0{};
+    RtmConfig cfg;
+    GridModel2D grid;  // the window's nx and nz, without values
+    rtm_internal::ShotSetup setup;
+  };
+  struct ShotImage {
+    std::size_t x0{};
+    MigrationResult image;
+  };
+  const auto prepare_shot = [&](std::size_t k) {
+    const auto [x0, x1] = rtm_internal::shot_window(section, columns[k], opts.aperture);
+    ShotWindow w{x0, shot_cfg, {.nx = x1 - x0, .nz = model.nz(), .dx = model.dx(), .dz = model.dz(), .values = {}}, {}};
+    w.cfg.source_ix = columns[k] - x0;
+    w.setup = rtm_internal::prepare_rtm_shot(model.read_window(x0, x1, y0, y0 + shot_cfg.ny), model.dx(), model.dz(),
+                                             w.cfg, prof);
+    return w;
+  };
+  const auto migrate_shot = [&](ShotWindow& w) {
+    return ShotImage{w.x0, rtm_internal::migrate_prepared_shot(w.grid, w.cfg, w.setup, prof)};
+  };
+  const auto stack_shot = [&](const ShotImage& item) { rtm_internal::add_window(out.stack, item.image, item.x0); };
+
+  const auto t_start = std::chrono::steady_clock::now();
+  rtm_internal::StageClock prepare_clock("prepare"), migrate_clock("migrate"), stack_clock("stack");
+  rtm_internal::run_stages(columns.size(), std::vector<bool>(columns.size(), false), opts.queue_depth, true,
+                           prepare_shot, migrate_shot, stack_shot, prepare_clock, migrate_clock, stack_clock);
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+  prof.add_stage(prepare_clock.finish(seconds));
+  prof.add_stage(migrate_clock.finish(seconds));
+  prof.add_stage(stack_clock.finish(seconds));
+  return out;
+}
+
+void model_survey(const GridModel2D& model, const RtmConfig& cfg, const SurveyOptions& opts, const GatherSink& sink,
+                  RunProfile* profile) {
+  if (cfg.ranks > 1) throw std::runtime_error("forward modeling supports only single-process shots");
+  const auto columns = survey_shot_columns(model, opts);
+  RunProfile local_profile;
+  RunProfile& prof = profile ? *profile : local_profile;
+
+  const std::size_t threads = cfg.threads > 0 ? cfg.threads : std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t concurrent = std::min(threads, columns.size());
+  RtmConfig shot_cfg = cfg;
+  shot_cfg.threads = std::max<std::size_t>(1, threads / concurrent);
+  shot_cfg.state_checkpoint_steps = 0;
+
+  double points = 0.0;
+  const std::size_t nz = propagation_depth_grid(model, cfg).z.size();
+  for (const auto sx : columns) {
+    const auto [x0, x1] = rtm_internal::shot_window(model, sx, opts.aperture);
+    points += static_cast<double>((x1 - x0) * cfg.ny * nz) * static_cast<double>(cfg.nt);
+  }
+  // The concurrent shots would time overlapping phases, so they are timed together as one.
+  const auto scope = prof.phase("modeling", points, points * rtm_internal::step_bytes_per_point(cfg));
+  rtm_internal::WorkerPool pool(concurrent);
+  pool.parallel_for(columns.size(), [&](std::size_t begin, std::size_t end) {
+    for (std::size_t k = begin; k < end; ++k) {
+      const auto [x0, x1] = rtm_internal::shot_window(model, columns[k], opts.aperture);
+      RtmConfig c = shot_cfg;
+      c.source_ix = columns[k] - x0;
+      auto gather = (x0 == 0 && x1 == model.nx) ? run_forward_modeling(model, c)
+                                                : run_forward_modeling(rtm_internal::crop_columns(model, x0, x1), c);
+      const float offset = static_cast<float>(x0) * model.dx;
+      gather.shot_x += offset;
+      for (auto& x : gather.receiver_x) x += offset;
+      sink(k, gather);
+    }
+  });
+}
+
+}  // namespace rtm3d
@@ -0,0 +1,251 @@
+#include "Wavefields.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+#include "Geometry.hpp"
+#include "HalfPrecision.hpp"
+
+namespace rtm3d::rtm_internal {
+namespace {
+
+class Fp32Wavefields final : public Wavefields {
+ public:
+  Fp32Wavefields(Propagator& prop, std::size_t n) : prop_(prop), prev_(n, 0.0f), cur_(n, 0.0f), nxt_(n, 0.0f) {}
+
+  void step() override {
+    prop_.step(prev_, cur_, nxt_);
+    prev_.swap(cur_);
+    cur_.swap(nxt_);
+  }
+  void reset() override {
+    std::fill(prev_.begin(), prev_.end(), 0.0f);
+    std::fill(cur_.begin(), cur_.end(), 0.0f);
+  }
+  void assign(const std::vector<float>& prev, const std::vector<float>& cur) override {
+    prev_ = prev;
+    cur_ = cur;
+  }
+
+  void add(std::size_t i, float value) override { cur_[i] += value; }
+  void record_receivers(const Volume3D& vel, std::size_t sy, std::size_t sz, const std::vector<std::size_t>& rx,
+                        std::vector<float>& rec_data, std::size_t it) const override {
+    rtm_internal::record_receivers(vel, sy, sz, rx, cur_, rec_data, it);
+  }
+  void inject_receivers(const Volume3D& vel, std::size_t sy, std::size_t sz, const std::vector<std::size_t>& rx,
+                        const std::vector<float>& rec_data, std::size_t it) override {
+    rtm_internal::inject_receivers(vel, sy, sz, rx, rec_data, it, cur_);
+  }
+
+  const std::vector<float>& current() override { return cur_; }
+  std::vector<std::vector<float>*> state() override { return {&prev_, &cur_}; }
+
+ private:
+  Propagator& prop_;
+  std::vector<float> prev_, cur_, nxt_;
+};
+
+// Coded peak amplitude a level is scaled to: 2^12 leaves 16x headroom below the fp16 maximum for
+// growth within a step, and ~2^26 of normal range below it for the decaying tail.
+constexpr int kPeakExponent = 12;
+constexpr float kRescaleThreshold = 16384.0f;  // coded magnitude that forces a rescale on add()
+
+// Power of two s with peak / s in [2^11, 2^12).
+float scale_for(float peak) {
+  if (!(peak > 0.0f)) return std::ldexp(1.0f, -kPeakExponent);
+  int e = 0;
+  std::frexp(peak, &e);
+  return std::ldexp(1.0f, e - kPeakExponent);
+}
+
+template <typename Codec>
+class CompactWavefields final : public Wavefields {
+ public:
+  CompactWavefields(const Volume3D& vel, const std::vector<float>& damp, float dt, float dx, float dy, float dz,
+                    WorkerPool& pool)
+      : nx_(vel.nx()), ny_(vel.ny()), nz_(vel.nz()), n_(vel.size()), pool_(pool), coef_(n_), damp_(n_),
+        current_(n_, 0.0f), idx2_(1.0f / (dx * dx)), idy2_(1.0f / (dy * dy)), idz2_(1.0f / (dz * dz)) {
+    float cmax = 0.0f;
+    for (const float v : vel.raw()) cmax = std::max(cmax, v * v * dt * dt);
+    coef_scale_ = scale_for(cmax);
+    const float inv = 1.0f / coef_scale_;
+    for (std::size_t i = 0; i < n_; ++i) {
+      const float v = vel.raw()[i];
+      coef_[i] = Codec::encode(v * v * dt * dt * inv);
+      damp_[i] = Codec::encode(damp[i]);
+    }
+    for (auto& level : levels_) level.q.assign(n_, 0);
+    reset();
+  }
+
+  void step() override {
+    const Level& p = levels_[prev_];
+    const Level& c = levels_[cur_];
+    Level& x = levels_[nxt_];
+    x.scale = scale_for(std::max(p.peak, c.peak));
+
+    const std::size_t plane = nx_ * ny_;
+    std::fill(x.q.begin(), x.q.begin() + static_cast<std::ptrdiff_t>(plane), 0);
+    std::fill(x.q.end() - static_cast<std::ptrdiff_t>(plane), x.q.end(), 0);
+    float peak = 0.0f;
+    std::mutex mu;
+    pool_.parallel_for(nz_ - 2, [&](std::size_t b, std::size_t e) {
+      const float m = step_planes(p, c, x, b + 1, e + 1);
+      const std::lock_guard<std::mutex> lock(mu);
+      peak = std::max(peak, m);
+    });
+    x.peak = peak;
+
+    const std::size_t old_prev = prev_;
+    prev_ = cur_;
+    cur_ = nxt_;
+    nxt_ = old_prev;
+  }
+
+  void reset() override {
+    for (auto& level : levels_) {
+      std::fill(level.q.begin(), level.q.end(), 0);
+      level.scale = scale_for(0.0f);
+      level.peak = 0.0f;
+    }
+  }
+
+  void assign(const std::vector<float>& prev, const std::vector<float>& cur) override {
+    load(levels_[prev_], prev);
+    load(levels_[cur_], cur);
+  }
+
+  void add(std::size_t i, float value) override {
+    Level& c = levels_[cur_];
+    if (c.peak == 0.0f) c.scale = scale_for(std::abs(value));  // empty level: fit the first value
+    const float v = Codec::decode(c.q[i]) * c.scale + value;
+    if (std::abs(v) > kRescaleThreshold * c.scale) rescale(c, std::abs(v));
+    c.q[i] = Codec::encode(v / c.scale);
+    c.peak = std::max(c.peak, std::abs(v));
+  }
+
+  void record_receivers(const Volume3D& vel, std::size_t sy, std::size_t sz, const std::vector<std::size_t>& rx,
+                        std::vector<float>& rec_data, std::size_t it) const override {
+    const Level& c = levels_[cur_];
+    for (std::size_t ir = 0; ir < rx.size(); ++ir) {
+      rec_data[it * rx.size() + ir] = Codec::decode(c.q[vel.index(rx[ir], sy, sz)]) * c.scale;
+    }
+  }
+  void inject_receivers(const Volume3D& vel, std::size_t sy, std::size_t sz, const std::vector<std::size_t>& rx,
+                        const std::vector<float>& rec_data, std::size_t it) override {
+    for (std::size_t ir = 0; ir < rx.size(); ++ir) add(vel.index(rx[ir], sy, sz), rec_data[it * rx.size() + ir]);
+  }
+
+  const std::vector<float>& current() override {
+    const Level& c = levels_[cur_];
+    pool_.parallel_for(n_, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i) current_[i] = Codec::decode(c.q[i]) * c.scale;
+    });
+    return current_;
+  }
+  std::vector<std::vector<float>*> state() override { return {}; }
+
+ private:
+  struct Level {
+    std::vector<std::uint16_t> q;  // value / scale
+    float scale = 1.0f;
+    float peak = 0.0f;             // max |value|
+  };
+
+  // Interior points of z-planes [iz_begin, iz_end) of x, zeroing the y/x borders; returns the peak.
+  // Each row is computed into an fp32 buffer, reduced and encoded in separate loops so every loop
+  // vectorizes; the peak is an integer max over the magnitude bits.
+  float step_planes(const Level& p, const Level& c, Level& x, std::size_t iz_begin, std::size_t iz_end) const {
+    const std::size_t plane = nx_ * ny_;
+    const float cs = c.scale, ps = p.scale, ks = coef_scale_, inv = 1.0f / x.scale;
+    const float kx = idx2_ * ks * cs, ky = idy2_ * ks * cs, kz = idz2_ * ks * cs;
+    std::vector<float> row_values(nx_, 0.0f);
+    float* vals = row_values.data();
+    std::uint32_t peak_bits = 0;
+    for (std::size_t iz = iz_begin; iz < iz_end; ++iz) {
+      std::uint16_t* out_plane = x.q.data() + iz * plane;
+      std::fill(out_plane, out_plane + nx_, 0);
+      std::fill(out_plane + (ny_ - 1) * nx_, out_plane + plane, 0);
+      for (std::size_t iy = 1; iy + 1 < ny_; ++iy) {
+        const std::size_t row = iz * plane + iy * nx_;
+        const std::uint16_t* u = c.q.data() + row;
+        const std::uint16_t* uym = u - nx_;
+        const std::uint16_t* uyp = u + nx_;
+        const std::uint16_t* uzm = u - plane;
+        const std::uint16_t* uzp = u + plane;
+        const std::uint16_t* up = p.q.data() + row;
+        const std::uint16_t* k = coef_.data() + row;
+        const std::uint16_t* d = damp_.data() + row;
+        std::uint16_t* out = x.q.data() + row;
+        for (std::size_t ix = 1; ix + 1 < nx_; ++ix) {
+          const float u0 = Codec::decode(u[ix]);
+          const float d2x = Codec::decode(u[ix + 1]) + Codec::decode(u[ix - 1]) - 2.0f * u0;
+          const float d2y = Codec::decode(uyp[ix]) + Codec::decode(uym[ix]) - 2.0f * u0;
+          const float d2z = Codec::decode(uzp[ix]) + Codec::decode(uzm[ix]) - 2.0f * u0;
+          const float lap = Codec::decode(k[ix]) * (kx * d2x + ky * d2y + kz * d2z);
+          vals[ix] = (2.0f * cs * u0 - ps * Codec::decode(up[ix]) + lap) * Codec::decode(d[ix]);
+        }
+        for (std::size_t ix = 1; ix + 1 < nx_; ++ix) peak_bits = std::max(peak_bits, float_bits(vals[ix]) & 0x7fffffffu);
+        for (std::size_t ix = 1; ix + 1 < nx_; ++ix) out[ix] = Codec::encode(vals[ix] * inv);
+        out[0] = 0;
+        out[nx_ - 1] = 0;
+      }
+    }
+    return bits_float(peak_bits);
+  }
+
+  void load(Level& level, const std::vector<float>& values) {
+    float peak = 0.0f;
+    for (const float v : values) peak = std::max(peak, std::abs(v));
+    level.scale = scale_for(peak);
+    level.peak = peak;
+    const float inv = 1.0f / level.scale;
+    for (std::size_t i = 0; i < n_; ++i) level.q[i] = Codec::encode(values[i] * inv);
+  }
+
+  void rescale(Level& level, float needed_peak) {
+    const float scale = scale_for(std::max(level.peak, needed_peak));
+    const float factor = level.scale / scale;
+    pool_.parallel_for(n_, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i) level.q[i] = Codec::encode(Codec::decode(level.q[i]) * factor);
+    });
+    level.scale = scale;
+  }
+
+  std::size_t nx_, ny_, nz_, n_;
+  WorkerPool& pool_;
+  std::vector<std::uint16_t> coef_;  // v^2 dt^2 / coef_scale_
+  std::vector<std::uint16_t> damp_;
+  float coef_scale_ = 1.0f;
+  Level levels_[3];
+  std::size_t prev_ = 0, cur_ = 1, nxt_ = 2;
+  std::vector<float> current_;
+  float idx2_, idy2_, idz2_;
+};
+
+}  // namespace
+
+double step_bytes_per_point(const RtmConfig& cfg) {
+  return 5.0 * (cfg.precision == WavefieldPrecision::kFloat32 ? sizeof(float) : sizeof(std::uint16_t));
+}
+
+std::unique_ptr<Wavefields> make_fp32_wavefields(Propagator& prop, std::size_t n) {
+  return std::make_unique<Fp32Wavefields>(prop, n);
+}
+
+std::unique_ptr<Wavefields> make_wavefields(const RtmConfig& cfg, Propagator& prop, const Volume3D& vel,
+                                            const std::vector<float>& damp, float dx, float dz, WorkerPool& pool) {
+  switch (cfg.precision) {
+    case WavefieldPrecision::kFloat16:
+      return std::make_unique<CompactWavefields<Fp16>>(vel, damp, cfg.dt, dx, cfg.dy, dz, pool);
+    case WavefieldPrecision::kBFloat16:
+      return std::make_unique<CompactWavefields<Bf16>>(vel, damp, cfg.dt, dx, cfg.dy, dz, pool);
+    case WavefieldPrecision::kFloat32:
+      break;
+  }
+  return make_fp32_wavefields(prop, vel.size());
+}
+
+}  // namespace rtm3d::rtm_internal
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Parallel.hpp"
+#include "Propagation.hpp"
+#include "rtm3d/core/Volume3D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace rtm3d::rtm_internal {
+
+// The leapfrog time levels of one propagating wavefield. After step(), the current level is the
+// field at the new time step; sources and receivers act on it until the next step().
+class Wavefields {
+ public:
+  virtual ~Wavefields() = default;
+
+  virtual void step() = 0;
+  virtual void reset() = 0;  // every level to zero
+  // Sets the previous and current levels, e.g. to restart from saved fp32 fields.
+  virtual void assign(const std::vector<float>& prev, const std::vector<float>& cur) = 0;
+
+  virtual void add(std::size_t i, float value) = 0;
+  virtual void record_receivers(const Volume3D& vel, std::size_t sy, std::size_t sz,
+                                const std::vector<std::size_t>& rx, std::vector<float>& rec_data,
+                                std::size_t it) const = 0;
+  virtual void inject_receivers(const Volume3D& vel, std::size_t sy, std::size_t sz,
+                                const std::vector<std::size_t>& rx, const std::vector<float>& rec_data,
+                                std::size_t it) = 0;
+
+  // The current level in fp32 (converted on each call for 16-bit storage).
+  virtual const std::vector<float>& current() = 0;
+  // The levels an intra-shot checkpoint saves (previous, current); empty if not supported.
+  virtual std::vector<std::vector<float>*> state() = 0;
+};
+
+// fp32 levels advanced by `prop`.
+std::unique_ptr<Wavefields> make_fp32_wavefields(Propagator& prop, std::size_t n);
+
+// Levels stored per RtmConfig::precision. fp16/bf16 run their own finite-difference kernel over
+// 16-bit fields and 16-bit v^2 dt^2 and damping volumes, computing in fp32. Each level carries a
+// power-of-two scale chosen from the previous step's peak amplitude so fp16 values stay well
+// inside the normal range; injections that would overflow rescale the level.
+std::unique_ptr<Wavefields> make_wavefields(const RtmConfig& cfg, Propagator& prop, const Volume3D& vel,
+                                            const std::vector<float>& damp, float dx, float dz, WorkerPool& pool);
+
+// Compulsory traffic per grid point of one leapfrog step at cfg.precision: it reads prev, cur, vel
+// and damp and writes nxt.
+double step_bytes_per_point(const RtmConfig& cfg);
+
+}  // namespace rtm3d::rtm_internal
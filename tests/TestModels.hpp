@@ -0,0 +1,59 @@
+#pragma once
+
+// Small models and engine configurations shared by the RTM tests. Tests start from these and
+// change only the fields they exercise.
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "rtm3d/model/GridModel2D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+namespace rtm3d::test {
+
+// 1500 m/s over 2200 m/s at 10 m spacing; the interface is at row `interface_iz`, nz / 2 if 0.
+inline GridModel2D layered_model(std::size_t nx, std::size_t nz, std::size_t interface_iz = 0) {
+  if (interface_iz == 0) interface_iz = nz / 2;
+  GridModel2D m{.nx = nx, .nz = nz, .dx = 10.0f, .dz = 10.0f, .values = std::vector<float>(nx * nz)};
+  for (std::size_t iz = 0; iz < nz; ++iz) {
+    for (std::size_t ix = 0; ix < nx; ++ix) m.values[iz * nx + ix] = iz < interface_iz ? 1500.0f : 2200.0f;
+  }
+  return m;
+}
+
+// A 40-step, 8-plane shot that migrates in well under a second.
+inline RtmConfig small_cfg(SnapshotStrategy strategy = SnapshotStrategy::kFull) {
+  RtmConfig cfg;
+  cfg.ny = 8;
+  cfg.dy = 10.0f;
+  cfg.dt = 0.001f;
+  cfg.nt = 40;
+  cfg.f0 = 20.0f;
+  cfg.pml = 3;
+  cfg.receiver_stride = 3;
+  cfg.snapshot_strategy = strategy;
+  return cfg;
+}
+
+inline SurveyOptions survey_options(std::size_t shots, const std::string& checkpoint_dir = {}) {
+  SurveyOptions opts;
+  opts.shots = shots;
+  opts.checkpoint_dir = checkpoint_dir;
+  return opts;
+}
+
+// Normalised zero-lag correlation of two images, 1 when they differ only in scale.
+inline double correlation(const std::vector<float>& a, const std::vector<float>& b) {
+  double ab = 0.0, aa = 0.0, bb = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    ab += double(a[i]) * b[i];
+    aa += double(a[i]) * a[i];
+    bb += double(b[i]) * b[i];
+  }
+  return ab / std::sqrt(aa * bb);
+}
+
+}  // namespace rtm3d::test
@@ -0,0 +1,111 @@
+#include <filesystem>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "rtm/Boundary.hpp"
+#include "rtm/Parallel.hpp"
+#include "rtm/Propagation.hpp"
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/Autotuner.hpp"
+
+namespace {
+
+using rtm3d::FdKernelTuning;
+
+std::vector<float> random_field(std::size_t n, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+  std::vector<float> v(n);
+  for (auto& x : v) x = u(rng);
+  return v;
+}
+
+}  // namespace
+
+TEST(Autotuner, EveryTilingMatchesPlaneKernelExactly) {
+  rtm3d::Volume3D vel(23, 17, 11, 2200.0f);
+  const auto damp = rtm3d::rtm_internal::make_damp(23, 17, 11, 3);
+  const auto prev = random_field(vel.size(), 1);
+  const auto cur = random_field(vel.size(), 2);
+  std::vector<float> ref(vel.size(), 1.0f);
+  rtm3d::rtm_internal::step_fd3d(vel, damp, 0.001f, 10.0f, 12.0f, 9.0f, prev, cur, ref);
+
+  for (const std::size_t threads : {1, 3}) {
+    rtm3d::rtm_internal::WorkerPool pool(threads);
+    for (const FdKernelTuning t : {FdKernelTuning{}, FdKernelTuning{FdKernelTuning::LoopOrder::kYzx, 0, 0},
+                                   FdKernelTuning{FdKernelTuning::LoopOrder::kYzx, 4, 0},
+                                   FdKernelTuning{FdKernelTuning::LoopOrder::kYzx, 6, 8}}) {
+      rtm3d::rtm_internal::FdPropagator prop(vel, damp, 0.001f, 10.0f, 12.0f, 9.0f, pool, t);
+      std::vector<float> nxt(vel.size(), 1.0f);  // stale values must be overwritten
+      prop.step(prev, cur, nxt);
+      EXPECT_EQ(nxt, ref) << "threads=" << threads << " tile_y=" << t.tile_y << " tile_x=" << t.tile_x;
+    }
+  }
+}
+
+TEST(Autotuner, StoresWinnerAndReusesIt) {
+  const auto cache = std::filesystem::temp_directory_path() / "rtm3d_test_tuning" / "tuning.json";
+  std::filesystem::remove_all(cache.parent_path());
+
+  const rtm3d::GridModel2D model{.nx = 24, .nz = 16, .dx = 10.0f, .dz = 10.0f,
+                                 .values = std::vector<float>(24 * 16, 2000.0f)};
+  rtm3d::RtmConfig cfg;
+  cfg.ny = 12;
+  cfg.pml = 3;
+
+  const auto tuned = rtm3d::autotune_kernels(model, cfg, {.cache_path = cache.string(), .steps = 1});
+  EXPECT_FALSE(tuned.from_cache);
+  EXPECT_GT(tuned.candidates, 1u);
+  EXPECT_GT(tuned.points_per_second, 0.0);
+  EXPECT_NE(tuned.key.find("grid=24x12x16"), std::string::npos);
+  EXPECT_NE(tuned.key.find("order=2"), std::string::npos);
+
+  const auto reused = rtm3d::autotune_kernels(model, cfg, {.cache_path = cache.string(), .steps = 1});
+  EXPECT_TRUE(reused.from_cache);
+  EXPECT_EQ(reused.candidates, 0u);
+  EXPECT_EQ(reused.tuning.order, tuned.tuning.order);
+  EXPECT_EQ(reused.tuning.tile_y, tuned.tuning.tile_y);
+  EXPECT_EQ(reused.threads, tuned.threads);
+
+  cfg.ny = 14;  // a different grid shape is tuned separately
+  EXPECT_FALSE(rtm3d::autotune_kernels(model, cfg, {.cache_path = cache.string(), .steps = 1}).from_cache);
+  std::filesystem::remove_all(cache.parent_path());
+}
+
+TEST(Autotuner, TunesTheShotWindowAndRejectsUntiledKernels) {
+  const auto cache = std::filesystem::temp_directory_path() / "rtm3d_test_tuning_window" / "tuning.json";
+  std::filesystem::remove_all(cache.parent_path());
+  const rtm3d::GridModel2D model{.nx = 60, .nz = 16, .dx = 10.0f, .dz = 10.0f,
+                                 .values = std::vector<float>(60 * 16, 2000.0f)};
+  rtm3d::RtmConfig cfg;
+  cfg.ny = 12;
+  cfg.pml = 3;
+
+  // A 100 m aperture migrates 21 columns per shot, and that is the grid that is timed.
+  const auto windowed =
+      rtm3d::autotune_kernels(model, cfg, {.cache_path = cache.string(), .steps = 1, .aperture = 100.0f});
+  EXPECT_NE(windowed.key.find("grid=21x12x16"), std::string::npos) << windowed.key;
+
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat16;
+  EXPECT_THROW(rtm3d::autotune_kernels(model, cfg, {.cache_path = cache.string()}), std::runtime_error);
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat32;
+  cfg.max_dz_ratio = 2.0f;
+  EXPECT_THROW(rtm3d::autotune_kernels(model, cfg, {.cache_path = cache.string()}), std::runtime_error);
+  std::filesystem::remove_all(cache.parent_path());
+
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--autotune", "--precision", "bf16"};
+  EXPECT_THROW((void)rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv)),
+               std::runtime_error);
+}
+
+TEST(Autotuner, ParsesAutotuneFlags) {
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--autotune", "--tuning-cache", "t.json"};
+  const auto o = rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv));
+  EXPECT_TRUE(o.autotune);
+  EXPECT_EQ(o.tuning_cache, "t.json");
+
+  const char* bad[] = {"rtm3d_cli", "--data-dir", "data", "--autotune", "--ranks", "2"};
+  EXPECT_THROW(rtm3d::parse_cli_or_throw(static_cast<int>(std::size(bad)), const_cast<char**>(bad)),
+               std::runtime_error);
+}
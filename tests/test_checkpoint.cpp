@@ -0,0 +1,176 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/RunProfile.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+using rtm3d::test::survey_options;
+
+namespace fs = std::filesystem;
+
+fs::path fresh_dir(const std::string& name) {
+  const auto dir = fs::temp_directory_path() / ("rtm3d_checkpoint_" + name + "_" + std::to_string(getpid()));
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  return dir;
+}
+
+// Runs `work` in a child process and SIGKILLs it as soon as `path` exists, like a node dying
+// mid-run. Returns false if the child finished first.
+template <typename Work>
+bool kill_when_exists(const fs::path& path, Work&& work) {
+  const pid_t pid = fork();
+  if (pid == 0) {
+    work();
+    _exit(0);
+  }
+  bool killed = false;
+  for (;;) {
+    if (fs::exists(path)) {
+      killed = kill(pid, SIGKILL) == 0;
+      break;
+    }
+    if (waitpid(pid, nullptr, WNOHANG) == pid) return false;
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return killed && WIFSIGNALED(status);
+}
+
+std::size_t step_calls(const rtm3d::RunProfile& profile) {
+  std::size_t calls = 0;
+  for (const auto& p : profile.phases()) {
+    if (p.name == "forward_steps" || p.name == "backward_steps") calls += p.calls;
+  }
+  return calls;
+}
+
+}  // namespace
+
+TEST(Survey, SingleShotMatchesSingleShotRtm) {
+  const auto model = layered_model(24, 20);
+  const auto cfg = small_cfg();
+  const auto single = rtm3d::run_single_shot_rtm(model, cfg);
+  const auto survey = rtm3d::run_survey(model, cfg, {});
+  EXPECT_EQ(survey.shots, 1u);
+  EXPECT_EQ(survey.stack.inline_xz, single.inline_xz);
+}
+
+TEST(Survey, ShotColumnsSpanTheModel) {
+  const auto model = layered_model(40, 20);
+  EXPECT_EQ(rtm3d::survey_shot_columns(model, survey_options(4)), (std::vector<std::size_t>{5, 15, 25, 35}));
+  auto span = survey_options(3);
+  span.last_shot_x = 390.0f;
+  EXPECT_EQ(rtm3d::survey_shot_columns(model, span), (std::vector<std::size_t>{1, 20, 38}));
+  span = survey_options(2);
+  span.first_shot_x = 10.0f;
+  span.last_shot_x = 500.0f;
+  EXPECT_THROW(rtm3d::survey_shot_columns(model, span), std::runtime_error);
+}
+
+TEST(Survey, ApertureKeepsImageInsideWindow) {
+  const auto model = layered_model(40, 20);
+  auto opts = survey_options(1);
+  opts.aperture = 60.0f;
+  const auto out = rtm3d::run_survey(model, small_cfg(), opts);
+  for (std::size_t iz = 0; iz < out.stack.nz; ++iz) {
+    for (std::size_t ix = 0; ix < out.stack.nx; ++ix) {
+      if (ix < 14 || ix > 26) {
+        EXPECT_EQ(out.stack.inline_xz[iz * out.stack.nx + ix], 0.0f) << ix << "," << iz;
+      }
+    }
+  }
+}
+
+TEST(SurveyCheckpoint, ResumeAfterKillMatchesUninterruptedRun) {
+  const auto model = layered_model(24, 20);
+  auto cfg = small_cfg();
+  cfg.nt = 200;
+  const auto dir = fresh_dir("survey");
+  auto opts = survey_options(4, dir.string());
+  const auto reference = rtm3d::run_survey(model, cfg, survey_options(4));
+
+  const bool killed = kill_when_exists(dir / "ledger.json", [&] { rtm3d::run_survey(model, cfg, opts); });
+  opts.resume = true;
+  const auto resumed = rtm3d::run_survey(model, cfg, opts);
+  if (killed) {
+    EXPECT_GE(resumed.resumed, 1u);
+    EXPECT_LT(resumed.resumed, 4u);
+  }
+  EXPECT_EQ(resumed.stack.inline_xz, reference.stack.inline_xz);
+
+  // Everything is in the ledger now: resuming again migrates nothing and returns the same stack.
+  const auto again = rtm3d::run_survey(model, cfg, opts);
+  EXPECT_EQ(again.resumed, 4u);
+  EXPECT_EQ(again.stack.inline_xz, reference.stack.inline_xz);
+  fs::remove_all(dir);
+}
+
+TEST(SurveyCheckpoint, RefusesToOverwriteOrMixSurveys) {
+  const auto model = layered_model(24, 20);
+  const auto cfg = small_cfg();
+  const auto dir = fresh_dir("mix");
+  auto opts = survey_options(2, dir.string());
+  rtm3d::run_survey(model, cfg, opts);
+  EXPECT_TRUE(fs::exists(dir / "ledger.json"));
+  EXPECT_THROW(rtm3d::run_survey(model, cfg, opts), std::runtime_error);
+
+  opts.resume = true;
+  auto other = cfg;
+  other.f0 = 15.0f;
+  EXPECT_THROW(rtm3d::run_survey(model, other, opts), std::runtime_error);
+
+  // A resumed run may pick another snapshot strategy: exact ones give the same images, lossy ones
+  // would stack different images under the ledger.
+  EXPECT_EQ(rtm3d::run_survey(model, small_cfg(rtm3d::SnapshotStrategy::kSpill), opts).resumed, 2u);
+  auto lossy = small_cfg(rtm3d::SnapshotStrategy::kSubsampled);
+  lossy.snapshot_stride = 2;
+  EXPECT_THROW(rtm3d::run_survey(model, lossy, opts), std::runtime_error);
+  EXPECT_THROW(rtm3d::run_survey(model, small_cfg(rtm3d::SnapshotStrategy::kCompressed), opts), std::runtime_error);
+  fs::remove_all(dir);
+}
+
+TEST(ShotCheckpoint, ResumesInterruptedShotFromWavefieldState) {
+  const auto model = layered_model(24, 20);
+  auto cfg = small_cfg();
+  cfg.nt = 400;
+  cfg.imaging = rtm3d::ImagingCondition::kFrequencyDomain;
+  const auto reference = rtm3d::run_single_shot_rtm(model, cfg);
+
+  const auto dir = fresh_dir("shot");
+  cfg.state_checkpoint_file = (dir / "shot.state").string();
+  cfg.state_checkpoint_steps = 25;
+  const bool killed = kill_when_exists(cfg.state_checkpoint_file, [&] { rtm3d::run_single_shot_rtm(model, cfg); });
+
+  rtm3d::RunProfile profile;
+  const auto resumed = rtm3d::run_single_shot_rtm(model, cfg, &profile);
+  if (killed) {
+    EXPECT_LT(step_calls(profile), 2 * cfg.nt);
+  }
+  EXPECT_EQ(resumed.inline_xz, reference.inline_xz);
+  EXPECT_FALSE(fs::exists(cfg.state_checkpoint_file));
+  fs::remove_all(dir);
+}
+
+TEST(ShotCheckpoint, RequiresFrequencyImaging) {
+  auto cfg = small_cfg();
+  cfg.state_checkpoint_file = "unused.state";
+  cfg.state_checkpoint_steps = 10;
+  EXPECT_THROW(rtm3d::run_single_shot_rtm(layered_model(24, 20), cfg), std::runtime_error);
+}
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+
+void expect_same_image(const std::vector<float>& a, const std::vector<float>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  float max_abs = 0.0f;
+  for (float v : a) max_abs = std::max(max_abs, std::abs(v));
+  ASSERT_GT(max_abs, 0.0f);
+  for (std::size_t i = 0; i < a.size(); ++i) EXPECT_NEAR(a[i], b[i], 1e-5f * max_abs) << "at " << i;
+}
+
+}  // namespace
+
+TEST(SlabDecomposition, MatchesSingleProcessImage) {
+  const auto model = layered_model(24, 20);
+  auto cfg = small_cfg();
+  const auto reference = rtm3d::run_single_shot_rtm(model, cfg);
+
+  for (const std::size_t ranks : {2u, 3u, 8u}) {
+    cfg.ranks = ranks;
+    const auto out = rtm3d::run_single_shot_rtm(model, cfg);
+    ASSERT_EQ(out.nx, reference.nx);
+    ASSERT_EQ(out.nz, reference.nz);
+    expect_same_image(reference.inline_xz, out.inline_xz);
+  }
+}
+
+TEST(SlabDecomposition, HandlesSourceOnSlabEdge) {
+  // 10 interior planes over 5 ranks: rank 0 owns z=1..2, so the source plane (z=2) is a halo edge.
+  const auto model = layered_model(20, 12);
+  auto cfg = small_cfg();
+  const auto reference = rtm3d::run_single_shot_rtm(model, cfg);
+  cfg.ranks = 5;
+  expect_same_image(reference.inline_xz, rtm3d::run_single_shot_rtm(model, cfg).inline_xz);
+}
+
+TEST(SlabDecomposition, RejectsMoreRanksThanPlanes) {
+  const auto model = layered_model(16, 10);
+  auto cfg = small_cfg();
+  cfg.ranks = 9;
+  EXPECT_THROW((void)rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+}
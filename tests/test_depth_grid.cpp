@@ -0,0 +1,131 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rtm/Propagation.hpp"
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/DepthGrid.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::correlation;
+using rtm3d::test::small_cfg;
+
+// Velocity rising linearly from 1500 m/s at the top to vmax at the bottom, with a slow reflector
+// lens in the middle so the image has something to show.
+rtm3d::GridModel2D gradient_model(std::size_t nx, std::size_t nz, float vmax) {
+  rtm3d::GridModel2D m{.nx = nx, .nz = nz, .dx = 10.0f, .dz = 10.0f, .values = std::vector<float>(nx * nz)};
+  for (std::size_t iz = 0; iz < nz; ++iz) {
+    for (std::size_t ix = 0; ix < nx; ++ix) {
+      m.values[iz * nx + ix] = 1500.0f + (vmax - 1500.0f) * static_cast<float>(iz) / static_cast<float>(nz - 1);
+      if (iz > nz / 2) m.values[iz * nx + ix] += 400.0f;
+    }
+  }
+  return m;
+}
+
+rtm3d::RtmConfig depth_cfg() {
+  auto cfg = small_cfg();
+  cfg.nt = 220;
+  cfg.f0 = 15.0f;
+  cfg.pml = 4;
+  cfg.receiver_stride = 2;
+  cfg.threads = 2;
+  cfg.imaging = rtm3d::ImagingCondition::kFrequencyDomain;
+  return cfg;
+}
+
+}  // namespace
+
+TEST(DepthGrid, StretchesWithVelocityWithinBounds) {
+  const auto model = gradient_model(20, 120, 4500.0f);
+  const auto grid = rtm3d::make_stretched_depth_grid(model, 3.0f);
+  ASSERT_GE(grid.z.size(), 2u);
+  EXPECT_EQ(grid.z.front(), 0.0f);
+  EXPECT_GE(grid.z.back(), static_cast<float>(model.nz - 1) * model.dz);
+  EXPECT_LT(grid.z.size(), model.nz * 3 / 4);  // a 3x velocity rise removes a large fraction
+  for (std::size_t i = 1; i < grid.z.size(); ++i) {
+    const float h = grid.z[i] - grid.z[i - 1];
+    EXPECT_GE(h, model.dz * 0.999f);
+    EXPECT_LE(h, 3.0f * model.dz * 1.001f);
+    if (i > 1) {
+      EXPECT_LE(h, (grid.z[i - 1] - grid.z[i - 2]) * rtm3d::kDefaultDepthGrowth * 1.001f);
+    }
+  }
+  EXPECT_FLOAT_EQ(grid.z[rtm3d::kUniformTopPlanes - 1], 2.0f * model.dz);  // source plane keeps its depth
+
+  auto constant = model;
+  std::fill(constant.values.begin(), constant.values.end(), 2000.0f);
+  EXPECT_EQ(rtm3d::make_stretched_depth_grid(constant, 3.0f).z.size(), constant.nz);
+
+  // A slow layer at the bottom holds the spacing at dz all the way down.
+  auto inverted = model;
+  for (std::size_t ix = 0; ix < inverted.nx; ++ix) inverted.values[(inverted.nz - 1) * inverted.nx + ix] = 1500.0f;
+  EXPECT_EQ(rtm3d::make_stretched_depth_grid(inverted, 3.0f).z.size(), inverted.nz);
+}
+
+TEST(DepthGrid, ResamplesLinearlyAndClampsEnds) {
+  const std::vector<float> from = {0.0f, 10.0f, 30.0f};
+  const std::vector<float> rows = {0.0f, 1.0f, 10.0f, 11.0f, 30.0f, 31.0f};  // nx = 2, value = z (+1)
+  const auto out = rtm3d::resample_depth(rows, 2, from, {0.0f, 5.0f, 20.0f, 30.0f, 45.0f});
+  const std::vector<float> expected = {0.0f, 1.0f, 5.0f, 6.0f, 20.0f, 21.0f, 30.0f, 31.0f, 30.0f, 31.0f};
+  for (std::size_t i = 0; i < expected.size(); ++i) EXPECT_FLOAT_EQ(out[i], expected[i]) << i;
+  EXPECT_EQ(rtm3d::resample_depth(rows, 2, from, from), rows);
+}
+
+TEST(DepthGrid, StencilIsExactForQuadratics) {
+  const std::vector<float> z = {0.0f, 10.0f, 21.0f, 33.1f, 46.41f};
+  const auto s = rtm3d::rtm_internal::make_depth_stencil(z);
+  for (std::size_t iz = 1; iz + 1 < z.size(); ++iz) {
+    const auto u = [&](std::size_t k) { return double(z[k]) * z[k]; };
+    const double d2 = s.below[iz] * (u(iz - 1) - u(iz)) + s.above[iz] * (u(iz + 1) - u(iz));
+    EXPECT_NEAR(d2, 2.0, 1e-3) << iz;
+  }
+  const auto uniform = rtm3d::rtm_internal::make_depth_stencil(rtm3d::uniform_depths(4, 10.0f));
+  EXPECT_FLOAT_EQ(uniform.below[1], 0.01f);
+  EXPECT_FLOAT_EQ(uniform.above[2], 0.01f);
+}
+
+TEST(DepthGrid, StretchedImageMatchesUniformOnModelRows) {
+  const auto model = gradient_model(40, 60, 3500.0f);
+  auto cfg = depth_cfg();
+  const auto uniform = rtm3d::run_single_shot_rtm(model, cfg);
+  cfg.max_dz_ratio = 2.0f;
+  const auto stretched = rtm3d::run_single_shot_rtm(model, cfg);
+  ASSERT_EQ(stretched.nz, model.nz);
+  ASSERT_EQ(stretched.inline_xz.size(), uniform.inline_xz.size());
+  EXPECT_GT(correlation(stretched.inline_xz, uniform.inline_xz), 0.9);
+
+  // The planner sizes the smaller grid.
+  auto uniform_cfg = cfg;
+  uniform_cfg.max_dz_ratio = 1.0f;
+  EXPECT_LT(rtm3d::estimate_frequency_imaging_bytes(model, cfg),
+            rtm3d::estimate_frequency_imaging_bytes(model, uniform_cfg));
+
+  cfg.imaging = rtm3d::ImagingCondition::kCrossCorrelation;
+  const auto gather = rtm3d::run_forward_modeling(model, cfg);
+  EXPECT_FLOAT_EQ(gather.shot_z, 2.0f * model.dz);
+}
+
+TEST(DepthGrid, RejectsUnsupportedCombinations) {
+  const auto model = gradient_model(40, 60, 3500.0f);
+  auto cfg = depth_cfg();
+  cfg.max_dz_ratio = 0.5f;
+  EXPECT_THROW(rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+  cfg.max_dz_ratio = 2.0f;
+  cfg.propagator = rtm3d::PropagatorKind::kPseudoSpectral;
+  EXPECT_THROW(rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+  cfg.propagator = rtm3d::PropagatorKind::kFiniteDifference;
+  cfg.precision = rtm3d::WavefieldPrecision::kBFloat16;
+  EXPECT_THROW(rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+
+  const char* argv[] = {"rtm3d", "--data-dir", "d", "--max-dz-ratio", "2", "--ranks", "2"};
+  EXPECT_THROW(rtm3d::parse_cli_or_throw(7, const_cast<char**>(argv)), std::runtime_error);
+  const char* ok[] = {"rtm3d", "--data-dir", "d", "--max-dz-ratio", "2.5"};
+  EXPECT_FLOAT_EQ(rtm3d::parse_cli_or_throw(5, const_cast<char**>(ok)).rtm.max_dz_ratio, 2.5f);
+}
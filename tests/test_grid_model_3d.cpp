@@ -0,0 +1,144 @@
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/io/GridModel3D.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+#include "TestModels.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+using rtm3d::test::survey_options;
+
+fs::path temp_model(const std::string& name) {
+  return fs::temp_directory_path() / ("rtm3d_model3d_" + name + "_" + std::to_string(getpid()) + ".bin");
+}
+
+void remove_model(const fs::path& path) {
+  fs::remove(path);
+  fs::remove(path.string() + ".json");
+}
+
+// File-backed pages mapped into this process, from /proc/self/status.
+long rss_file_kib() {
+  std::ifstream f("/proc/self/status");
+  std::string key;
+  long value = -1;
+  while (f >> key) {
+    if (key == "RssFile:") {
+      f >> value;
+      break;
+    }
+    std::getline(f, key);
+  }
+  return value;
+}
+
+}  // namespace
+
+TEST(GridModel3D, RoundTripsSlabsWindowsAndSections) {
+  const std::size_t nx = 7, ny = 5, nz = 4;
+  std::vector<float> values(nx * ny * nz);
+  std::iota(values.begin(), values.end(), 0.0f);
+  const auto path = temp_model("roundtrip");
+  rtm3d::write_grid_model_3d(path.string(), nx, ny, nz, 10.0f, 20.0f, 5.0f, values);
+
+  const auto m = rtm3d::GridModel3D::open(path.string());
+  EXPECT_EQ(m.nx(), nx);
+  EXPECT_EQ(m.ny(), ny);
+  EXPECT_EQ(m.nz(), nz);
+  EXPECT_FLOAT_EQ(m.dy(), 20.0f);
+
+  const auto slab = m.z_slab(1, 3);
+  ASSERT_EQ(slab.size(), 2 * nx * ny);
+  EXPECT_EQ(slab[0], values[nx * ny]);
+  EXPECT_EQ(slab.back(), values[3 * nx * ny - 1]);
+  m.evict(1, 3);
+  EXPECT_EQ(m.z_slab(1, 3)[5], values[nx * ny + 5]);  // faults back in after eviction
+
+  const auto w = m.read_window(2, 5, 1, 4);
+  ASSERT_EQ(w.nx(), 3u);
+  ASSERT_EQ(w.ny(), 3u);
+  ASSERT_EQ(w.nz(), nz);
+  for (std::size_t iz = 0; iz < nz; ++iz) {
+    for (std::size_t iy = 0; iy < 3; ++iy) {
+      for (std::size_t ix = 0; ix < 3; ++ix) EXPECT_EQ(w(ix, iy, iz), values[(iz * ny + iy + 1) * nx + ix + 2]);
+    }
+  }
+  const auto section = m.inline_section(2);
+  EXPECT_EQ(section.nx, nx);
+  EXPECT_EQ(section.nz, nz);
+  EXPECT_EQ(section.values[3 * nx + 6], values[(3 * ny + 2) * nx + 6]);
+
+  EXPECT_THROW((void)m.read_window(0, nx + 1, 0, 1), std::runtime_error);
+  EXPECT_THROW((void)m.z_slab(3, 5), std::runtime_error);
+  remove_model(path);
+}
+
+TEST(GridModel3D, RejectsTruncatedFiles) {
+  const auto path = temp_model("truncated");
+  rtm3d::write_grid_model_3d(path.string(), 4, 4, 4, 10.0f, 10.0f, 10.0f, std::vector<float>(64, 1.0f));
+  fs::resize_file(path, 60 * sizeof(float));
+  EXPECT_THROW((void)rtm3d::GridModel3D::open(path.string()), std::runtime_error);
+  remove_model(path);
+}
+
+TEST(GridModel3D, WindowReadsKeepOnlyTheWindowResident) {
+  const std::size_t nx = 256, ny = 128, nz = 128;  // 16 MiB
+  const auto path = temp_model("resident");
+  rtm3d::write_grid_model_3d(path.string(), nx, ny, nz, 10.0f, 10.0f, 10.0f, std::vector<float>(nx * ny * nz, 2000.0f));
+  const auto m = rtm3d::GridModel3D::open(path.string());
+  const long before = rss_file_kib();
+  if (before < 0) GTEST_SKIP() << "no RssFile in /proc/self/status";
+
+  const auto w = m.read_window(100, 140, 60, 68);
+  EXPECT_EQ(w.size(), 40u * 8u * nz);
+  EXPECT_LT(rss_file_kib() - before, 1024);  // evicted plane by plane; the whole model is 16384 KiB
+
+  float sum = 0.0f;
+  for (const float v : m.z_slab(0, 32)) sum += v;  // 4 MiB touched
+  EXPECT_GT(sum, 0.0f);
+  EXPECT_GT(rss_file_kib() - before, 2048);
+  m.evict(0, 32);
+  EXPECT_LT(rss_file_kib() - before, 1024);
+  remove_model(path);
+}
+
+TEST(GridModel3D, SurveyOnExtrudedModelMatches2DSurvey) {
+  const auto model2d = layered_model(40, 20);
+  const auto cfg = small_cfg();
+  const std::size_t ny = 13;  // wider than cfg.ny: each shot reads a y window around the line
+  std::vector<float> values(model2d.nx * ny * model2d.nz);
+  for (std::size_t iz = 0; iz < model2d.nz; ++iz) {
+    for (std::size_t iy = 0; iy < ny; ++iy) {
+      std::copy_n(model2d.values.begin() + static_cast<std::ptrdiff_t>(iz * model2d.nx), model2d.nx,
+                  values.begin() + static_cast<std::ptrdiff_t>((iz * ny + iy) * model2d.nx));
+    }
+  }
+  const auto path = temp_model("survey");
+  rtm3d::write_grid_model_3d(path.string(), model2d.nx, ny, model2d.nz, model2d.dx, cfg.dy, model2d.dz, values);
+  const auto model3d = rtm3d::GridModel3D::open(path.string());
+
+  auto opts = survey_options(3);
+  opts.aperture = 80.0f;
+  const auto reference = rtm3d::run_survey(model2d, cfg, opts);
+  const auto stacked = rtm3d::run_survey(model3d, cfg, opts);
+  EXPECT_EQ(stacked.shots, 3u);
+  EXPECT_EQ(stacked.stack.inline_xz, reference.stack.inline_xz);
+
+  EXPECT_THROW((void)rtm3d::run_single_shot_rtm(model3d.read_window(0, 40, 0, 5), 10.0f, 10.0f, cfg),
+               std::runtime_error);  // 5 rows, cfg.ny = 8
+  remove_model(path);
+}
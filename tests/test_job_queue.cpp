@@ -0,0 +1,275 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/JobQueue.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+#include "TestModels.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+using rtm3d::test::survey_options;
+
+rtm3d::JobOptions fresh_job(const std::string& name) {
+  const auto dir = fs::temp_directory_path() / ("rtm3d_job_" + name + "_" + std::to_string(getpid()));
+  fs::remove_all(dir);
+  rtm3d::JobOptions job;
+  job.dir = dir.string();
+  return job;
+}
+
+template <typename Work>
+pid_t spawn(Work&& work) {
+  const pid_t pid = fork();
+  if (pid == 0) {
+    try {
+      work();
+    } catch (...) {
+      _exit(1);
+    }
+    _exit(0);
+  }
+  return pid;
+}
+
+bool exited_cleanly(pid_t pid) {
+  int status = 0;
+  return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+}  // namespace
+
+TEST(JobQueue, WorkerProcessesReduceToTheSurveyStack) {
+  const auto model = layered_model(40, 20);
+  const auto cfg = small_cfg();
+  auto survey = survey_options(6);
+  survey.aperture = 80.0f;
+  const auto reference = rtm3d::run_survey(model, cfg, survey);
+
+  auto job = fresh_job("workers");
+  rtm3d::init_job_dir(model, cfg, survey, job);
+  std::vector<pid_t> workers;
+  for (int w = 0; w < 3; ++w) {
+    workers.push_back(spawn([&, w] {
+      auto mine = job;
+      mine.worker_id = "worker" + std::to_string(w);
+      rtm3d::run_job_worker(model, cfg, survey, mine);
+    }));
+  }
+  for (const auto pid : workers) EXPECT_TRUE(exited_cleanly(pid));
+
+  const auto status = rtm3d::job_status(job);
+  EXPECT_EQ(status.shots, 6u);
+  EXPECT_EQ(status.done, 6u);
+  EXPECT_EQ(status.leased + status.expired + status.pending(), 0u);
+  const auto reduced = rtm3d::reduce_job(model, cfg, survey, job);
+  EXPECT_EQ(reduced.shots, 6u);
+  EXPECT_EQ(reduced.stack.inline_xz, reference.stack.inline_xz);
+  fs::remove_all(job.dir);
+}
+
+TEST(JobQueue, ShotOfKilledWorkerIsTakenOverAfterItsLeaseExpires) {
+  const auto model = layered_model(24, 20);
+  auto cfg = small_cfg();
+  cfg.nt = 300;
+  const auto survey = survey_options(2);
+  auto job = fresh_job("killed");
+  job.lease_seconds = 1.0;
+  rtm3d::init_job_dir(model, cfg, survey, job);
+
+  const pid_t victim = spawn([&] { rtm3d::run_job_worker(model, cfg, survey, job); });
+  const auto lease = fs::path(job.dir) / "leases" / "shot_000000.lease";
+  while (!fs::exists(lease) && waitpid(victim, nullptr, WNOHANG) == 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  const bool killed = kill(victim, SIGKILL) == 0;
+  waitpid(victim, nullptr, 0);
+
+  if (killed && !fs::exists(fs::path(job.dir) / "partials" / "shot_000000.bin")) {
+    EXPECT_EQ(rtm3d::job_status(job).leased, 1u);  // still inside its lease
+    std::this_thread::sleep_for(std::chrono::milliseconds(1300));
+    EXPECT_EQ(rtm3d::job_status(job).expired, 1u);
+  }
+  const auto done = rtm3d::job_status(job).done;
+  EXPECT_EQ(rtm3d::run_job_worker(model, cfg, survey, job), 2u - done);
+  EXPECT_EQ(rtm3d::job_status(job).done, 2u);
+  EXPECT_EQ(rtm3d::reduce_job(model, cfg, survey, job).stack.inline_xz,
+            rtm3d::run_survey(model, cfg, survey).stack.inline_xz);
+  fs::remove_all(job.dir);
+}
+
+TEST(JobQueue, RequeueRemovesOnlyExpiredLeases) {
+  const auto model = layered_model(24, 20);
+  const auto cfg = small_cfg();
+  const auto survey = survey_options(3);
+  auto job = fresh_job("requeue");
+  job.lease_seconds = 5.0;
+  rtm3d::init_job_dir(model, cfg, survey, job);
+
+  const auto stale = fs::path(job.dir) / "leases" / "shot_000000.lease";
+  const auto live = fs::path(job.dir) / "leases" / "shot_000001.lease";
+  std::ofstream(stale) << "dead:1\n";
+  std::ofstream(live) << "alive:2\n";
+  fs::last_write_time(stale, fs::file_time_type::clock::now() - std::chrono::seconds(60));
+
+  auto status = rtm3d::job_status(job);
+  EXPECT_EQ(status.expired, 1u);
+  EXPECT_EQ(status.leased, 1u);
+  EXPECT_EQ(status.pending(), 1u);
+  EXPECT_EQ(rtm3d::requeue_expired_leases(job), 1u);
+  EXPECT_FALSE(fs::exists(stale));
+  EXPECT_TRUE(fs::exists(live));
+  status = rtm3d::job_status(job);
+  EXPECT_EQ(status.expired, 0u);
+  EXPECT_EQ(status.pending(), 2u);
+
+  // A worker limited to one shot takes the first free one and leaves the live lease alone.
+  job.max_shots = 1;
+  EXPECT_EQ(rtm3d::run_job_worker(model, cfg, survey, job), 1u);
+  EXPECT_TRUE(fs::exists(fs::path(job.dir) / "partials" / "shot_000000.bin"));
+  EXPECT_EQ(rtm3d::job_status(job).done, 1u);
+  fs::remove_all(job.dir);
+}
+
+TEST(JobQueue, RefusesMixedSurveysAndIncompleteReduce) {
+  const auto model = layered_model(24, 20);
+  const auto cfg = small_cfg();
+  auto job = fresh_job("mixed");
+  rtm3d::init_job_dir(model, cfg, survey_options(2), job);
+  EXPECT_NO_THROW(rtm3d::init_job_dir(model, cfg, survey_options(2), job));
+  EXPECT_THROW(rtm3d::init_job_dir(model, cfg, survey_options(3), job), std::runtime_error);
+  EXPECT_THROW(rtm3d::run_job_worker(model, cfg, survey_options(3), job), std::runtime_error);
+  EXPECT_THROW(rtm3d::reduce_job(model, cfg, survey_options(2), job), std::runtime_error);  // no partials yet
+  EXPECT_THROW(rtm3d::init_job_dir(model, cfg, survey_options(2, job.dir), job), std::runtime_error);
+  fs::remove_all(job.dir);
+}
+
+TEST(JobQueue, WorkersUseTheSnapshotStrategyOfTheJob) {
+  const auto model = layered_model(24, 20);
+  const auto survey = survey_options(2);
+  auto job = fresh_job("strategy");
+  // Nothing fits a 1-byte budget, so the job records the smallest strategy rather than full.
+  auto planner = small_cfg(rtm3d::SnapshotStrategy::kAuto);
+  planner.max_memory_bytes = 1;
+  rtm3d::init_job_dir(model, planner, survey, job);
+  std::ifstream f(job.dir + "/job.json");
+  std::stringstream text;
+  text << f.rdbuf();
+  const auto planned = rtm3d::select_snapshot_strategy(model, planner).chosen;
+  ASSERT_NE(planned, rtm3d::SnapshotStrategy::kFull);
+  EXPECT_NE(text.str().find(std::string("\"snapshot_strategy\": \"") + rtm3d::snapshot_strategy_name(planned)),
+            std::string::npos);
+
+  // A worker with another budget would pick full on its own; it runs the job's strategy instead.
+  const auto worker = small_cfg(rtm3d::SnapshotStrategy::kAuto);
+  EXPECT_EQ(rtm3d::job_config(worker, job).snapshot_strategy, planned);
+  EXPECT_NO_THROW(rtm3d::init_job_dir(model, worker, survey, job));
+  EXPECT_EQ(rtm3d::run_job_worker(model, worker, survey, job), 2u);
+  EXPECT_EQ(rtm3d::reduce_job(model, worker, survey, job).stack.inline_xz,
+            rtm3d::run_survey(model, small_cfg(planned), survey).stack.inline_xz);
+
+  const auto forced = small_cfg(rtm3d::SnapshotStrategy::kFull);
+  EXPECT_THROW(rtm3d::job_config(forced, job), std::runtime_error);
+  EXPECT_THROW(rtm3d::run_job_worker(model, forced, survey, job), std::runtime_error);
+  EXPECT_THROW(rtm3d::reduce_job(model, forced, survey, job), std::runtime_error);
+  fs::remove_all(job.dir);
+}
+
+TEST(JobQueue, CoordinatorRestartsFailedWorkersAndRequeuesTheirShots) {
+  const auto model = layered_model(40, 20);
+  const auto cfg = small_cfg();
+  auto survey = survey_options(4);
+  survey.aperture = 80.0f;
+  auto job = fresh_job("coordinate");
+  job.lease_seconds = 1.0;
+  rtm3d::init_job_dir(model, cfg, survey, job);
+
+  // The first worker dies holding shot 0's lease; the others migrate the rest, and once the lease
+  // expires the coordinator re-queues it or a worker takes it over.
+  int spawned = 0;
+  const auto spawn_worker = [&] {
+    if (spawned++ == 0) {
+      return spawn([&] {
+        std::ofstream(fs::path(job.dir) / "leases" / "shot_000000.lease") << "doomed:1\n";
+        _exit(3);
+      });
+    }
+    return spawn([&] { rtm3d::run_job_worker(model, cfg, survey, job); });
+  };
+  std::ostringstream log;
+  const auto run = rtm3d::run_job_coordinator(model, cfg, survey, job, 2, spawn_worker, log);
+  EXPECT_EQ(run.restarts, 1u);
+  EXPECT_NE(log.str().find("worker"), std::string::npos);
+  EXPECT_EQ(rtm3d::job_status(job).done, 4u);
+  EXPECT_EQ(run.survey.stack.inline_xz, rtm3d::run_survey(model, cfg, survey).stack.inline_xz);
+  fs::remove_all(job.dir);
+}
+
+TEST(JobQueue, ExpiredLeaseIsTakenOverByOneWorker) {
+  const auto model = layered_model(24, 20);
+  const auto cfg = small_cfg();
+  const auto survey = survey_options(1);
+  auto job = fresh_job("takeover");
+  job.lease_seconds = 5.0;
+  rtm3d::init_job_dir(model, cfg, survey, job);
+  const auto lease = fs::path(job.dir) / "leases" / "shot_000000.lease";
+  std::ofstream(lease) << "dead:1\n";
+  fs::last_write_time(lease, fs::file_time_type::clock::now() - std::chrono::seconds(60));
+
+  // Racers released together: the one that breaks the expired lease claims the shot at once, as a
+  // worker would, and no other may break that claim.
+  const auto go = fs::path(job.dir) / "go";
+  std::vector<pid_t> racers;
+  for (int w = 0; w < 8; ++w) {
+    racers.push_back(spawn([&, w] {
+      while (!fs::exists(go)) std::this_thread::yield();
+      if (rtm3d::requeue_expired_leases(job) == 0) return;
+      std::ofstream(lease) << "racer" << w << "\n";
+      std::ofstream(job.dir + "/won_" + std::to_string(w));
+    }));
+  }
+  std::ofstream{go};
+  for (const auto pid : racers) EXPECT_TRUE(exited_cleanly(pid));
+  std::size_t winners = 0;
+  for (const auto& e : fs::directory_iterator(job.dir)) winners += e.path().filename().string().rfind("won_", 0) == 0;
+  EXPECT_EQ(winners, 1u);
+  EXPECT_TRUE(fs::exists(lease));
+  fs::remove_all(job.dir);
+}
+
+TEST(CliOptions, ParsesJobModes) {
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--mode", "coordinate", "--job-dir", "jobs/a",
+                        "--workers", "4", "--lease-seconds", "2.5"};
+  const auto o = rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv));
+  EXPECT_EQ(o.mode, rtm3d::RunMode::kCoordinate);
+  EXPECT_EQ(o.job.dir, "jobs/a");
+  EXPECT_EQ(o.workers, 4u);
+  EXPECT_DOUBLE_EQ(o.job.lease_seconds, 2.5);
+
+  const char* no_dir[] = {"rtm3d_cli", "--data-dir", "data", "--mode", "worker"};
+  EXPECT_THROW((void)rtm3d::parse_cli_or_throw(static_cast<int>(std::size(no_dir)), const_cast<char**>(no_dir)),
+               std::runtime_error);
+  const char* checkpoint[] = {"rtm3d_cli", "--data-dir", "data", "--mode", "reduce", "--job-dir", "j",
+                              "--checkpoint-dir", "c"};
+  EXPECT_THROW(
+      (void)rtm3d::parse_cli_or_throw(static_cast<int>(std::size(checkpoint)), const_cast<char**>(checkpoint)),
+      std::runtime_error);
+}
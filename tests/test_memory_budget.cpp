@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::correlation;
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+
+std::vector<float> image_with(rtm3d::SnapshotStrategy strategy, std::size_t stride = 0) {
+  auto cfg = small_cfg(strategy);
+  cfg.snapshot_stride = stride;
+  cfg.checkpoint_interval = 7;  // uneven last segment
+  return rtm3d::run_single_shot_rtm(layered_model(20, 18), cfg).inline_xz;
+}
+
+}  // namespace
+
+TEST(MemoryBudget, ExactStrategiesMatchFullSnapshots) {
+  const auto full = image_with(rtm3d::SnapshotStrategy::kFull);
+  EXPECT_EQ(image_with(rtm3d::SnapshotStrategy::kCheckpointed), full);
+  EXPECT_EQ(image_with(rtm3d::SnapshotStrategy::kSpill), full);
+}
+
+TEST(MemoryBudget, LossyStrategiesStayCloseToFullSnapshots) {
+  const auto full = image_with(rtm3d::SnapshotStrategy::kFull);
+  const auto compressed = image_with(rtm3d::SnapshotStrategy::kCompressed);
+  const float max_abs = std::abs(*std::max_element(full.begin(), full.end(), [](float a, float b) {
+    return std::abs(a) < std::abs(b);
+  }));
+  for (std::size_t i = 0; i < full.size(); ++i) EXPECT_NEAR(compressed[i], full[i], 1e-3f * max_abs);
+
+  const auto subsampled = image_with(rtm3d::SnapshotStrategy::kSubsampled, 2);
+  EXPECT_GT(correlation(subsampled, full), 0.95);
+}
+
+TEST(MemoryBudget, PicksCheapestStrategyThatFits) {
+  const auto model = layered_model(20, 18);
+  auto cfg = small_cfg(rtm3d::SnapshotStrategy::kAuto);
+
+  cfg.max_memory_bytes = std::size_t{1} << 40;
+  EXPECT_EQ(rtm3d::select_snapshot_strategy(model, cfg).chosen, rtm3d::SnapshotStrategy::kFull);
+
+  const auto estimates = rtm3d::estimate_snapshot_strategies(model, cfg);
+  const auto ram = [&](rtm3d::SnapshotStrategy s) {
+    return std::find_if(estimates.begin(), estimates.end(), [&](const auto& e) { return e.strategy == s; })->ram_bytes;
+  };
+  EXPECT_LT(ram(rtm3d::SnapshotStrategy::kCheckpointed), ram(rtm3d::SnapshotStrategy::kFull));
+  EXPECT_LT(ram(rtm3d::SnapshotStrategy::kSpill), ram(rtm3d::SnapshotStrategy::kCheckpointed));
+
+  cfg.max_memory_bytes = ram(rtm3d::SnapshotStrategy::kFull) - 1;
+  const auto tight = rtm3d::select_snapshot_strategy(model, cfg);
+  EXPECT_NE(tight.chosen, rtm3d::SnapshotStrategy::kFull);
+  EXPECT_TRUE(tight.fits);
+
+  cfg.max_memory_bytes = 1;
+  const auto none = rtm3d::select_snapshot_strategy(model, cfg);
+  EXPECT_FALSE(none.fits);
+  EXPECT_EQ(none.chosen, rtm3d::SnapshotStrategy::kSpill);
+
+  cfg.snapshot_strategy = rtm3d::SnapshotStrategy::kCompressed;
+  EXPECT_EQ(rtm3d::select_snapshot_strategy(model, cfg).chosen, rtm3d::SnapshotStrategy::kCompressed);
+}
+
+TEST(MemoryBudget, ParsesMemoryFlags) {
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--snapshot-strategy", "checkpointed",
+                        "--max-memory", "512M", "--checkpoint-interval", "12"};
+  const auto o = rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv));
+  EXPECT_EQ(o.rtm.snapshot_strategy, rtm3d::SnapshotStrategy::kCheckpointed);
+  EXPECT_EQ(o.rtm.max_memory_bytes, std::size_t{512} << 20);
+  EXPECT_EQ(o.rtm.checkpoint_interval, 12u);
+
+  const char* bad[] = {"rtm3d_cli", "--data-dir", "data", "--snapshot-strategy", "zip"};
+  EXPECT_THROW(rtm3d::parse_cli_or_throw(static_cast<int>(std::size(bad)), const_cast<char**>(bad)),
+               std::runtime_error);
+}
@@ -0,0 +1,135 @@
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/io/GatherIO.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+using rtm3d::test::survey_options;
+
+std::vector<rtm3d::ShotGather> model_all(const rtm3d::GridModel2D& model, const rtm3d::RtmConfig& cfg,
+                                         const rtm3d::SurveyOptions& opts) {
+  std::vector<rtm3d::ShotGather> gathers(opts.shots);
+  std::mutex mu;
+  rtm3d::model_survey(model, cfg, opts, [&](std::size_t shot, const rtm3d::ShotGather& g) {
+    const std::lock_guard<std::mutex> lock(mu);
+    gathers.at(shot) = g;
+  });
+  return gathers;
+}
+
+std::uint32_t read_be32(const std::string& bytes, std::size_t offset) {
+  std::uint32_t v = 0;
+  for (std::size_t i = 0; i < 4; ++i) v = (v << 8) | static_cast<unsigned char>(bytes[offset + i]);
+  return v;
+}
+
+}  // namespace
+
+TEST(ForwardModeling, RecordsGatherAtReceivers) {
+  const auto model = layered_model(40, 20);
+  auto cfg = small_cfg();
+  cfg.nt = 120;
+  const auto g = rtm3d::run_forward_modeling(model, cfg);
+
+  ASSERT_EQ(g.receiver_x.size(), 13u);
+  ASSERT_EQ(g.traces.size(), g.receiver_x.size() * cfg.nt);
+  EXPECT_FLOAT_EQ(g.shot_x, 200.0f);
+  EXPECT_FLOAT_EQ(g.shot_z, 20.0f);
+  EXPECT_FLOAT_EQ(g.receiver_x[1] - g.receiver_x[0], 30.0f);
+
+  // The direct wave peaks earlier on the trace next to the source than on the outermost one.
+  const auto peak_sample = [&](std::size_t tr) {
+    std::size_t best = 0;
+    for (std::size_t it = 0; it < cfg.nt; ++it) {
+      if (std::abs(g.traces[tr * cfg.nt + it]) > std::abs(g.traces[tr * cfg.nt + best])) best = it;
+    }
+    return best;
+  };
+  EXPECT_GT(std::abs(g.traces[6 * cfg.nt + peak_sample(6)]), 0.0f);
+  EXPECT_LT(peak_sample(6), peak_sample(0));
+}
+
+TEST(ForwardModeling, ConcurrentShotsMatchSequentialShots) {
+  const auto model = layered_model(60, 20);
+  auto cfg = small_cfg();
+  cfg.nt = 120;
+  auto opts = survey_options(4);
+  opts.aperture = 120.0f;
+  cfg.threads = 1;
+  const auto sequential = model_all(model, cfg, opts);
+  cfg.threads = 3;
+  const auto concurrent = model_all(model, cfg, opts);
+
+  const auto columns = rtm3d::survey_shot_columns(model, opts);
+  for (std::size_t k = 0; k < opts.shots; ++k) {
+    EXPECT_FLOAT_EQ(sequential[k].shot_x, static_cast<float>(columns[k]) * model.dx);
+    EXPECT_EQ(sequential[k].receiver_x, concurrent[k].receiver_x);
+    EXPECT_EQ(sequential[k].traces, concurrent[k].traces);
+  }
+}
+
+TEST(GatherIO, WritesFloat32WithSchemaAndSegyLike) {
+  rtm3d::ShotGather g{.shot_x = 200.0f, .shot_z = 20.0f, .receiver_x = {10.0f, 40.0f, 70.0f},
+                      .receiver_z = 20.0f, .nt = 5, .dt = 0.001f, .traces = std::vector<float>(15)};
+  for (std::size_t i = 0; i < g.traces.size(); ++i) g.traces[i] = 0.5f * static_cast<float>(i);
+
+  const auto dir = std::filesystem::temp_directory_path() / ("rtm3d_gathers_" + std::to_string(getpid()));
+  std::filesystem::create_directories(dir);
+  const auto bin = (dir / "shot_0001_gather.bin").string();
+  const auto segy = (dir / "shot_0001.segy_like").string();
+  rtm3d::write_gather_float32(bin, g);
+  rtm3d::write_segy_like(segy, g);
+
+  EXPECT_EQ(std::filesystem::file_size(bin), g.traces.size() * sizeof(float));
+  std::ifstream h(bin + ".json");
+  const std::string header((std::istreambuf_iterator<char>(h)), std::istreambuf_iterator<char>());
+  for (const char* key : {"\"n_receivers\": 3", "\"nt\": 5", "\"dt\": 0.001", "\"shot_x\": 200", "\"shot_z\": 20",
+                          "\"receiver_x0\": 10", "\"receiver_dx\": 30", "\"dtype\": \"float32\"",
+                          "\"order\": \"row-major [n_receivers][nt]\"", "\"units\""}) {
+    EXPECT_NE(header.find(key), std::string::npos) << key;
+  }
+
+  ASSERT_EQ(std::filesystem::file_size(segy), 3600u + 3u * (240u + 5u * 4u));
+  std::ifstream f(segy, std::ios::binary);
+  const std::string bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(bytes.rfind("C01 RTM3D SYNTHETIC SEG-Y-LIKE FILE", 0), 0u);
+  const std::size_t trace1 = 3600 + 240 + 5 * 4;  // second trace header
+  EXPECT_EQ(read_be32(bytes, trace1 + 0), 2u);
+  EXPECT_EQ(read_be32(bytes, trace1 + 36), 200u);
+  EXPECT_EQ(read_be32(bytes, trace1 + 40), 40u);
+  const std::uint32_t bits = read_be32(bytes, trace1 + 240 + 4);  // trace 1, sample 1
+  float sample = 0.0f;
+  std::memcpy(&sample, &bits, sizeof(sample));
+  EXPECT_FLOAT_EQ(sample, g.traces[1 * 5 + 1]);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CliOptions, ParsesModelMode) {
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--mode", "model", "--shots", "8", "--gather-dir", "out/g"};
+  const auto o = rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv));
+  EXPECT_EQ(o.mode, rtm3d::RunMode::kModel);
+  EXPECT_EQ(o.survey.shots, 8u);
+  EXPECT_EQ(o.gather_dir, "out/g");
+
+  const char* bad[] = {"rtm3d_cli", "--data-dir", "data", "--mode", "model", "--ranks", "2"};
+  EXPECT_THROW((void)rtm3d::parse_cli_or_throw(static_cast<int>(std::size(bad)), const_cast<char**>(bad)),
+               std::runtime_error);
+}
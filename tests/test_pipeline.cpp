@@ -0,0 +1,168 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "rtm/Pipeline.hpp"
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/RunProfile.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+
+}  // namespace
+
+TEST(BoundedQueue, BlocksProducerAtCapacityAndDrainsAfterClose) {
+  rtm3d::rtm_internal::BoundedQueue<int> q(2);
+  std::atomic<int> pushed{0};
+  std::thread producer([&] {
+    for (int i = 0; i < 5; ++i) {
+      ASSERT_TRUE(q.push(i));
+      ++pushed;
+    }
+    q.close();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pushed.load(), 2);  // the third push waits for a pop
+  for (int i = 0; i < 5; ++i) {
+    const auto v = q.pop();
+    ASSERT_TRUE(v.has_value());
+    EXPECT_EQ(*v, i);
+  }
+  producer.join();
+  EXPECT_FALSE(q.pop().has_value());
+  EXPECT_FALSE(q.push(7));
+}
+
+TEST(BoundedQueue, CancelDropsQueuedItems) {
+  rtm3d::rtm_internal::BoundedQueue<int> q(4);
+  ASSERT_TRUE(q.push(1));
+  ASSERT_TRUE(q.push(2));
+  q.cancel();
+  EXPECT_FALSE(q.pop().has_value());
+  EXPECT_FALSE(q.push(3));
+}
+
+TEST(SurveyPipeline, FailedStageStopsMigration) {
+  // Prepare queues four jobs and then fails while the first one is migrating; the queued jobs
+  // must not be migrated after that.
+  std::atomic<bool> migrating{false}, prepare_failed{false};
+  std::atomic<int> migrated{0};
+  rtm3d::rtm_internal::StageClock prepare_clock("prepare"), migrate_clock("migrate"), stack_clock("stack");
+  const auto prepare = [&](std::size_t k) {
+    if (k == 4) {
+      while (!migrating) std::this_thread::yield();
+      prepare_failed = true;
+      throw std::runtime_error("prepare failed");
+    }
+    return k;
+  };
+  const auto migrate = [&](std::size_t& k) {
+    migrating = true;
+    while (!prepare_failed) std::this_thread::yield();
+    ++migrated;
+    return k;
+  };
+  EXPECT_THROW(rtm3d::rtm_internal::run_stages(8, std::vector<bool>(8, false), 4, true, prepare, migrate,
+                                               [](std::size_t) {}, prepare_clock, migrate_clock, stack_clock),
+               std::runtime_error);
+  EXPECT_EQ(migrated.load(), 1);
+}
+
+TEST(SurveyPipeline, QueueDepthDoesNotChangeTheStack) {
+  const auto model = layered_model(40, 20);
+  const auto cfg = small_cfg();
+  rtm3d::SurveyOptions opts;
+  opts.shots = 4;
+  opts.aperture = 80.0f;
+  opts.queue_depth = 1;
+  const auto shallow = rtm3d::run_survey(model, cfg, opts);
+  opts.queue_depth = 4;
+  rtm3d::RunProfile profile;
+  const auto deep = rtm3d::run_survey(model, cfg, opts, &profile);
+  EXPECT_EQ(deep.stack.inline_xz, shallow.stack.inline_xz);
+
+  ASSERT_EQ(profile.stages().size(), 3u);
+  for (const auto& stage : profile.stages()) {
+    EXPECT_EQ(stage.items, opts.shots) << stage.name;
+    EXPECT_GT(stage.wall_seconds, 0.0);
+    EXPECT_GE(stage.utilization(), 0.0);
+    EXPECT_LE(stage.utilization(), 1.0);
+  }
+  EXPECT_EQ(profile.stages()[1].name, "migrate");
+  EXPECT_GT(profile.stages()[1].utilization(), profile.stages()[0].utilization());
+  EXPECT_NE(rtm3d::format_run_profile(profile).find("stage migrate"), std::string::npos);
+}
+
+TEST(SurveyPipeline, PrepareStageBuildsEachShotSetup) {
+  rtm3d::SurveyOptions opts;
+  opts.shots = 3;
+  opts.aperture = 80.0f;
+  rtm3d::RunProfile profile;
+  rtm3d::run_survey(layered_model(40, 20), small_cfg(), opts, &profile);
+  std::size_t volumes = 0, damps = 0;
+  for (const auto& p : profile.phases()) {
+    if (p.name == "velocity_volume") volumes = p.calls;
+    if (p.name == "damp") damps = p.calls;
+  }
+  EXPECT_EQ(volumes, opts.shots);
+  EXPECT_EQ(damps, opts.shots);
+  ASSERT_EQ(profile.stages().size(), 3u);
+  EXPECT_GT(profile.stages()[0].busy_seconds, 0.0);
+}
+
+TEST(SurveyPipeline, TimesPeriodicCheckpoints) {
+  const auto dir = std::filesystem::temp_directory_path() / ("rtm3d_pipeline_phase_" + std::to_string(getpid()));
+  std::filesystem::remove_all(dir);
+  const auto opts = rtm3d::test::survey_options(3, dir.string());
+  rtm3d::RunProfile profile;
+  rtm3d::run_survey(layered_model(40, 20), small_cfg(), opts, &profile);
+  std::size_t calls = 0;
+  for (const auto& p : profile.phases()) {
+    if (p.name == "checkpoint") calls = p.calls;
+  }
+  EXPECT_EQ(calls, 1u + opts.shots);  // the ledger check, then one write per shot
+  std::filesystem::remove_all(dir);
+}
+
+TEST(SurveyPipeline, CheckpointsMatchAfterPipelinedRun) {
+  const auto dir = std::filesystem::temp_directory_path() / ("rtm3d_pipeline_" + std::to_string(getpid()));
+  std::filesystem::remove_all(dir);
+  const auto model = layered_model(40, 20);
+  const auto cfg = small_cfg();
+  rtm3d::SurveyOptions opts;
+  opts.shots = 3;
+  opts.checkpoint_dir = dir.string();
+  const auto first = rtm3d::run_survey(model, cfg, opts);
+  opts.resume = true;
+  const auto resumed = rtm3d::run_survey(model, cfg, opts);
+  EXPECT_EQ(resumed.resumed, 3u);
+  EXPECT_EQ(resumed.stack.inline_xz, first.stack.inline_xz);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(SurveyPipeline, MigrationErrorsStopAllStages) {
+  const auto model = layered_model(40, 20);
+  auto cfg = small_cfg();
+  cfg.dt = 0.05f;  // unstable: every shot throws
+  rtm3d::SurveyOptions opts;
+  opts.shots = 6;
+  opts.queue_depth = 1;
+  EXPECT_THROW(rtm3d::run_survey(model, cfg, opts), std::runtime_error);
+
+  opts.queue_depth = 0;
+  EXPECT_THROW(rtm3d::run_survey(model, small_cfg(), opts), std::runtime_error);
+  const char* argv[] = {"rtm3d", "--data-dir", "d", "--queue-depth", "0"};
+  EXPECT_THROW(rtm3d::parse_cli_or_throw(5, const_cast<char**>(argv)), std::runtime_error);
+}
@@ -0,0 +1,191 @@
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rtm/Boundary.hpp"
+#include "rtm/HalfPrecision.hpp"
+#include "rtm/Parallel.hpp"
+#include "rtm/Propagation.hpp"
+#include "rtm/Wavefields.hpp"
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/Precision.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::correlation;
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+
+// Long enough for rounding to accumulate, on the threaded kernels.
+rtm3d::RtmConfig precision_cfg() {
+  auto cfg = small_cfg();
+  cfg.nt = 160;
+  cfg.threads = 2;
+  return cfg;
+}
+
+}  // namespace
+
+TEST(HalfPrecision, Fp16MatchesIeeeRounding) {
+  using rtm3d::rtm_internal::Fp16;
+  EXPECT_EQ(Fp16::encode(1.0f), 0x3c00);
+  EXPECT_EQ(Fp16::encode(-2.0f), 0xc000);
+  EXPECT_EQ(Fp16::encode(65504.0f), 0x7bff);
+  EXPECT_EQ(Fp16::encode(1e9f), 0x7bff);  // saturates instead of overflowing to infinity
+  EXPECT_EQ(Fp16::encode(1.0f + 0x1p-11f), 0x3c00);  // tie rounds to even
+  EXPECT_EQ(Fp16::encode(1.0f + 3 * 0x1p-11f), 0x3c02);
+  EXPECT_EQ(Fp16::encode(0x1p-24f), 0x0001);  // smallest subnormal
+  for (std::uint32_t h = 0; h < 0x7c00u; ++h) {
+    const auto q = static_cast<std::uint16_t>(h);
+    ASSERT_EQ(Fp16::encode(Fp16::decode(q)), q) << h;
+    const auto neg = static_cast<std::uint16_t>(h | 0x8000u);
+    ASSERT_EQ(Fp16::encode(Fp16::decode(neg)), neg) << h;
+  }
+}
+
+TEST(HalfPrecision, Bf16RoundsToNearestEven) {
+  using rtm3d::rtm_internal::Bf16;
+  EXPECT_EQ(Bf16::encode(1.0f), 0x3f80);
+  EXPECT_NEAR(Bf16::decode(Bf16::encode(3.0e-30f)), 3.0e-30f, 3.0e-30f / 128);
+  EXPECT_EQ(Bf16::encode(1.0f + 0x1p-8f), 0x3f80);  // tie rounds to even
+  EXPECT_EQ(Bf16::encode(1.0f + 3 * 0x1p-8f), 0x3f82);
+}
+
+TEST(MixedPrecision, StepMatchesFp32Kernel) {
+  const std::size_t n = 20;
+  rtm3d::Volume3D vel(n, n, n, 2000.0f);
+  const auto damp = rtm3d::rtm_internal::make_damp(n, n, n, 3);
+  std::vector<float> prev(vel.size()), cur(vel.size());
+  for (std::size_t i = 0; i < vel.size(); ++i) {
+    prev[i] = std::sin(0.37f * float(i));
+    cur[i] = std::cos(0.11f * float(i));
+  }
+  rtm3d::rtm_internal::WorkerPool pool(2);
+  rtm3d::rtm_internal::FdPropagator prop(vel, damp, 0.001f, 10.0f, 10.0f, 10.0f, pool);
+  std::vector<float> ref(vel.size(), 0.0f);
+  prop.step(prev, cur, ref);
+
+  for (const auto& [precision, tolerance] : {std::pair{rtm3d::WavefieldPrecision::kFloat16, 2e-3},
+                                            std::pair{rtm3d::WavefieldPrecision::kBFloat16, 1.6e-2}}) {
+    rtm3d::RtmConfig cfg;
+    cfg.dt = 0.001f;
+    cfg.dy = 10.0f;
+    cfg.precision = precision;
+    auto fields = rtm3d::rtm_internal::make_wavefields(cfg, prop, vel, damp, 10.0f, 10.0f, pool);
+    fields->assign(prev, cur);
+    fields->step();
+    const auto& out = fields->current();
+    double diff = 0.0, peak = 0.0;
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+      diff = std::max(diff, double(std::abs(out[i] - ref[i])));
+      peak = std::max(peak, double(std::abs(ref[i])));
+    }
+    EXPECT_LT(diff / peak, tolerance) << rtm3d::wavefield_precision_name(precision);
+  }
+}
+
+TEST(MixedPrecision, ScalingKeepsTinyAmplitudesAboveUnderflow) {
+  // 1e-9 is below fp16's smallest subnormal (6e-8): without per-level scaling it would flush to zero.
+  const std::size_t n = 16;
+  rtm3d::Volume3D vel(n, n, n, 2000.0f);
+  const auto damp = rtm3d::rtm_internal::make_damp(n, n, n, 3);
+  rtm3d::rtm_internal::WorkerPool pool(1);
+  rtm3d::rtm_internal::FdPropagator prop(vel, damp, 0.001f, 10.0f, 10.0f, 10.0f, pool);
+  rtm3d::RtmConfig cfg;
+  cfg.dt = 0.001f;
+  cfg.dy = 10.0f;
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat16;
+  auto fields = rtm3d::rtm_internal::make_wavefields(cfg, prop, vel, damp, 10.0f, 10.0f, pool);
+  const std::size_t centre = vel.index(n / 2, n / 2, n / 2);
+  fields->add(centre, 1e-9f);
+  EXPECT_NEAR(fields->current()[centre], 1e-9f, 1e-12f);
+  for (int i = 0; i < 5; ++i) fields->step();
+  double energy = 0.0;
+  for (const float v : fields->current()) energy += double(v) * v;
+  EXPECT_GT(energy, 0.0);
+
+  // A later large source rescales the level without losing the existing field entirely.
+  fields->add(centre, 1e3f);
+  EXPECT_NEAR(fields->current()[centre], 1e3f, 1.0f);
+}
+
+TEST(MixedPrecision, ImagesMatchFp32Reference) {
+  const auto model = layered_model(40, 30);
+  for (const auto precision : {rtm3d::WavefieldPrecision::kFloat16, rtm3d::WavefieldPrecision::kBFloat16}) {
+    auto cfg = precision_cfg();
+    cfg.precision = precision;
+    const auto report = rtm3d::compare_precision_to_fp32(model, cfg);
+    EXPECT_GT(report.image_correlation, 0.99) << rtm3d::wavefield_precision_name(precision);
+    EXPECT_LT(report.image_relative_l2, 0.1) << rtm3d::wavefield_precision_name(precision);
+    EXPECT_LT(report.gather_relative_l2, 0.1) << rtm3d::wavefield_precision_name(precision);
+  }
+
+  auto cfg = precision_cfg();
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat16;
+  cfg.imaging = rtm3d::ImagingCondition::kFrequencyDomain;
+  cfg.nfreq = 8;
+  const auto fp16 = rtm3d::run_single_shot_rtm(model, cfg);
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat32;
+  const auto fp32 = rtm3d::run_single_shot_rtm(model, cfg);
+  EXPECT_GT(correlation(fp16.inline_xz, fp32.inline_xz), 0.99);
+}
+
+TEST(MixedPrecision, WritesReportJson) {
+  const auto model = layered_model(40, 30);
+  auto cfg = precision_cfg();
+  cfg.precision = rtm3d::WavefieldPrecision::kBFloat16;
+  const auto report = rtm3d::compare_precision_to_fp32(model, cfg);
+  const auto path = (std::filesystem::temp_directory_path() / "rtm3d_precision_report.json").string();
+  rtm3d::write_precision_report_json(path, report);
+  std::ifstream f(path);
+  const std::string text((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  EXPECT_NE(text.find("\"precision\": \"bf16\""), std::string::npos);
+  EXPECT_NE(text.find("\"image_correlation\""), std::string::npos);
+  std::filesystem::remove(path);
+}
+
+TEST(MixedPrecision, RejectsUnsupportedCombinations) {
+  const auto model = layered_model(40, 30);
+  auto cfg = precision_cfg();
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat16;
+  cfg.propagator = rtm3d::PropagatorKind::kPseudoSpectral;
+  EXPECT_THROW(rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+  cfg.propagator = rtm3d::PropagatorKind::kFiniteDifference;
+  cfg.ranks = 2;
+  EXPECT_THROW(rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+  cfg.ranks = 1;
+  cfg.snapshot_strategy = rtm3d::SnapshotStrategy::kCheckpointed;
+  EXPECT_THROW(rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+  for (const auto& e : rtm3d::estimate_snapshot_strategies(model, cfg)) {
+    EXPECT_NE(e.strategy, rtm3d::SnapshotStrategy::kCheckpointed);
+  }
+
+  EXPECT_THROW(rtm3d::parse_wavefield_precision("fp8"), std::runtime_error);
+  const char* argv[] = {"rtm3d", "--data-dir", "d", "--precision", "bf16", "--propagator", "pseudo_spectral"};
+  EXPECT_THROW(rtm3d::parse_cli_or_throw(7, const_cast<char**>(argv)), std::runtime_error);
+  const char* replay[] = {"rtm3d", "--data-dir", "d", "--precision", "fp16", "--snapshot-strategy", "checkpointed"};
+  EXPECT_THROW(rtm3d::parse_cli_or_throw(7, const_cast<char**>(replay)), std::runtime_error);
+  const char* ok[] = {"rtm3d", "--data-dir", "d", "--precision", "fp16", "--precision-report"};
+  const auto cli = rtm3d::parse_cli_or_throw(6, const_cast<char**>(ok));
+  EXPECT_EQ(cli.rtm.precision, rtm3d::WavefieldPrecision::kFloat16);
+  EXPECT_TRUE(cli.precision_report);
+}
+
+TEST(MixedPrecision, SpilledSnapshotsMatchFullSnapshots) {
+  const auto model = layered_model(40, 30);
+  auto cfg = precision_cfg();
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat16;
+  const auto full = rtm3d::run_single_shot_rtm(model, cfg);
+  cfg.snapshot_strategy = rtm3d::SnapshotStrategy::kSpill;
+  EXPECT_EQ(rtm3d::run_single_shot_rtm(model, cfg).inline_xz, full.inline_xz);
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rtm/Fft.hpp"
+#include "rtm/PseudoSpectral.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+namespace {
+
+rtm3d::GridModel2D constant_model(std::size_t nx, std::size_t nz, float v) {
+  return rtm3d::GridModel2D{.nx = nx, .nz = nz, .dx = 10.0f, .dz = 10.0f, .values = std::vector<float>(nx * nz, v)};
+}
+
+}  // namespace
+
+TEST(Fft, MatchesDirectDftForPow2AndBluesteinLengths) {
+  for (const std::size_t n : {8u, 12u, 17u, 50u}) {
+    std::vector<std::complex<float>> x(n);
+    for (std::size_t i = 0; i < n; ++i) x[i] = {std::sin(0.3f * i), std::cos(0.7f * i)};
+
+    const auto& plan = rtm3d::rtm_internal::cached_fft_plan(n);
+    std::vector<std::complex<float>> y = x, scratch(plan.scratch_size());
+    plan.forward(y.data(), scratch.data());
+
+    for (std::size_t k = 0; k < n; ++k) {
+      std::complex<double> ref{0.0, 0.0};
+      for (std::size_t j = 0; j < n; ++j) ref += std::complex<double>(x[j]) * std::polar(1.0, -2.0 * std::numbers::pi * j * k / n);
+      EXPECT_NEAR(y[k].real(), ref.real(), 1e-3) << "n=" << n << " k=" << k;
+      EXPECT_NEAR(y[k].imag(), ref.imag(), 1e-3) << "n=" << n << " k=" << k;
+    }
+
+    plan.inverse(y.data(), scratch.data());
+    for (std::size_t i = 0; i < n; ++i) EXPECT_NEAR(y[i].real() / n, x[i].real(), 1e-4);
+    EXPECT_EQ(&plan, &rtm3d::rtm_internal::cached_fft_plan(n));
+  }
+}
+
+TEST(PseudoSpectral, LaplacianIsExactForBandLimitedField) {
+  const std::size_t nx = 16, ny = 12, nz = 10;
+  const float dx = 5.0f, dy = 8.0f, dz = 4.0f;
+  rtm3d::Volume3D vel(nx, ny, nz, 2000.0f);
+  const std::vector<float> damp(vel.size(), 1.0f);
+  rtm3d::rtm_internal::WorkerPool pool(3);
+  rtm3d::rtm_internal::PseudoSpectralPropagator ps(vel, damp, 0.001f, dx, dy, dz, pool);
+
+  const float kx = 2.0f * std::numbers::pi_v<float> * 3.0f / (nx * dx);
+  const float ky = 2.0f * std::numbers::pi_v<float> * 2.0f / (ny * dy);
+  const float kz = 2.0f * std::numbers::pi_v<float> * 1.0f / (nz * dz);
+  std::vector<float> u(vel.size()), lap(vel.size());
+  for (std::size_t iz = 0; iz < nz; ++iz)
+    for (std::size_t iy = 0; iy < ny; ++iy)
+      for (std::size_t ix = 0; ix < nx; ++ix)
+        u[vel.index(ix, iy, iz)] = std::sin(kx * ix * dx) * std::cos(ky * iy * dy) * std::sin(kz * iz * dz);
+
+  ps.laplacian(u, lap);
+  const float scale = -(kx * kx + ky * ky + kz * kz);
+  for (std::size_t i = 0; i < u.size(); ++i) EXPECT_NEAR(lap[i], scale * u[i], 1e-4f * std::abs(scale));
+}
+
+TEST(PseudoSpectral, SelectableFromConfigAndProducesFiniteImage) {
+  const auto model = constant_model(24, 20, 1800.0f);
+  rtm3d::RtmConfig cfg;
+  cfg.ny = 8;
+  cfg.dy = 10.0f;
+  cfg.dt = 0.001f;
+  cfg.nt = 40;
+  cfg.f0 = 20.0f;
+  cfg.pml = 4;
+  cfg.receiver_stride = 3;
+  cfg.propagator = rtm3d::PropagatorKind::kPseudoSpectral;
+  cfg.threads = 2;
+
+  const auto out = rtm3d::run_single_shot_rtm(model, cfg);
+  double l1 = 0.0;
+  for (float v : out.inline_xz) {
+    ASSERT_TRUE(std::isfinite(v));
+    l1 += std::abs(v);
+  }
+  EXPECT_GT(l1, 0.0);
+}
+
+TEST(PseudoSpectral, ThreadedFiniteDifferenceMatchesSingleThread) {
+  const auto model = constant_model(20, 16, 2000.0f);
+  rtm3d::RtmConfig cfg;
+  cfg.ny = 8;
+  cfg.dy = 10.0f;
+  cfg.dt = 0.001f;
+  cfg.nt = 30;
+  cfg.pml = 3;
+  cfg.receiver_stride = 3;
+  const auto a = rtm3d::run_single_shot_rtm(model, cfg);
+  cfg.threads = 4;
+  const auto b = rtm3d::run_single_shot_rtm(model, cfg);
+  EXPECT_EQ(a.inline_xz, b.inline_xz);
+}
+
+TEST(PseudoSpectral, RejectedWithSlabDecomposition) {
+  const auto model = constant_model(16, 16, 2000.0f);
+  rtm3d::RtmConfig cfg;
+  cfg.ranks = 2;
+  cfg.propagator = rtm3d::PropagatorKind::kPseudoSpectral;
+  EXPECT_THROW((void)rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rtm/Boundary.hpp"
+#include "rtm/Parallel.hpp"
+#include "rtm/Propagation.hpp"
+#include "rtm/SnapshotStore.hpp"
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/MemoryBudget.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+
+#include "TestModels.hpp"
+
+namespace {
+
+using rtm3d::test::layered_model;
+using rtm3d::test::small_cfg;
+
+// A reflector 100 m down, shallow enough that its reflection is imaged before much of what the
+// boundary scatters has come back.
+rtm3d::GridModel2D shallow_reflector(std::size_t nx, std::size_t nz) { return layered_model(nx, nz, 10); }
+
+rtm3d::RtmConfig boundary_cfg(rtm3d::SnapshotStrategy strategy) {
+  auto cfg = small_cfg(strategy);
+  cfg.ny = 16;
+  cfg.nt = 200;
+  cfg.pml = 4;
+  return cfg;
+}
+
+}  // namespace
+
+TEST(RandomBoundary, ReversesTheSourceFieldFromItsLastTwoSteps) {
+  const auto cfg = boundary_cfg(rtm3d::SnapshotStrategy::kFull);
+  rtm3d::Volume3D vel(24, 12, 20, 1500.0f);
+  for (std::size_t i = vel.size() / 2; i < vel.size(); ++i) vel.raw()[i] = 2200.0f;
+  const auto random_vel = rtm3d::rtm_internal::make_random_boundary_velocity(vel, cfg.pml);
+  ASSERT_EQ(random_vel.nz(), vel.nz() + cfg.pml);
+  EXPECT_EQ(random_vel(12, 6, cfg.pml + 2), vel(12, 6, 2));  // source plane outside the shell
+  EXPECT_LT(random_vel(0, 6, 10), vel(0, 6, 10 - cfg.pml));
+
+  const std::vector<float> damp(random_vel.size(), 1.0f);
+  rtm3d::rtm_internal::WorkerPool pool(1);
+  const auto prop = rtm3d::rtm_internal::make_propagator(cfg, random_vel, damp, 10.0f, 10.0f, pool);
+  const auto wavelet = rtm3d::ricker_wavelet(cfg.nt, cfg.dt, cfg.f0);
+  const std::size_t offset = random_vel.size() - vel.size();
+  const std::size_t src = offset + vel.index(12, 6, 2);
+
+  auto rb_cfg = cfg;
+  rb_cfg.snapshot_strategy = rtm3d::SnapshotStrategy::kRandomBoundary;
+  auto reversed = rtm3d::rtm_internal::make_snapshot_store(
+      rb_cfg, vel.size(), {},
+      {.n = random_vel.size(), .offset = offset, .src_index = src, .wavelet = &wavelet,
+       .step = [&](const auto& prev, const auto& cur, auto& nxt) { prop->step(prev, cur, nxt); }});
+  auto full = rtm3d::rtm_internal::make_snapshot_store(cfg, random_vel.size(), {});
+
+  std::vector<float> prev(random_vel.size(), 0.0f), cur(prev), nxt(prev);
+  for (std::size_t it = 0; it < cfg.nt; ++it) {
+    prop->step(prev, cur, nxt);
+    nxt[src] += wavelet[it];
+    prev.swap(cur);
+    cur.swap(nxt);
+    full->store(it, cur);
+    reversed->store(it, cur);
+  }
+  // Roundoff grows slowly while stepping back; compare against the field's peak energy.
+  double max_err = 0.0, max_norm = 0.0;
+  for (std::size_t it = cfg.nt; it-- > 0;) {
+    const float* expected = full->load(it) + offset;
+    const float* got = reversed->load(it);
+    double err = 0.0, norm = 0.0;
+    for (std::size_t i = 0; i < vel.size(); ++i) {
+      err += (got[i] - expected[i]) * (got[i] - expected[i]);
+      norm += expected[i] * expected[i];
+    }
+    max_err = std::max(max_err, err);
+    max_norm = std::max(max_norm, norm);
+  }
+  ASSERT_GT(max_norm, 0.0);
+  EXPECT_LT(std::sqrt(max_err / max_norm), 1e-5);
+}
+
+TEST(RandomBoundary, ImageTracksStoredSnapshots) {
+  const auto model = shallow_reflector(40, 30);
+  const auto full = rtm3d::run_single_shot_rtm(model, boundary_cfg(rtm3d::SnapshotStrategy::kFull)).inline_xz;
+  const auto random =
+      rtm3d::run_single_shot_rtm(model, boundary_cfg(rtm3d::SnapshotStrategy::kRandomBoundary)).inline_xz;
+  ASSERT_EQ(random.size(), full.size());
+
+  // Below the source imprint and inside the side shells, where the reflector is imaged.
+  double ab = 0.0, aa = 0.0, bb = 0.0;
+  for (std::size_t iz = 6; iz < model.nz - 4; ++iz) {
+    for (std::size_t ix = 4; ix < model.nx - 4; ++ix) {
+      const double a = full[iz * model.nx + ix], b = random[iz * model.nx + ix];
+      ab += a * b;
+      aa += a * a;
+      bb += b * b;
+    }
+  }
+  ASSERT_GT(aa, 0.0);
+  EXPECT_GT(ab / std::sqrt(aa * bb), 0.85);
+  EXPECT_NEAR(std::sqrt(bb / aa), 1.0, 0.5);
+}
+
+TEST(RandomBoundary, EstimatedAndValidatedLikeTheOtherStrategies) {
+  const auto model = shallow_reflector(40, 30);
+  auto cfg = boundary_cfg(rtm3d::SnapshotStrategy::kAuto);
+  const auto estimates = rtm3d::estimate_snapshot_strategies(model, cfg);
+  const auto ram = [&](rtm3d::SnapshotStrategy s) {
+    return std::find_if(estimates.begin(), estimates.end(), [&](const auto& e) { return e.strategy == s; })->ram_bytes;
+  };
+  EXPECT_LT(ram(rtm3d::SnapshotStrategy::kRandomBoundary), ram(rtm3d::SnapshotStrategy::kCheckpointed));
+  EXPECT_EQ(rtm3d::parse_snapshot_strategy("random_boundary"), rtm3d::SnapshotStrategy::kRandomBoundary);
+
+  cfg.snapshot_strategy = rtm3d::SnapshotStrategy::kRandomBoundary;
+  cfg.precision = rtm3d::WavefieldPrecision::kBFloat16;
+  EXPECT_FALSE(rtm3d::select_snapshot_strategy(model, cfg).fits);
+  EXPECT_THROW((void)rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+  cfg.precision = rtm3d::WavefieldPrecision::kFloat32;
+  cfg.propagator = rtm3d::PropagatorKind::kPseudoSpectral;
+  EXPECT_THROW((void)rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--snapshot-strategy", "random_boundary",
+                        "--max-dz-ratio", "2"};
+  EXPECT_THROW((void)rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv)),
+               std::runtime_error);
+}
@@ -0,0 +1,79 @@
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/io/GridModelLoader.hpp"
+#include "rtm3d/rtm/RunPlanner.hpp"
+
+namespace {
+
+rtm3d::GridModel2D gradient_model(std::size_t nx, std::size_t nz, float d) {
+  rtm3d::GridModel2D m{.nx = nx, .nz = nz, .dx = d, .dz = d, .values = std::vector<float>(nx * nz)};
+  for (std::size_t iz = 0; iz < nz; ++iz)
+    for (std::size_t ix = 0; ix < nx; ++ix) m.values[iz * nx + ix] = 1500.0f + 2000.0f * static_cast<float>(iz) / (nz - 1);
+  return m;
+}
+
+}  // namespace
+
+TEST(RunPlanner, StabilityLimitMatchesCflFormula) {
+  const float fd = rtm3d::max_stable_dt(rtm3d::PropagatorKind::kFiniteDifference, 3000.0f, 10.0f, 10.0f, 10.0f);
+  EXPECT_NEAR(fd, 10.0f / (3000.0f * std::sqrt(3.0f)), 1e-7f);
+  const float ps = rtm3d::max_stable_dt(rtm3d::PropagatorKind::kPseudoSpectral, 3000.0f, 10.0f, 10.0f, 10.0f);
+  EXPECT_LT(ps, fd);
+}
+
+TEST(RunPlanner, ChoosesCoarsestSamplingAndStableDt) {
+  const auto raw = gradient_model(400, 200, 2.5f);
+  rtm3d::RtmConfig cfg;
+  cfg.f0 = 10.0f;
+  cfg.ny = 11;
+  cfg.dy = 10.0f;
+  const auto plan = rtm3d::plan_run(raw, cfg, {.record_length = 0.5f, .calibrate = false});
+
+  // vmin 1500 / (25 Hz * 10 ppw) = 6 m -> decimate 2.5 m sampling by 2.
+  EXPECT_FLOAT_EQ(plan.max_spacing, 6.0f);
+  EXPECT_EQ(plan.decim_x, 2u);
+  EXPECT_EQ(plan.decim_z, 2u);
+  EXPECT_EQ(plan.nx, 200u);
+  EXPECT_LE(plan.dy, plan.max_spacing);
+  EXPECT_TRUE(plan.meets_ppw);
+  EXPECT_LE(plan.dt, plan.dt_limit);
+  EXPECT_GE(static_cast<float>(plan.nt) * plan.dt, 0.5f - 1e-6f);
+
+  rtm3d::GridLoadOptions load;
+  rtm3d::apply_plan(plan, load, cfg);
+  const auto model = rtm3d::resample_grid_model(raw, load);
+  EXPECT_EQ(model.nx, plan.nx);
+  EXPECT_FLOAT_EQ(model.dx, plan.dx);
+  EXPECT_EQ(cfg.nt, plan.nt);
+}
+
+TEST(RunPlanner, SpectralPlanUsesFewerPoints) {
+  const auto raw = gradient_model(400, 200, 2.5f);
+  rtm3d::RtmConfig cfg;
+  cfg.f0 = 10.0f;
+  const auto fd = rtm3d::plan_run(raw, cfg, {.calibrate = false});
+  cfg.propagator = rtm3d::PropagatorKind::kPseudoSpectral;
+  const auto ps = rtm3d::plan_run(raw, cfg, {.calibrate = false});
+  EXPECT_LT(ps.nx * ps.ny * ps.nz, fd.nx * fd.ny * fd.nz);
+  EXPECT_LT(ps.point_updates, fd.point_updates);
+}
+
+TEST(RunPlanner, EngineRejectsUnstableDt) {
+  const auto model = gradient_model(16, 16, 10.0f);
+  rtm3d::RtmConfig cfg;
+  cfg.ny = 8;
+  cfg.dy = 10.0f;
+  cfg.dt = 0.01f;
+  EXPECT_THROW((void)rtm3d::run_single_shot_rtm(model, cfg), std::runtime_error);
+}
+
+TEST(RunPlanner, ParsesPlanFlags) {
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--auto-plan", "--record-length", "1.2", "--ppw", "6"};
+  const auto o = rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv));
+  EXPECT_EQ(o.plan_mode, rtm3d::PlanMode::kApply);
+  EXPECT_FLOAT_EQ(o.plan.record_length, 1.2f);
+  EXPECT_FLOAT_EQ(o.plan.points_per_wavelength, 6.0f);
+}
@@ -0,0 +1,81 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/RunProfile.hpp"
+
+namespace {
+
+rtm3d::GridModel2D constant_model(std::size_t nx, std::size_t nz) {
+  return {.nx = nx, .nz = nz, .dx = 10.0f, .dz = 10.0f, .values = std::vector<float>(nx * nz, 2000.0f)};
+}
+
+const rtm3d::PhaseStats* find_phase(const rtm3d::RunProfile& p, const std::string& name) {
+  for (const auto& s : p.phases()) {
+    if (s.name == name) return &s;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(RunProfile, AccumulatesScopesPerPhase) {
+  rtm3d::RunProfile p;
+  for (int i = 0; i < 3; ++i) {
+    const auto scope = p.phase("a", 10.0, 40.0);
+  }
+  { const auto scope = p.phase("b"); }
+
+  ASSERT_EQ(p.phases().size(), 2u);
+  EXPECT_EQ(p.phases()[0].name, "a");
+  EXPECT_EQ(p.phases()[0].calls, 3u);
+  EXPECT_DOUBLE_EQ(p.phases()[0].grid_points, 30.0);
+  EXPECT_DOUBLE_EQ(p.phases()[0].bytes, 120.0);
+  EXPECT_GE(p.total_seconds(), 0.0);
+}
+
+TEST(RunProfile, EngineReportsStepAndImagingPhases) {
+  rtm3d::RtmConfig cfg;
+  cfg.ny = 6;
+  cfg.dt = 0.001f;
+  cfg.nt = 12;
+  cfg.pml = 2;
+  cfg.snapshot_strategy = rtm3d::SnapshotStrategy::kFull;
+  const auto model = constant_model(12, 10);
+
+  rtm3d::RunProfile p;
+  rtm3d::run_single_shot_rtm(model, cfg, &p);
+  for (const char* name : {"velocity_volume", "damp", "forward_steps", "backward_steps", "snapshots", "imaging"}) {
+    const auto* s = find_phase(p, name);
+    ASSERT_NE(s, nullptr) << name;
+  }
+  EXPECT_EQ(find_phase(p, "forward_steps")->calls, cfg.nt);
+  EXPECT_DOUBLE_EQ(find_phase(p, "backward_steps")->grid_points, 12.0 * 6 * 10 * cfg.nt);
+
+  const auto path = std::filesystem::temp_directory_path() / "rtm3d_test_report.json";
+  rtm3d::write_run_report_json(path.string(), p, model, cfg);
+  std::ifstream f(path);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  EXPECT_NE(ss.str().find("\"name\": \"forward_steps\""), std::string::npos);
+  EXPECT_NE(ss.str().find("\"grid_points_per_second\""), std::string::npos);
+  EXPECT_NE(ss.str().find("\"hw_counters\": false"), std::string::npos);
+  std::filesystem::remove(path);
+}
+
+TEST(RunProfile, HardwareCountersAreOptional) {
+  rtm3d::RunProfile p(true);
+  { const auto scope = p.phase("work"); }
+  if (!p.hw_counters_available()) GTEST_SKIP() << "perf_event_open unavailable";
+  EXPECT_GT(p.phases()[0].hw.cycles, 0u);
+}
+
+TEST(RunProfile, ParsesReportFlags) {
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--report", "out/r.json", "--perf-counters"};
+  const auto o = rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv));
+  EXPECT_EQ(o.report_file, "out/r.json");
+  EXPECT_TRUE(o.perf_counters);
+}
@@ -0,0 +1,175 @@
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rtm/ShotCache.hpp"
+#include "rtm3d/cli/CliOptions.hpp"
+#include "rtm3d/rtm/RtmEngine.hpp"
+#include "rtm3d/rtm/Survey.hpp"
+
+#include "TestModels.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using rtm3d::test::small_cfg;
+using rtm3d::test::survey_options;
+
+// A dipping interface, so no two shot windows hold the same velocities (identical windows would
+// share a cache entry).
+rtm3d::GridModel2D dipping_model(std::size_t nx, std::size_t nz) {
+  rtm3d::GridModel2D m{.nx = nx, .nz = nz, .dx = 10.0f, .dz = 10.0f, .values = std::vector<float>(nx * nz)};
+  for (std::size_t iz = 0; iz < nz; ++iz) {
+    for (std::size_t ix = 0; ix < nx; ++ix) m.values[iz * nx + ix] = 4 * iz < nz + ix ? 1500.0f : 2200.0f;
+  }
+  return m;
+}
+
+std::string fresh_cache(const std::string& name) {
+  const auto dir = fs::temp_directory_path() / ("rtm3d_cache_" + name + "_" + std::to_string(getpid()));
+  fs::remove_all(dir);
+  return dir.string();
+}
+
+// Three shots at 100, 200 and 300 m on a 500 m line.
+rtm3d::SurveyOptions line(std::size_t shots, const std::string& cache) {
+  auto opts = survey_options(shots);
+  opts.first_shot_x = 100.0f;
+  opts.last_shot_x = 300.0f;
+  opts.aperture = 80.0f;
+  opts.cache_dir = cache;
+  return opts;
+}
+
+}  // namespace
+
+TEST(ShotCache, RerunsStackUnchangedShotsFromTheCache) {
+  const auto model = dipping_model(50, 20);
+  const auto cfg = small_cfg();
+  const auto cache = fresh_cache("rerun");
+
+  const auto reference = rtm3d::run_survey(model, cfg, line(3, ""));
+  const auto first = rtm3d::run_survey(model, cfg, line(3, cache));
+  EXPECT_EQ(first.cache.hits, 0u);
+  EXPECT_EQ(first.cache.misses, 3u);
+  EXPECT_EQ(first.cache.entries, 3u);
+  EXPECT_GT(first.cache.bytes, 3 * 17 * 20 * sizeof(float));
+  EXPECT_EQ(first.stack.inline_xz, reference.stack.inline_xz);
+
+  const auto second = rtm3d::run_survey(model, cfg, line(3, cache));
+  EXPECT_EQ(second.cache.hits, 3u);
+  EXPECT_EQ(second.cache.misses, 0u);
+  EXPECT_EQ(second.stack.inline_xz, reference.stack.inline_xz);
+
+  // Five shots over the same span keep the three old positions; only the new two are migrated.
+  const auto more = rtm3d::run_survey(model, cfg, line(5, cache));
+  EXPECT_EQ(more.cache.hits, 3u);
+  EXPECT_EQ(more.cache.misses, 2u);
+  EXPECT_EQ(more.stack.inline_xz, rtm3d::run_survey(model, cfg, line(5, "")).stack.inline_xz);
+
+  auto changed = cfg;
+  changed.f0 = 18.0f;
+  const auto retuned = rtm3d::run_survey(model, changed, line(3, cache));
+  EXPECT_EQ(retuned.cache.hits, 0u);
+  EXPECT_EQ(retuned.cache.entries, 8u);
+  fs::remove_all(cache);
+}
+
+TEST(ShotCache, DamagedEntriesAreMigratedAgain) {
+  const auto model = dipping_model(50, 20);
+  const auto cfg = small_cfg();
+  const auto cache = fresh_cache("damaged");
+  const auto reference = rtm3d::run_survey(model, cfg, line(2, cache));
+
+  for (const auto& e : fs::directory_iterator(cache)) {
+    fs::resize_file(e.path(), 30);
+    break;
+  }
+  const auto rerun = rtm3d::run_survey(model, cfg, line(2, cache));
+  EXPECT_EQ(rerun.cache.hits, 1u);
+  EXPECT_EQ(rerun.cache.misses, 1u);
+  EXPECT_EQ(rerun.stack.inline_xz, reference.stack.inline_xz);
+  fs::remove_all(cache);
+}
+
+TEST(ShotCache, EvictsLeastRecentlyUsedImagesBeyondTheCap) {
+  const auto model = dipping_model(50, 20);
+  const auto cfg = small_cfg();
+  const auto cache = fresh_cache("evict");
+  const auto entry_bytes = rtm3d::run_survey(model, cfg, line(1, cache)).cache.bytes;
+  fs::remove_all(cache);
+
+  auto opts = line(3, cache);
+  opts.cache_max_bytes = 2 * entry_bytes;
+  const auto capped = rtm3d::run_survey(model, cfg, opts);
+  EXPECT_EQ(capped.cache.misses, 3u);
+  EXPECT_EQ(capped.cache.evicted, 1u);
+  EXPECT_EQ(capped.cache.entries, 2u);
+  EXPECT_LE(capped.cache.bytes, opts.cache_max_bytes);
+
+  const auto rerun = rtm3d::run_survey(model, cfg, opts);
+  EXPECT_EQ(rerun.cache.hits, 2u);
+  EXPECT_EQ(rerun.cache.misses, 1u);
+  EXPECT_EQ(rerun.stack.inline_xz, capped.stack.inline_xz);
+  fs::remove_all(cache);
+}
+
+TEST(ShotCache, ExactSnapshotStrategiesShareEntries) {
+  const auto model = dipping_model(50, 20);
+  const auto key = [&](rtm3d::SnapshotStrategy s) { return rtm3d::rtm_internal::shot_cache_key(model, small_cfg(s)); };
+  const auto full = key(rtm3d::SnapshotStrategy::kFull);
+  EXPECT_EQ(key(rtm3d::SnapshotStrategy::kCheckpointed), full);
+  EXPECT_EQ(key(rtm3d::SnapshotStrategy::kSpill), full);
+  EXPECT_NE(key(rtm3d::SnapshotStrategy::kCompressed), full);
+
+  auto cfg = small_cfg(rtm3d::SnapshotStrategy::kSubsampled);
+  cfg.snapshot_stride = 1;  // every step kept: exact
+  EXPECT_EQ(rtm3d::rtm_internal::shot_cache_key(model, cfg), full);
+  cfg.snapshot_stride = 2;
+  const auto every_other = rtm3d::rtm_internal::shot_cache_key(model, cfg);
+  EXPECT_NE(every_other, full);
+  cfg.snapshot_stride = 3;
+  EXPECT_NE(rtm3d::rtm_internal::shot_cache_key(model, cfg), every_other);
+}
+
+TEST(ShotCache, FailedWritesAreCountedAndTheSurveyGoesOn) {
+  const auto model = dipping_model(50, 20);
+  const auto cfg = small_cfg();
+  const auto cache = fresh_cache("failed");
+  const auto reference = rtm3d::run_survey(model, cfg, line(3, cache));
+
+  // A non-empty directory in place of every entry: lookups miss and the new images cannot be
+  // renamed over it.
+  for (const auto& e : fs::directory_iterator(cache)) {
+    fs::remove(e.path());
+    fs::create_directory(e.path());
+    std::ofstream(e.path() / "blocker");
+  }
+  const auto rerun = rtm3d::run_survey(model, cfg, line(3, cache));
+  EXPECT_EQ(rerun.cache.misses, 3u);
+  EXPECT_EQ(rerun.cache.failed, 3u);
+  EXPECT_FALSE(rerun.cache.error.empty());
+  EXPECT_EQ(rerun.stack.inline_xz, reference.stack.inline_xz);
+  fs::remove_all(cache);
+}
+
+TEST(CliOptions, ParsesShotCacheFlags) {
+  const char* argv[] = {"rtm3d_cli", "--data-dir", "data", "--cache-dir", "cache", "--cache-max", "64M"};
+  const auto o = rtm3d::parse_cli_or_throw(static_cast<int>(std::size(argv)), const_cast<char**>(argv));
+  EXPECT_EQ(o.survey.cache_dir, "cache");
+  EXPECT_EQ(o.survey.cache_max_bytes, std::size_t{64} << 20);
+
+  const char* model_mode[] = {"rtm3d_cli", "--data-dir", "data", "--mode", "model", "--cache-dir", "cache"};
+  EXPECT_THROW(
+      (void)rtm3d::parse_cli_or_throw(static_cast<int>(std::size(model_mode)), const_cast<char**>(model_mode)),
+      std::runtime_error);
+  const char* no_dir[] = {"rtm3d_cli", "--data-dir", "data", "--cache-max", "1G"};
+  EXPECT_THROW((void)rtm3d::parse_cli_or_throw(static_cast<int>(std::size(no_dir)), const_cast<char**>(no_dir)),
+               std::runtime_error);
+}